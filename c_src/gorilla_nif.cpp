@@ -1,20 +1,69 @@
 // Gorilla compression NIF — byte-identical to the Elixir encoder output.
 //
-// Two dirty-CPU NIF functions:
-//   nif_gorilla_encode(data, opts) -> {:ok, binary}
-//   nif_gorilla_decode(data)       -> {:ok, [{int64, float}]}
+// Dirty-CPU NIF functions:
+//   nif_gorilla_encode(data, opts)                 -> {:ok, binary}
+//   nif_gorilla_decode(data)                       -> {:ok, [{int64, float}]}
+//   nif_gorilla_decode_timestamps(data)            -> {:ok, [int64]}
+//   nif_gorilla_decode_values(data)                -> {:ok, [float | nil]}
+//   nif_gorilla_decode_columns(data, opts)         -> {:ok, {ts_bin, val_bin}}
+//   nif_gorilla_decode_columns_batch(chunks, opts) -> {:ok, {ts_bin, val_bin, counts}}
+//   nif_gorilla_transcode(data, opts)              -> {:ok, binary}
+//   nif_gorilla_transcode_batch(chunks, opts)      -> {:ok, [binary]}
+//   nif_gorilla_to_arrow(chunks, opts)             -> {:ok, ipc_binary}
+//   nif_gorilla_from_arrow(ipc, opts)              -> {:ok, [binary]}
+//   nif_gorilla_to_prometheus(data, opts)          -> {:ok, [xor_chunk]}
+//   nif_gorilla_from_prometheus(chunks, opts)      -> {:ok, binary}
+//   nif_gorilla_ingest_line_protocol(text, opts)   -> {:ok, [{series, field, binary}]}
+//   nif_gorilla_ingest_csv(text, opts)             -> {:ok, [{series, field, binary}]}
+//   nif_gorilla_ingest_remote_write(body, opts)    -> {:ok, [{labels, binary}]}
+//
+// Regular NIF functions:
+//   nif_build_info()                               -> {:ok, {isa, [variant], compiler, pgo}}
 
 #include <fine.hpp>
 
 #include <algorithm>
 #include <cmath>
 #include <cstdint>
+#include <cstdlib>
 #include <cstring>
+#include <exception>
+#include <functional>
+#include <limits>
 #include <mutex>
+#include <optional>
 #include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
 #include <variant>
 #include <vector>
 
+#if defined(__SSE2__)
+  #include <emmintrin.h>
+#elif defined(__ARM_NEON)
+  #include <arm_neon.h>
+#endif
+
+// USDT probes (provider `gorilla_stream`) for perf/bpftrace, compiled in
+// when systemtap's sys/sdt.h is available. A disabled probe is a single nop.
+// Build with -DGORILLA_NO_USDT to leave them out.
+#if defined(__linux__) && !defined(GORILLA_NO_USDT) && defined(__has_include)
+  #if __has_include(<sys/sdt.h>)
+    #include <sys/sdt.h>
+    #define GORILLA_USDT 1
+  #endif
+#endif
+
+#if defined(GORILLA_USDT)
+  #define GORILLA_PROBE2(name, a, b)    DTRACE_PROBE2(gorilla_stream, name, a, b)
+  #define GORILLA_PROBE3(name, a, b, c) DTRACE_PROBE3(gorilla_stream, name, a, b, c)
+#else
+  #define GORILLA_PROBE2(name, a, b)    ((void)0)
+  #define GORILLA_PROBE3(name, a, b, c) ((void)0)
+#endif
+
 // ---------------------------------------------------------------------------
 // CRC32 — ISO 3309 lookup table (matches :erlang.crc32/1)
 // ---------------------------------------------------------------------------
@@ -66,6 +115,38 @@ static inline uint64_t byte_swap_64(uint64_t v) {
            ((v & 0xFF00000000000000ULL) >> 56);
 }
 
+// Big-endian 64-bit load from an unaligned address (MSB-first bitstreams).
+static inline uint64_t load_be64(const uint8_t *p) {
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+#if IS_BIG_ENDIAN
+    return v;
+#else
+    return byte_swap_64(v);
+#endif
+}
+
+// Big-endian 32-bit load from an unaligned address.
+static inline uint32_t load_be32(const uint8_t *p) {
+    return (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) | (uint32_t(p[2]) << 8) | p[3];
+}
+
+// Big-endian 32-bit store to an unaligned address.
+static inline void store_be32(uint8_t *p, uint32_t v) {
+    p[0] = static_cast<uint8_t>(v >> 24);
+    p[1] = static_cast<uint8_t>(v >> 16);
+    p[2] = static_cast<uint8_t>(v >> 8);
+    p[3] = static_cast<uint8_t>(v);
+}
+
+// Big-endian 64-bit store to an unaligned address.
+static inline void store_be64(uint8_t *p, uint64_t v) {
+#if !IS_BIG_ENDIAN
+    v = byte_swap_64(v);
+#endif
+    memcpy(p, &v, sizeof(v));
+}
+
 // Convert double to its 64-bit IEEE 754 integer representation.
 // The BitWriter writes MSB-first, matching Elixir's <<value::float-64>>.
 // On big-endian architectures we byte-swap so the XOR bit layout matches
@@ -89,6 +170,431 @@ static inline double bits_to_float(uint64_t bits) {
     return v;
 }
 
+// ---------------------------------------------------------------------------
+// Bit-count helpers
+// ---------------------------------------------------------------------------
+
+static inline int count_leading_zeros_64(uint64_t v) {
+    if (v == 0) return 64;
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_clzll(v);
+#elif defined(_MSC_VER)
+    unsigned long idx;
+    _BitScanReverse64(&idx, v);
+    return 63 - (int)idx;
+#else
+    int n = 0;
+    if (v <= 0x00000000FFFFFFFFULL) { n += 32; v <<= 32; }
+    if (v <= 0x0000FFFFFFFFFFFFULL) { n += 16; v <<= 16; }
+    if (v <= 0x00FFFFFFFFFFFFFFULL) { n += 8;  v <<= 8;  }
+    if (v <= 0x0FFFFFFFFFFFFFFFULL) { n += 4;  v <<= 4;  }
+    if (v <= 0x3FFFFFFFFFFFFFFFULL) { n += 2;  v <<= 2;  }
+    if (v <= 0x7FFFFFFFFFFFFFFFULL) { n += 1; }
+    return n;
+#endif
+}
+
+static inline int count_trailing_zeros_64(uint64_t v) {
+    if (v == 0) return 64;
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_ctzll(v);
+#elif defined(_MSC_VER)
+    unsigned long idx;
+    _BitScanForward64(&idx, v);
+    return (int)idx;
+#else
+    int n = 0;
+    if ((v & 0x00000000FFFFFFFFULL) == 0) { n += 32; v >>= 32; }
+    if ((v & 0x000000000000FFFFULL) == 0) { n += 16; v >>= 16; }
+    if ((v & 0x00000000000000FFULL) == 0) { n += 8;  v >>= 8;  }
+    if ((v & 0x000000000000000FULL) == 0) { n += 4;  v >>= 4;  }
+    if ((v & 0x0000000000000003ULL) == 0) { n += 2;  v >>= 2;  }
+    if ((v & 0x0000000000000001ULL) == 0) { n += 1; }
+    return n;
+#endif
+}
+
+// ---------------------------------------------------------------------------
+// Runtime ISA dispatch
+// ---------------------------------------------------------------------------
+//
+// Precompiled artifacts target the baseline ISA of each platform, so the hot
+// paths (chunk encode and decode, including the checksums) are also built
+// for newer ISA levels through target attributes. `flatten` pulls the whole
+// call tree into each variant so all of it is compiled for that level. The
+// best variant the CPU supports is picked on first use. x86 variants need a
+// compiler that can both target and detect whole ISA levels (GCC 11, Clang
+// 16).
+
+#if defined(__x86_64__) && \
+    (defined(__clang__) ? __clang_major__ >= 16 : (defined(__GNUC__) && __GNUC__ >= 11))
+  #define GORILLA_ISA_VARIANTS(X) \
+      X(x86_64_v2, "arch=x86-64-v2") \
+      X(x86_64_v3, "arch=x86-64-v3") \
+      X(x86_64_v4, "arch=x86-64-v4")
+  #define GORILLA_ISA_X86_LEVELS 1
+#elif defined(__aarch64__) && defined(__linux__) && \
+    (defined(__clang__) ? __clang_major__ >= 16 : (defined(__GNUC__) && __GNUC__ >= 10))
+  #include <sys/auxv.h>
+  #if defined(__clang__)
+    #define GORILLA_ISA_VARIANTS(X) X(sve, "sve")
+  #else
+    #define GORILLA_ISA_VARIANTS(X) X(sve, "+sve")
+  #endif
+#else
+  #define GORILLA_ISA_VARIANTS(X)
+#endif
+
+enum class Isa { baseline, x86_64_v2, x86_64_v3, x86_64_v4, sve };
+
+static const char *isa_name(Isa isa) {
+    switch (isa) {
+    case Isa::x86_64_v2: return "x86-64-v2";
+    case Isa::x86_64_v3: return "x86-64-v3";
+    case Isa::x86_64_v4: return "x86-64-v4";
+    case Isa::sve:       return "aarch64-sve";
+    default:             return "baseline";
+    }
+}
+
+static Isa detect_isa() {
+#if defined(__x86_64__) && defined(GORILLA_ISA_X86_LEVELS)
+    // Whole levels, so a hypervisor masking any one feature of a level
+    // (lzcnt, movbe, f16c, cx16, ...) keeps the CPU off that variant
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("x86-64-v4")) return Isa::x86_64_v4;
+    if (__builtin_cpu_supports("x86-64-v3")) return Isa::x86_64_v3;
+    if (__builtin_cpu_supports("x86-64-v2")) return Isa::x86_64_v2;
+#elif defined(__aarch64__) && defined(__linux__) && defined(HWCAP_SVE)
+    if (getauxval(AT_HWCAP) & HWCAP_SVE) return Isa::sve;
+#endif
+    return Isa::baseline;
+}
+
+// Best level the CPU supports, capped to the variants compiled in.
+static Isa selected_isa() {
+    static const Isa isa = [] {
+        Isa best = detect_isa();
+        Isa chosen = Isa::baseline;
+#define GORILLA_ISA_PICK(tag, arch) \
+        if (static_cast<int>(Isa::tag) <= static_cast<int>(best) && \
+            static_cast<int>(Isa::tag) > static_cast<int>(chosen)) chosen = Isa::tag;
+        GORILLA_ISA_VARIANTS(GORILLA_ISA_PICK)
+#undef GORILLA_ISA_PICK
+        return chosen;
+    }();
+    return isa;
+}
+
+// ---------------------------------------------------------------------------
+// xxHash3 — XXH3_64bits with the default secret and seed 0
+// ---------------------------------------------------------------------------
+//
+// Scalar port of the reference algorithm; chunks written with flag 0x80 carry
+// it in place of CRC32. Matches GorillaStream.Compression.XXH3.hash64/1.
+
+static const uint8_t XXH3_SECRET[192] = {
+    0xb8, 0xfe, 0x6c, 0x39, 0x23, 0xa4, 0x4b, 0xbe, 0x7c, 0x01, 0x81, 0x2c, 0xf7, 0x21, 0xad, 0x1c,
+    0xde, 0xd4, 0x6d, 0xe9, 0x83, 0x90, 0x97, 0xdb, 0x72, 0x40, 0xa4, 0xa4, 0xb7, 0xb3, 0x67, 0x1f,
+    0xcb, 0x79, 0xe6, 0x4e, 0xcc, 0xc0, 0xe5, 0x78, 0x82, 0x5a, 0xd0, 0x7d, 0xcc, 0xff, 0x72, 0x21,
+    0xb8, 0x08, 0x46, 0x74, 0xf7, 0x43, 0x24, 0x8e, 0xe0, 0x35, 0x90, 0xe6, 0x81, 0x3a, 0x26, 0x4c,
+    0x3c, 0x28, 0x52, 0xbb, 0x91, 0xc3, 0x00, 0xcb, 0x88, 0xd0, 0x65, 0x8b, 0x1b, 0x53, 0x2e, 0xa3,
+    0x71, 0x64, 0x48, 0x97, 0xa2, 0x0d, 0xf9, 0x4e, 0x38, 0x19, 0xef, 0x46, 0xa9, 0xde, 0xac, 0xd8,
+    0xa8, 0xfa, 0x76, 0x3f, 0xe3, 0x9c, 0x34, 0x3f, 0xf9, 0xdc, 0xbb, 0xc7, 0xc7, 0x0b, 0x4f, 0x1d,
+    0x8a, 0x51, 0xe0, 0x4b, 0xcd, 0xb4, 0x59, 0x31, 0xc8, 0x9f, 0x7e, 0xc9, 0xd9, 0x78, 0x73, 0x64,
+    0xea, 0xc5, 0xac, 0x83, 0x34, 0xd3, 0xeb, 0xc3, 0xc5, 0x81, 0xa0, 0xff, 0xfa, 0x13, 0x63, 0xeb,
+    0x17, 0x0d, 0xdd, 0x51, 0xb7, 0xf0, 0xda, 0x49, 0xd3, 0x16, 0x55, 0x26, 0x29, 0xd4, 0x68, 0x9e,
+    0x2b, 0x16, 0xbe, 0x58, 0x7d, 0x47, 0xa1, 0xfc, 0x8f, 0xf8, 0xb8, 0xd1, 0x7a, 0xd0, 0x31, 0xce,
+    0x45, 0xcb, 0x3a, 0x8f, 0x95, 0x16, 0x04, 0x28, 0xaf, 0xd7, 0xfb, 0xca, 0xbb, 0x4b, 0x40, 0x7e,
+};
+
+static const uint64_t XXH_PRIME32_1 = 0x9E3779B1ULL;
+static const uint64_t XXH_PRIME32_2 = 0x85EBCA77ULL;
+static const uint64_t XXH_PRIME32_3 = 0xC2B2AE3DULL;
+static const uint64_t XXH_PRIME64_1 = 0x9E3779B185EBCA87ULL;
+static const uint64_t XXH_PRIME64_2 = 0xC2B2AE3D27D4EB4FULL;
+static const uint64_t XXH_PRIME64_3 = 0x165667B19E3779F9ULL;
+static const uint64_t XXH_PRIME64_4 = 0x85EBCA77C2B2AE63ULL;
+static const uint64_t XXH_PRIME64_5 = 0x27D4EB2F165667C5ULL;
+static const uint64_t XXH_PRIME_MX1 = 0x165667919E3779F9ULL;
+static const uint64_t XXH_PRIME_MX2 = 0x9FB21C651E98DF25ULL;
+
+static inline uint64_t xxh_read64(const uint8_t *p) {
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+#if IS_BIG_ENDIAN
+    v = byte_swap_64(v);
+#endif
+    return v;
+}
+
+static inline uint32_t xxh_read32(const uint8_t *p) {
+    return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+           (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+}
+
+static inline uint64_t xxh_rotl64(uint64_t v, int r) {
+    return (v << r) | (v >> (64 - r));
+}
+
+// Low and high halves of the 128-bit product, folded with XOR.
+static inline uint64_t xxh_mul128_fold64(uint64_t a, uint64_t b) {
+#if defined(__SIZEOF_INT128__)
+    __uint128_t p = static_cast<__uint128_t>(a) * b;
+    return static_cast<uint64_t>(p) ^ static_cast<uint64_t>(p >> 64);
+#else
+    uint64_t lo_lo = (a & 0xFFFFFFFF) * (b & 0xFFFFFFFF);
+    uint64_t hi_lo = (a >> 32) * (b & 0xFFFFFFFF);
+    uint64_t lo_hi = (a & 0xFFFFFFFF) * (b >> 32);
+    uint64_t hi_hi = (a >> 32) * (b >> 32);
+    uint64_t cross = (lo_lo >> 32) + (hi_lo & 0xFFFFFFFF) + lo_hi;
+    uint64_t upper = (hi_lo >> 32) + (cross >> 32) + hi_hi;
+    uint64_t lower = (cross << 32) | (lo_lo & 0xFFFFFFFF);
+    return lower ^ upper;
+#endif
+}
+
+static inline uint64_t xxh64_avalanche(uint64_t h) {
+    h ^= h >> 33;
+    h *= XXH_PRIME64_2;
+    h ^= h >> 29;
+    h *= XXH_PRIME64_3;
+    return h ^ (h >> 32);
+}
+
+static inline uint64_t xxh3_avalanche(uint64_t h) {
+    h ^= h >> 37;
+    h *= XXH_PRIME_MX1;
+    return h ^ (h >> 32);
+}
+
+static inline uint64_t xxh3_rrmxmx(uint64_t h, uint64_t len) {
+    h ^= xxh_rotl64(h, 49) ^ xxh_rotl64(h, 24);
+    h *= XXH_PRIME_MX2;
+    h ^= (h >> 35) + len;
+    h *= XXH_PRIME_MX2;
+    return h ^ (h >> 28);
+}
+
+static inline uint64_t xxh3_mix16(const uint8_t *in, const uint8_t *secret) {
+    return xxh_mul128_fold64(xxh_read64(in) ^ xxh_read64(secret),
+                             xxh_read64(in + 8) ^ xxh_read64(secret + 8));
+}
+
+// One 64-byte stripe into the eight accumulators.
+static inline void xxh3_accumulate_512(uint64_t *acc, const uint8_t *in, const uint8_t *secret) {
+    for (int i = 0; i < 8; i++) {
+        uint64_t data = xxh_read64(in + 8 * i);
+        uint64_t key = data ^ xxh_read64(secret + 8 * i);
+        acc[i ^ 1] += data;
+        acc[i] += (key & 0xFFFFFFFF) * (key >> 32);
+    }
+}
+
+static inline void xxh3_scramble(uint64_t *acc, const uint8_t *secret) {
+    for (int i = 0; i < 8; i++) {
+        uint64_t a = acc[i];
+        a ^= a >> 47;
+        a ^= xxh_read64(secret + 8 * i);
+        acc[i] = a * XXH_PRIME32_1;
+    }
+}
+
+// Accumulators of the long-input loop, shared by the 64- and 128-bit hashes.
+static void xxh3_accumulate_long(const uint8_t *in, size_t len, uint64_t *acc) {
+    const uint64_t init[8] = {XXH_PRIME32_3, XXH_PRIME64_1, XXH_PRIME64_2, XXH_PRIME64_3,
+                              XXH_PRIME64_4, XXH_PRIME32_2, XXH_PRIME64_5, XXH_PRIME32_1};
+    memcpy(acc, init, sizeof(init));
+    const size_t secret_size = sizeof(XXH3_SECRET);
+    const size_t stripes_per_block = (secret_size - 64) / 8;
+    const size_t block_len = 64 * stripes_per_block;
+    const size_t blocks = (len - 1) / block_len;
+
+    for (size_t n = 0; n < blocks; n++) {
+        const uint8_t *block = in + n * block_len;
+        for (size_t s = 0; s < stripes_per_block; s++) {
+            xxh3_accumulate_512(acc, block + 64 * s, XXH3_SECRET + 8 * s);
+        }
+        xxh3_scramble(acc, XXH3_SECRET + secret_size - 64);
+    }
+
+    // Last partial block, then the final (possibly overlapping) stripe
+    const uint8_t *tail = in + blocks * block_len;
+    size_t stripes = ((len - 1) - blocks * block_len) / 64;
+    for (size_t s = 0; s < stripes; s++) {
+        xxh3_accumulate_512(acc, tail + 64 * s, XXH3_SECRET + 8 * s);
+    }
+    xxh3_accumulate_512(acc, in + len - 64, XXH3_SECRET + secret_size - 64 - 7);
+}
+
+static uint64_t xxh3_merge_accs(const uint64_t *acc, const uint8_t *secret, uint64_t start) {
+    uint64_t result = start;
+    for (int i = 0; i < 4; i++) {
+        result += xxh_mul128_fold64(acc[2 * i] ^ xxh_read64(secret + 16 * i),
+                                    acc[2 * i + 1] ^ xxh_read64(secret + 8 + 16 * i));
+    }
+    return xxh3_avalanche(result);
+}
+
+static uint64_t xxh3_hash_long(const uint8_t *in, size_t len) {
+    uint64_t acc[8];
+    xxh3_accumulate_long(in, len, acc);
+    return xxh3_merge_accs(acc, XXH3_SECRET + 11, len * XXH_PRIME64_1);
+}
+
+static uint64_t xxh3_64(const uint8_t *in, size_t len) {
+    const uint8_t *secret = XXH3_SECRET;
+
+    if (len == 0) {
+        return xxh64_avalanche(xxh_read64(secret + 56) ^ xxh_read64(secret + 64));
+    }
+    if (len <= 3) {
+        uint32_t combined = (static_cast<uint32_t>(in[0]) << 16) |
+                            (static_cast<uint32_t>(in[len >> 1]) << 24) |
+                            static_cast<uint32_t>(in[len - 1]) |
+                            (static_cast<uint32_t>(len) << 8);
+        uint64_t bitflip = xxh_read32(secret) ^ xxh_read32(secret + 4);
+        return xxh64_avalanche(combined ^ bitflip);
+    }
+    if (len <= 8) {
+        uint64_t input64 = xxh_read32(in + len - 4) +
+                           (static_cast<uint64_t>(xxh_read32(in)) << 32);
+        uint64_t bitflip = xxh_read64(secret + 8) ^ xxh_read64(secret + 16);
+        return xxh3_rrmxmx(input64 ^ bitflip, len);
+    }
+    if (len <= 16) {
+        uint64_t lo = xxh_read64(in) ^ (xxh_read64(secret + 24) ^ xxh_read64(secret + 32));
+        uint64_t hi = xxh_read64(in + len - 8) ^ (xxh_read64(secret + 40) ^ xxh_read64(secret + 48));
+        uint64_t acc = len + byte_swap_64(lo) + hi + xxh_mul128_fold64(lo, hi);
+        return xxh3_avalanche(acc);
+    }
+    if (len <= 128) {
+        uint64_t acc = len * XXH_PRIME64_1;
+        size_t rounds = (len - 1) / 32;
+        for (size_t i = 0; i <= rounds; i++) {
+            acc += xxh3_mix16(in + 16 * i, secret + 32 * i);
+            acc += xxh3_mix16(in + len - 16 * (i + 1), secret + 32 * i + 16);
+        }
+        return xxh3_avalanche(acc);
+    }
+    if (len <= 240) {
+        uint64_t acc = len * XXH_PRIME64_1;
+        for (size_t i = 0; i < 8; i++) {
+            acc += xxh3_mix16(in + 16 * i, secret + 16 * i);
+        }
+        uint64_t acc_end = xxh3_mix16(in + len - 16, secret + 136 - 17);
+        acc = xxh3_avalanche(acc);
+        for (size_t i = 8; i < len / 16; i++) {
+            acc_end += xxh3_mix16(in + 16 * i, secret + 16 * (i - 8) + 3);
+        }
+        return xxh3_avalanche(acc + acc_end);
+    }
+    return xxh3_hash_long(in, len);
+}
+
+// XXH3_128bits with the default secret and seed 0. Content hashes of chunks
+// use it; matches GorillaStream.Compression.XXH3.hash128/1.
+struct Hash128 {
+    uint64_t lo;
+    uint64_t hi;
+};
+
+static inline Hash128 xxh_mul128(uint64_t a, uint64_t b) {
+#if defined(__SIZEOF_INT128__)
+    __uint128_t p = static_cast<__uint128_t>(a) * b;
+    return {static_cast<uint64_t>(p), static_cast<uint64_t>(p >> 64)};
+#else
+    uint64_t lo_lo = (a & 0xFFFFFFFF) * (b & 0xFFFFFFFF);
+    uint64_t hi_lo = (a >> 32) * (b & 0xFFFFFFFF);
+    uint64_t lo_hi = (a & 0xFFFFFFFF) * (b >> 32);
+    uint64_t hi_hi = (a >> 32) * (b >> 32);
+    uint64_t cross = (lo_lo >> 32) + (hi_lo & 0xFFFFFFFF) + lo_hi;
+    uint64_t upper = (hi_lo >> 32) + (cross >> 32) + hi_hi;
+    uint64_t lower = (cross << 32) | (lo_lo & 0xFFFFFFFF);
+    return {lower, upper};
+#endif
+}
+
+static inline void xxh3_mix32(Hash128 &acc, const uint8_t *in1, const uint8_t *in2,
+                              const uint8_t *secret) {
+    acc.lo += xxh3_mix16(in1, secret);
+    acc.lo ^= xxh_read64(in2) + xxh_read64(in2 + 8);
+    acc.hi += xxh3_mix16(in2, secret + 16);
+    acc.hi ^= xxh_read64(in1) + xxh_read64(in1 + 8);
+}
+
+static Hash128 xxh3_128(const uint8_t *in, size_t len) {
+    const uint8_t *secret = XXH3_SECRET;
+
+    if (len == 0) {
+        return {xxh64_avalanche(xxh_read64(secret + 64) ^ xxh_read64(secret + 72)),
+                xxh64_avalanche(xxh_read64(secret + 80) ^ xxh_read64(secret + 88))};
+    }
+    if (len <= 3) {
+        uint32_t combined_lo = (static_cast<uint32_t>(in[0]) << 16) |
+                               (static_cast<uint32_t>(in[len >> 1]) << 24) |
+                               static_cast<uint32_t>(in[len - 1]) |
+                               (static_cast<uint32_t>(len) << 8);
+        uint32_t swapped = static_cast<uint32_t>(byte_swap_64(combined_lo) >> 32);
+        uint32_t combined_hi = (swapped << 13) | (swapped >> 19);
+        uint64_t bitflip_lo = xxh_read32(secret) ^ xxh_read32(secret + 4);
+        uint64_t bitflip_hi = xxh_read32(secret + 8) ^ xxh_read32(secret + 12);
+        return {xxh64_avalanche(combined_lo ^ bitflip_lo),
+                xxh64_avalanche(combined_hi ^ bitflip_hi)};
+    }
+    if (len <= 8) {
+        uint64_t input64 = xxh_read32(in) + (static_cast<uint64_t>(xxh_read32(in + len - 4)) << 32);
+        uint64_t bitflip = xxh_read64(secret + 16) ^ xxh_read64(secret + 24);
+        Hash128 m = xxh_mul128(input64 ^ bitflip, XXH_PRIME64_1 + (len << 2));
+        m.hi += m.lo << 1;
+        m.lo ^= m.hi >> 3;
+        m.lo ^= m.lo >> 35;
+        m.lo *= XXH_PRIME_MX2;
+        m.lo ^= m.lo >> 28;
+        return {m.lo, xxh3_avalanche(m.hi)};
+    }
+    if (len <= 16) {
+        uint64_t bitflip_lo = xxh_read64(secret + 32) ^ xxh_read64(secret + 40);
+        uint64_t bitflip_hi = xxh_read64(secret + 48) ^ xxh_read64(secret + 56);
+        uint64_t input_lo = xxh_read64(in);
+        uint64_t input_hi = xxh_read64(in + len - 8);
+        Hash128 m = xxh_mul128(input_lo ^ input_hi ^ bitflip_lo, XXH_PRIME64_1);
+        m.lo += static_cast<uint64_t>(len - 1) << 54;
+        input_hi ^= bitflip_hi;
+        m.hi += input_hi + (input_hi & 0xFFFFFFFF) * (XXH_PRIME32_2 - 1);
+        m.lo ^= byte_swap_64(m.hi);
+        Hash128 h = xxh_mul128(m.lo, XXH_PRIME64_2);
+        h.hi += m.hi * XXH_PRIME64_2;
+        return {xxh3_avalanche(h.lo), xxh3_avalanche(h.hi)};
+    }
+    if (len <= 240) {
+        Hash128 acc = {len * XXH_PRIME64_1, 0};
+        if (len <= 128) {
+            for (size_t i = (len - 1) / 32 + 1; i-- > 0;) {
+                xxh3_mix32(acc, in + 16 * i, in + len - 16 * (i + 1), secret + 32 * i);
+            }
+        } else {
+            for (size_t i = 0; i < 4; i++) {
+                xxh3_mix32(acc, in + 32 * i, in + 32 * i + 16, secret + 32 * i);
+            }
+            acc.lo = xxh3_avalanche(acc.lo);
+            acc.hi = xxh3_avalanche(acc.hi);
+            for (size_t i = 4; i < len / 32; i++) {
+                xxh3_mix32(acc, in + 32 * i, in + 32 * i + 16, secret + 3 + 32 * (i - 4));
+            }
+            xxh3_mix32(acc, in + len - 16, in + len - 32, secret + 136 - 17 - 16);
+        }
+        uint64_t lo = acc.lo + acc.hi;
+        uint64_t hi = acc.lo * XXH_PRIME64_1 + acc.hi * XXH_PRIME64_4 + len * XXH_PRIME64_2;
+        return {xxh3_avalanche(lo), 0 - xxh3_avalanche(hi)};
+    }
+
+    uint64_t acc[8];
+    xxh3_accumulate_long(in, len, acc);
+    return {xxh3_merge_accs(acc, secret + 11, len * XXH_PRIME64_1),
+            xxh3_merge_accs(acc, secret + sizeof(XXH3_SECRET) - 64 - 11, ~(len * XXH_PRIME64_2))};
+}
+
 // ---------------------------------------------------------------------------
 // BitWriter — MSB-first bit accumulator (matches Elixir's <<v::size(N)>>)
 // ---------------------------------------------------------------------------
@@ -97,6 +603,16 @@ class BitWriter {
 public:
     BitWriter() : buf_(0), bits_(0) {}
 
+    // Take over a finished MSB-first bitstream of nbits.
+    BitWriter(std::vector<uint8_t> bytes, size_t nbits)
+        : out_(std::move(bytes)), buf_(0), bits_(static_cast<int>(nbits % 8)) {
+        out_.resize((nbits + 7) / 8);
+        if (bits_ > 0) {
+            buf_ = out_.back() >> (8 - bits_);
+            out_.pop_back();
+        }
+    }
+
     void write(uint64_t value, int nbits) {
         if (nbits <= 0) return;
         // Split writes > 32 bits to avoid UB from shifting uint64_t by >= 64
@@ -113,6 +629,21 @@ public:
         flush();
     }
 
+    // Write whole bytes; equivalent to write(data[i], 8) for each byte.
+    void write_bytes(const uint8_t *data, size_t count) {
+        size_t start = out_.size();
+        out_.resize(start + count);
+        uint8_t *dst = out_.data() + start;
+        if (bits_ == 0) {
+            if (count > 0) memcpy(dst, data, count);
+            return;
+        }
+        for (size_t i = 0; i < count; i++) {
+            buf_ = (buf_ << 8) | data[i];
+            dst[i] = static_cast<uint8_t>(buf_ >> bits_);
+        }
+    }
+
     // Write a signed value in two's complement, nbits wide.
     void write_signed(int64_t value, int nbits) {
         uint64_t mask = (nbits >= 64) ? UINT64_MAX : ((uint64_t(1) << nbits) - 1);
@@ -174,6 +705,17 @@ public:
         : data_(data), total_bits_(total_bits), pos_(0) {}
 
     uint64_t read(int nbits) {
+        // One unaligned load covers any field up to 56 bits wide while 8
+        // bytes remain past the read position; wider ones take two.
+        if (nbits > 0 && pos_ / 8 + 8 <= total_bits_ / 8) {
+            if (nbits > 56) {
+                uint64_t hi = read(nbits - 32);
+                return (hi << 32) | read(32);
+            }
+            uint64_t v = (load_be64(data_ + pos_ / 8) << (pos_ % 8)) >> (64 - nbits);
+            pos_ += nbits;
+            return v;
+        }
         uint64_t result = 0;
         for (int i = 0; i < nbits; i++) {
             result = (result << 1) | read_bit();
@@ -201,8 +743,18 @@ public:
         return (data_[byte_idx] >> bit_idx) & 1;
     }
 
+    // Jump to an absolute bit offset without reading the bits in between.
+    void seek(size_t pos) {
+        if (pos > total_bits_) {
+            throw std::runtime_error("BitReader: seek past end");
+        }
+        pos_ = pos;
+    }
+
     size_t position() const { return pos_; }
     size_t remaining() const { return total_bits_ > pos_ ? total_bits_ - pos_ : 0; }
+    const uint8_t *data() const { return data_; }
+    size_t size_bits() const { return total_bits_; }
 
 private:
     const uint8_t *data_;
@@ -210,58 +762,267 @@ private:
     size_t pos_;
 };
 
+// ---------------------------------------------------------------------------
+// Control symbol streams (flag 0x1000)
+// ---------------------------------------------------------------------------
+//
+// Prefix codes and length fields normally sit inline in the bitstreams.
+// When a chunk entropy codes them, the encoders push them as symbols into
+// side streams instead, and only the payload bits stay inline:
+//
+//   ts      : delta-of-delta bucket, 0-4 for '0'/'10'/'110'/'1110'/'1111'
+//   codes   : Gorilla 0 for '0', 1 for '10', 2 + leading for '11';
+//             Chimp and Chimp128 (flag << 3) | leading bucket
+//   lengths : Gorilla meaningful length - 1, Chimp significant count field
+//
+// Every encoder and decoder takes an optional ControlStreams; null means
+// the inline format.
+
+struct SymbolStream {
+    std::vector<uint8_t> symbols;
+    size_t pos = 0;
+
+    void push(int sym) { symbols.push_back(static_cast<uint8_t>(sym)); }
+
+    int pop() {
+        if (pos >= symbols.size()) throw std::runtime_error("corrupt control stream");
+        return symbols[pos++];
+    }
+};
+
+struct ControlStreams {
+    SymbolStream ts, codes, lengths;
+};
+
 // ---------------------------------------------------------------------------
 // Delta-of-delta timestamp encoding
 // ---------------------------------------------------------------------------
 
-static void encode_first_delta(BitWriter &w, int64_t delta) {
-    if (delta == 0) {
-        w.write(0, 1);  // 0
-    } else if (delta >= -63 && delta <= 64) {
-        w.write(0b10, 2);
-        w.write_signed(delta, 7);
-    } else if (delta >= -255 && delta <= 256) {
-        w.write(0b110, 3);
-        w.write_signed(delta, 9);
-    } else if (delta >= -2047 && delta <= 2048) {
-        w.write(0b1110, 4);
-        w.write_signed(delta, 12);
+static const uint8_t DOD_PREFIX[5] = {0b0, 0b10, 0b110, 0b1110, 0b1111};
+static const int DOD_PREFIX_LEN[5] = {1, 2, 3, 4, 4};
+static const int DOD_FIELD_BITS[5] = {0, 7, 9, 12, 32};
+
+static inline void put_dod_prefix(BitWriter &w, int k, ControlStreams *side) {
+    if (side) {
+        side->ts.push(k);
     } else {
-        w.write(0b1111, 4);
-        w.write_signed(delta, 32);
+        w.write(DOD_PREFIX[k], DOD_PREFIX_LEN[k]);
     }
 }
 
-static void encode_delta_of_delta(BitWriter &w, int64_t dod) {
+// Each bucket covers exactly the two's complement range of its field.
+static void encode_delta_of_delta(BitWriter &w, int64_t dod, ControlStreams *side = nullptr) {
     if (dod == 0) {
-        w.write(0, 1);
-    } else if (dod >= -63 && dod <= 64) {
-        w.write(0b10, 2);
+        put_dod_prefix(w, 0, side);
+    } else if (dod >= -64 && dod <= 63) {
+        put_dod_prefix(w, 1, side);
         w.write_signed(dod, 7);
-    } else if (dod >= -255 && dod <= 256) {
-        w.write(0b110, 3);
+    } else if (dod >= -256 && dod <= 255) {
+        put_dod_prefix(w, 2, side);
         w.write_signed(dod, 9);
-    } else if (dod >= -2047 && dod <= 2048) {
-        w.write(0b1110, 4);
+    } else if (dod >= -2048 && dod <= 2047) {
+        put_dod_prefix(w, 3, side);
         w.write_signed(dod, 12);
     } else {
-        w.write(0b1111, 4);
+        put_dod_prefix(w, 4, side);
         w.write_signed(dod, 32);
     }
 }
 
+// The first delta uses the same buckets.
+static void encode_first_delta(BitWriter &w, int64_t delta, ControlStreams *side = nullptr) {
+    encode_delta_of_delta(w, delta, side);
+}
+
+// ---------------------------------------------------------------------------
+// Block timestamp encoding (flag 0x100)
+// ---------------------------------------------------------------------------
+//
+// Event-driven series with jittery intervals put nearly every point in the
+// 12- or 32-bit delta-of-delta buckets. The block codec instead packs the
+// deltas frame-of-reference style, TS_BLOCK_SIZE at a time: a block header
+// (7-bit value width, 7-bit base width, zigzag change of the block minimum
+// from the previous block's), then every delta minus the minimum in a fixed
+// width. Decoding is a fixed-width unpack and a prefix sum, with no
+// per-point branches.
+
+static const uint32_t TS_BLOCK_SIZE = 128;
+
+enum class TimestampCodec { delta_of_delta, block, automatic, adaptive };
+
+static inline uint64_t zigzag_encode(uint64_t v) {
+    return (v << 1) ^ static_cast<uint64_t>(static_cast<int64_t>(v) >> 63);
+}
+
+static inline uint64_t zigzag_decode(uint64_t v) {
+    return (v >> 1) ^ (0 - (v & 1));
+}
+
+static inline int significant_bits(uint64_t v) {
+    return 64 - count_leading_zeros_64(v);
+}
+
+// Deltas are taken modulo 2^64 so any int64 timestamps round-trip.
+static void encode_timestamp_blocks(BitWriter &w, const int64_t *ts, size_t n) {
+    uint64_t prev_base = 0;
+    for (size_t start = 1; start < n; start += TS_BLOCK_SIZE) {
+        size_t end = std::min(n, start + TS_BLOCK_SIZE);
+
+        int64_t base = INT64_MAX;
+        for (size_t i = start; i < end; i++) {
+            base = std::min(base, static_cast<int64_t>(
+                static_cast<uint64_t>(ts[i]) - static_cast<uint64_t>(ts[i - 1])));
+        }
+        uint64_t span = 0;
+        for (size_t i = start; i < end; i++) {
+            span |= static_cast<uint64_t>(ts[i]) - static_cast<uint64_t>(ts[i - 1]) -
+                    static_cast<uint64_t>(base);
+        }
+        int width = significant_bits(span);
+        uint64_t base_change = zigzag_encode(static_cast<uint64_t>(base) - prev_base);
+        int base_width = significant_bits(base_change);
+
+        w.write(static_cast<uint64_t>(width), 7);
+        w.write(static_cast<uint64_t>(base_width), 7);
+        w.write(base_change, base_width);
+        for (size_t i = start; i < end; i++) {
+            w.write(static_cast<uint64_t>(ts[i]) - static_cast<uint64_t>(ts[i - 1]) -
+                    static_cast<uint64_t>(base), width);
+        }
+        prev_base = static_cast<uint64_t>(base);
+    }
+}
+
+// Size of the delta-of-delta stream after the first timestamp, without
+// writing it. SIZE_MAX when a delta-of-delta does not fit the 32-bit bucket,
+// which delta-of-delta would truncate.
+static size_t dod_stream_bits(const int64_t *ts, size_t n) {
+    auto bucket_bits = [](int64_t v) -> size_t {
+        if (v == 0) return 1;
+        if (v >= -64 && v <= 63) return 9;
+        if (v >= -256 && v <= 255) return 12;
+        if (v >= -2048 && v <= 2047) return 16;
+        if (v >= INT32_MIN && v <= INT32_MAX) return 36;
+        return SIZE_MAX;
+    };
+    auto delta = [ts](size_t i) {
+        return static_cast<int64_t>(static_cast<uint64_t>(ts[i]) - static_cast<uint64_t>(ts[i - 1]));
+    };
+    if (n < 2) return 0;
+    int64_t prev_delta = delta(1);
+    size_t bits = bucket_bits(prev_delta);
+    for (size_t i = 2; i < n && bits != SIZE_MAX; i++) {
+        int64_t d = delta(i);
+        size_t b = bucket_bits(static_cast<int64_t>(static_cast<uint64_t>(d) -
+                                                    static_cast<uint64_t>(prev_delta)));
+        bits = b == SIZE_MAX ? SIZE_MAX : bits + b;
+        prev_delta = d;
+    }
+    return bits;
+}
+
+// ---------------------------------------------------------------------------
+// Adaptive delta-of-delta buckets (flag 0x200)
+// ---------------------------------------------------------------------------
+//
+// The fixed 7/9/12/32-bit buckets are tuned for second-resolution scrapes;
+// millisecond series with jitter land almost entirely in the 12- and 32-bit
+// ones. The adaptive mode keeps the '0'/'10'/'110'/'1110'/'1111' prefixes
+// but picks the four field widths per chunk to minimise the stream, and
+// stores them after the first timestamp as four 6-bit fields (width - 1).
+// The first delta is coded as a delta-of-delta from 0 with the same table,
+// and the last width always covers the widest value, so deltas are taken
+// modulo 2^64 and nothing is truncated.
+
+struct DodBuckets {
+    int width[4];
+};
+
+// Two's complement width of v; 0 for 0, which takes the '0' prefix.
+static inline int signed_bits(int64_t v) {
+    return significant_bits(zigzag_encode(static_cast<uint64_t>(v)));
+}
+
+// Pick bucket widths from the histogram of value widths. `bits` receives
+// the size of the coded stream after the first timestamp, table included.
+static DodBuckets choose_dod_buckets(const int64_t *ts, size_t n, size_t &bits) {
+    static const int prefix[4] = {2, 3, 4, 4};
+    uint64_t cum[65] = {};
+    uint64_t prev_delta = 0;
+    for (size_t i = 1; i < n; i++) {
+        uint64_t delta = static_cast<uint64_t>(ts[i]) - static_cast<uint64_t>(ts[i - 1]);
+        cum[signed_bits(static_cast<int64_t>(delta - prev_delta))]++;
+        prev_delta = delta;
+    }
+    int top = 1;
+    for (int b = 1; b <= 64; b++) {
+        if (cum[b]) top = b;
+        cum[b] += cum[b - 1];
+    }
+
+    // Cost of the values whose width lies in (lo, hi] in bucket k.
+    auto cost = [&](int lo, int hi, int k) {
+        return (cum[hi] - cum[lo]) * static_cast<uint64_t>(prefix[k] + hi);
+    };
+    DodBuckets best = {{top, top, top, top}};
+    uint64_t best_cost = UINT64_MAX;
+    for (int a = 1; a <= top; a++) {
+        for (int b = a; b <= top; b++) {
+            for (int c = b; c <= top; c++) {
+                uint64_t total = cost(0, a, 0) + cost(a, b, 1) + cost(b, c, 2) + cost(c, top, 3);
+                if (total < best_cost) {
+                    best_cost = total;
+                    best = {{a, b, c, top}};
+                }
+            }
+        }
+    }
+    bits = 24 + cum[0] + best_cost;
+    return best;
+}
+
+static void encode_timestamps_adaptive(BitWriter &w, const int64_t *ts, size_t n,
+                                       const DodBuckets &buckets,
+                                       ControlStreams *side = nullptr) {
+    for (int k = 0; k < 4; k++) w.write(static_cast<uint64_t>(buckets.width[k] - 1), 6);
+
+    uint64_t prev_delta = 0;
+    for (size_t i = 1; i < n; i++) {
+        uint64_t delta = static_cast<uint64_t>(ts[i]) - static_cast<uint64_t>(ts[i - 1]);
+        int64_t dod = static_cast<int64_t>(delta - prev_delta);
+        prev_delta = delta;
+        if (dod == 0) {
+            put_dod_prefix(w, 0, side);
+            continue;
+        }
+        int bits = signed_bits(dod);
+        int k = 0;
+        while (k < 3 && bits > buckets.width[k]) k++;
+        put_dod_prefix(w, k + 1, side);
+        w.write_signed(dod, buckets.width[k]);
+    }
+}
+
 struct TimestampEncodeResult {
     BitWriter writer;
     int64_t first_timestamp;
     int64_t first_delta;
     size_t count;
+    bool block = false;     // flag 0x100
+    bool adaptive = false;  // flag 0x200
 };
 
-static TimestampEncodeResult encode_timestamps(const std::vector<int64_t> &timestamps) {
+// `automatic` sizes all three codecs and keeps the smallest, preferring
+// fixed delta-of-delta, then adaptive buckets, on ties. Bucket prefixes
+// go to `side` when given.
+static TimestampEncodeResult encode_timestamps(const int64_t *timestamps, size_t n,
+                                               TimestampCodec codec = TimestampCodec::delta_of_delta,
+                                               ControlStreams *side = nullptr)
+{
     TimestampEncodeResult result;
-    result.count = timestamps.size();
+    result.count = n;
 
-    if (timestamps.empty()) {
+    if (n == 0) {
         result.first_timestamp = 0;
         result.first_delta = 0;
         return result;
@@ -270,19 +1031,49 @@ static TimestampEncodeResult encode_timestamps(const std::vector<int64_t> &times
     result.first_timestamp = timestamps[0];
     result.writer.write(static_cast<uint64_t>(timestamps[0]), 64);
 
-    if (timestamps.size() == 1) {
+    if (n == 1) {
         result.first_delta = 0;
         return result;
     }
 
-    result.first_delta = timestamps[1] - timestamps[0];
-    encode_first_delta(result.writer, result.first_delta);
+    result.first_delta = static_cast<int64_t>(static_cast<uint64_t>(timestamps[1]) -
+                                              static_cast<uint64_t>(timestamps[0]));
+
+    if (codec != TimestampCodec::delta_of_delta) {
+        size_t adaptive_bits = 0;
+        DodBuckets buckets = choose_dod_buckets(timestamps, n, adaptive_bits);
+        size_t dod_bits = codec == TimestampCodec::automatic ? dod_stream_bits(timestamps, n)
+                                                             : SIZE_MAX;
+
+        size_t block_bits = SIZE_MAX;
+        BitWriter blocks;
+        if (codec == TimestampCodec::block || codec == TimestampCodec::automatic) {
+            blocks.write(static_cast<uint64_t>(timestamps[0]), 64);
+            encode_timestamp_blocks(blocks, timestamps, n);
+            block_bits = blocks.total_bits() - 64;
+        }
+
+        if (codec == TimestampCodec::block ||
+            (codec == TimestampCodec::automatic && block_bits < adaptive_bits &&
+             block_bits < dod_bits)) {
+            result.writer = std::move(blocks);
+            result.block = true;
+            return result;
+        }
+        if (codec == TimestampCodec::adaptive || adaptive_bits < dod_bits) {
+            encode_timestamps_adaptive(result.writer, timestamps, n, buckets, side);
+            result.adaptive = true;
+            return result;
+        }
+    }
+
+    encode_first_delta(result.writer, result.first_delta, side);
 
     int64_t prev_delta = result.first_delta;
-    for (size_t i = 2; i < timestamps.size(); i++) {
+    for (size_t i = 2; i < n; i++) {
         int64_t current_delta = timestamps[i] - timestamps[i - 1];
         int64_t dod = current_delta - prev_delta;
-        encode_delta_of_delta(result.writer, dod);
+        encode_delta_of_delta(result.writer, dod, side);
         prev_delta = current_delta;
     }
 
@@ -298,44 +1089,39 @@ static inline uint64_t bitmask(int n) {
     return (n >= 64) ? UINT64_MAX : ((uint64_t(1) << n) - 1);
 }
 
-static inline int count_leading_zeros_64(uint64_t v) {
-    if (v == 0) return 64;
-#if defined(__GNUC__) || defined(__clang__)
-    return __builtin_clzll(v);
-#elif defined(_MSC_VER)
-    unsigned long idx;
-    _BitScanReverse64(&idx, v);
-    return 63 - (int)idx;
-#else
-    int n = 0;
-    if (v <= 0x00000000FFFFFFFFULL) { n += 32; v <<= 32; }
-    if (v <= 0x0000FFFFFFFFFFFFULL) { n += 16; v <<= 16; }
-    if (v <= 0x00FFFFFFFFFFFFFFULL) { n += 8;  v <<= 8;  }
-    if (v <= 0x0FFFFFFFFFFFFFFFULL) { n += 4;  v <<= 4;  }
-    if (v <= 0x3FFFFFFFFFFFFFFFULL) { n += 2;  v <<= 2;  }
-    if (v <= 0x7FFFFFFFFFFFFFFFULL) { n += 1; }
-    return n;
-#endif
-}
+// Value word layouts. Float64 series XOR the full IEEE 754 double; float32
+// series (flag 0x10) XOR single-precision bit patterns, so the first value,
+// every window and the window length field shrink to fit 32-bit words.
+struct Float64Word {
+    static constexpr int bits = 64;
+    static constexpr int length_bits = 6;
 
-static inline int count_trailing_zeros_64(uint64_t v) {
-    if (v == 0) return 64;
-#if defined(__GNUC__) || defined(__clang__)
-    return __builtin_ctzll(v);
-#elif defined(_MSC_VER)
-    unsigned long idx;
-    _BitScanForward64(&idx, v);
-    return (int)idx;
-#else
-    int n = 0;
-    if ((v & 0x00000000FFFFFFFFULL) == 0) { n += 32; v >>= 32; }
-    if ((v & 0x000000000000FFFFULL) == 0) { n += 16; v >>= 16; }
-    if ((v & 0x00000000000000FFULL) == 0) { n += 8;  v >>= 8;  }
-    if ((v & 0x000000000000000FULL) == 0) { n += 4;  v >>= 4;  }
-    if ((v & 0x0000000000000003ULL) == 0) { n += 2;  v >>= 2;  }
-    if ((v & 0x0000000000000001ULL) == 0) { n += 1; }
-    return n;
-#endif
+    static uint64_t to_bits(double v) { return float_to_bits(v); }
+    static double from_bits(uint64_t bits) { return bits_to_float(bits); }
+};
+
+struct Float32Word {
+    static constexpr int bits = 32;
+    static constexpr int length_bits = 5;
+
+    static uint64_t to_bits(double v) {
+        float f = static_cast<float>(v);
+        uint32_t bits;
+        memcpy(&bits, &f, sizeof(bits));
+        return bits;
+    }
+    static double from_bits(uint64_t bits) {
+        uint32_t word = static_cast<uint32_t>(bits);
+        float f;
+        memcpy(&f, &word, sizeof(f));
+        return f;
+    }
+};
+
+// Leading zeros of a non-zero XOR within a Word-sized value
+template <typename Word>
+static inline int word_leading_zeros(uint64_t v) {
+    return count_leading_zeros_64(v) - (64 - Word::bits);
 }
 
 struct ValueEncodeResult {
@@ -344,7 +1130,15 @@ struct ValueEncodeResult {
     size_t count;
 };
 
-static ValueEncodeResult encode_values(const std::vector<double> &values) {
+// The lossless encoder starts from a full-width window, which every later
+// XOR fits, so windows never narrow — the Elixir encoder does the same and
+// the output must match it. Lossy chunks have no Elixir counterpart and
+// start without a window instead, so the first XOR opens a tight one.
+template <typename Word>
+static ValueEncodeResult encode_values(const std::vector<double> &values,
+                                       bool fresh_window = false,
+                                       ControlStreams *side = nullptr) {
+    constexpr int W = Word::bits;
     ValueEncodeResult result;
     result.count = values.size();
 
@@ -353,48 +1147,54 @@ static ValueEncodeResult encode_values(const std::vector<double> &values) {
         return result;
     }
 
-    result.first_value = values[0];
-    uint64_t first_bits = float_to_bits(values[0]);
-    result.writer.write(first_bits, 64);
+    uint64_t first_bits = Word::to_bits(values[0]);
+    result.first_value = Word::from_bits(first_bits);
+    result.writer.write(first_bits, W);
 
     if (values.size() == 1) {
         return result;
     }
 
     uint64_t prev_bits = first_bits;
-    int prev_leading = 0;
+    int prev_leading = fresh_window ? W : 0;  // W leaves an empty window
     int prev_trailing = 0;
 
     for (size_t i = 1; i < values.size(); i++) {
-        uint64_t curr_bits = float_to_bits(values[i]);
+        uint64_t curr_bits = Word::to_bits(values[i]);
         uint64_t xor_val = curr_bits ^ prev_bits;
 
         if (xor_val == 0) {
             // Identical — single '0' bit
-            result.writer.write(0, 1);
+            if (side) side->codes.push(0); else result.writer.write(0, 1);
         } else {
-            int leading = count_leading_zeros_64(xor_val);
+            int leading = word_leading_zeros<Word>(xor_val);
             int trailing = count_trailing_zeros_64(xor_val);
-            int meaningful = 64 - leading - trailing;
+            int meaningful = W - leading - trailing;
 
             if (leading >= prev_leading && trailing >= prev_trailing &&
-                (64 - prev_leading - prev_trailing) > 0) {
+                (W - prev_leading - prev_trailing) > 0) {
                 // Reuse previous window — '10' + meaningful bits
-                int prev_meaningful = 64 - prev_leading - prev_trailing;
+                int prev_meaningful = W - prev_leading - prev_trailing;
                 uint64_t meaningful_value =
                     (xor_val >> prev_trailing) & bitmask(prev_meaningful);
-                result.writer.write(0b10, 2);
+                if (side) side->codes.push(1); else result.writer.write(0b10, 2);
                 result.writer.write(meaningful_value, prev_meaningful);
             } else {
-                // New window — '11' + 5 bits leading + 6 bits (length-1) + meaningful bits
+                // New window — '11' + 5 bits leading + (length-1) + meaningful bits
                 int adj_leading = std::min(leading, 31);  // 5 bits max
-                int adj_meaningful = std::max(1, std::min(64, meaningful));
+                int adj_meaningful = std::max(1, std::min(W, meaningful));
                 uint64_t meaningful_value =
                     (xor_val >> trailing) & bitmask(adj_meaningful);
 
-                result.writer.write(0b11, 2);
-                result.writer.write(static_cast<uint64_t>(adj_leading), 5);
-                result.writer.write(static_cast<uint64_t>(adj_meaningful - 1), 6);
+                if (side) {
+                    side->codes.push(2 + adj_leading);
+                    side->lengths.push(adj_meaningful - 1);
+                } else {
+                    result.writer.write(0b11, 2);
+                    result.writer.write(static_cast<uint64_t>(adj_leading), 5);
+                    result.writer.write(static_cast<uint64_t>(adj_meaningful - 1),
+                                        Word::length_bits);
+                }
                 result.writer.write(meaningful_value, adj_meaningful);
 
                 prev_leading = adj_leading;
@@ -414,9 +1214,12 @@ static ValueEncodeResult encode_values(const std::vector<double> &values) {
 //
 // 4-case encoding with uniform 2-bit flags:
 //   00 — XOR is zero (identical value)
-//   01 — trailing zeros > 6: 3-bit leading bucket + 6-bit sig count + sig bits
-//   10 — same leading context: (64 - storedLeading) bits of raw XOR
-//   11 — new leading context: 3-bit leading bucket + (64 - roundedLeading) bits
+//   01 — trailing zeros > 6: 3-bit leading bucket + sig count + sig bits
+//   10 — same leading context: (W - storedLeading) bits of raw XOR
+//   11 — new leading context: 3-bit leading bucket + (W - roundedLeading) bits
+//
+// W is the word size (64, or 32 for float32 series); the sig count field is
+// 6 bits for 64-bit words and 5 bits for 32-bit words, with 0 meaning W.
 
 static constexpr int CHIMP_TRAILING_THRESHOLD = 6;
 
@@ -447,7 +1250,32 @@ static constexpr int chimp_leading_round[65] = {
 // Decode: 3-bit bucket code → actual leading zero count
 static constexpr int chimp_leading_decode[8] = {0, 8, 12, 16, 18, 20, 22, 24};
 
-static ValueEncodeResult encode_values_chimp(const std::vector<double> &values) {
+// Chimp flag and, for flags 01 and 11, the leading bucket: inline, or as
+// one control symbol.
+static inline void put_chimp_code(BitWriter &w, int flag, int lead, ControlStreams *side) {
+    if (side) {
+        side->codes.push(flag << 3 | lead);
+    } else {
+        w.write(static_cast<uint64_t>(flag), 2);
+        if (flag & 1) w.write(static_cast<uint64_t>(lead), 3);
+    }
+}
+
+// Significant count field of flag 01 (0 stands for W).
+template <typename Word>
+static inline void put_chimp_length(BitWriter &w, int significant, ControlStreams *side) {
+    uint64_t field = static_cast<uint64_t>(significant) & bitmask(Word::length_bits);
+    if (side) {
+        side->lengths.push(static_cast<int>(field));
+    } else {
+        w.write(field, Word::length_bits);
+    }
+}
+
+template <typename Word>
+static ValueEncodeResult encode_values_chimp(const std::vector<double> &values,
+                                             ControlStreams *side = nullptr) {
+    constexpr int W = Word::bits;
     ValueEncodeResult result;
     result.count = values.size();
 
@@ -456,9 +1284,9 @@ static ValueEncodeResult encode_values_chimp(const std::vector<double> &values)
         return result;
     }
 
-    result.first_value = values[0];
-    uint64_t first_bits = float_to_bits(values[0]);
-    result.writer.write(first_bits, 64);
+    uint64_t first_bits = Word::to_bits(values[0]);
+    result.first_value = Word::from_bits(first_bits);
+    result.writer.write(first_bits, W);
 
     if (values.size() == 1) {
         return result;
@@ -468,44 +1296,42 @@ static ValueEncodeResult encode_values_chimp(const std::vector<double> &values)
     int stored_leading = 65; // sentinel — forces flag 11 on first non-zero XOR
 
     for (size_t i = 1; i < values.size(); i++) {
-        uint64_t curr_bits = float_to_bits(values[i]);
+        uint64_t curr_bits = Word::to_bits(values[i]);
         uint64_t xor_val = curr_bits ^ prev_bits;
 
         if (xor_val == 0) {
             // Flag 00 — identical value
-            result.writer.write(0b00, 2);
+            put_chimp_code(result.writer, 0b00, 0, side);
             stored_leading = 65; // reset context
         } else {
-            int leading = count_leading_zeros_64(xor_val);
+            int leading = word_leading_zeros<Word>(xor_val);
             int trailing = count_trailing_zeros_64(xor_val);
 
             if (trailing > CHIMP_TRAILING_THRESHOLD) {
-                // Flag 01 — strip trailing zeros
-                int significant = 64 - leading - trailing;
-                int rounded_leading = chimp_leading_round[leading];
+                // Flag 01 — strip trailing zeros. The decoder only knows the
+                // rounded leading count, so the window starts there.
+                int significant = W - chimp_leading_round[leading] - trailing;
                 uint64_t sig_value = (xor_val >> trailing) & bitmask(significant);
 
-                result.writer.write(0b01, 2);
-                result.writer.write(chimp_leading_repr[leading], 3);
-                result.writer.write(static_cast<uint64_t>(significant), 6);
+                put_chimp_code(result.writer, 0b01, chimp_leading_repr[leading], side);
+                put_chimp_length<Word>(result.writer, significant, side);
                 result.writer.write(sig_value, significant);
 
                 stored_leading = 65; // reset context
             } else if (leading == stored_leading) {
                 // Flag 10 — reuse leading context
-                int raw_bits = 64 - stored_leading;
+                int raw_bits = W - stored_leading;
                 uint64_t raw_value = xor_val & bitmask(raw_bits);
-                result.writer.write(0b10, 2);
+                put_chimp_code(result.writer, 0b10, 0, side);
                 result.writer.write(raw_value, raw_bits);
                 // stored_leading unchanged
             } else {
                 // Flag 11 — new leading context
                 int rounded_leading = chimp_leading_round[leading];
-                int raw_bits = 64 - rounded_leading;
+                int raw_bits = W - rounded_leading;
                 uint64_t raw_value = xor_val & bitmask(raw_bits);
 
-                result.writer.write(0b11, 2);
-                result.writer.write(chimp_leading_repr[leading], 3);
+                put_chimp_code(result.writer, 0b11, chimp_leading_repr[leading], side);
                 result.writer.write(raw_value, raw_bits);
 
                 stored_leading = rounded_leading;
@@ -519,75 +1345,114 @@ static ValueEncodeResult encode_values_chimp(const std::vector<double> &values)
 }
 
 // Chimp value decoder — reads from the same bitstream position as Gorilla
-static std::vector<double> decode_values_chimp(BitReader &reader, uint32_t count) {
-    std::vector<double> values;
-    values.reserve(count);
-
-    if (count == 0) return values;
-
-    uint64_t first_bits = reader.read(64);
-    values.push_back(bits_to_float(first_bits));
-    if (count == 1) return values;
+template <typename Word, typename Out>
+static void decode_values_chimp(BitReader &reader, uint32_t count, Out *out,
+                                ControlStreams *side = nullptr) {
+    constexpr int W = Word::bits;
+    if (count == 0) return;
+
+    uint64_t first_bits = reader.read(W);
+    out[0] = static_cast<Out>(Word::from_bits(first_bits));
+    if (count == 1) return;
     uint64_t prev_bits = first_bits;
     int stored_leading = 65;
 
     for (size_t i = 1; i < count; i++) {
-        uint64_t flag = reader.read(2);
+        uint64_t code = side ? side->codes.pop() : reader.read(2) << 3;
+        uint64_t flag = code >> 3;
 
         if (flag == 0b00) {
             // Identical value
-            values.push_back(bits_to_float(prev_bits));
+            out[i] = out[i - 1];
             stored_leading = 65;
         } else if (flag == 0b01) {
             // Trailing zeros stripped
-            uint64_t lead_code = reader.read(3);
+            uint64_t lead_code = side ? code & 7 : reader.read(3);
             int leading = chimp_leading_decode[lead_code];
-            uint64_t significant = reader.read(6);
-            if (significant == 0) significant = 64;
-            int trailing = 64 - leading - static_cast<int>(significant);
+            uint64_t significant = side ? side->lengths.pop() : reader.read(Word::length_bits);
+            if (significant == 0) significant = W;
+            int trailing = W - leading - static_cast<int>(significant);
             if (trailing < 0) trailing = 0;
             uint64_t sig_value = reader.read(static_cast<int>(significant));
             uint64_t xor_val = sig_value << trailing;
             prev_bits = prev_bits ^ xor_val;
-            values.push_back(bits_to_float(prev_bits));
+            out[i] = static_cast<Out>(Word::from_bits(prev_bits));
             stored_leading = 65;
         } else if (flag == 0b10) {
             // Reuse leading context
-            int raw_bits = 64 - stored_leading;
+            int raw_bits = W - stored_leading;
             uint64_t raw_value = reader.read(raw_bits);
             uint64_t xor_val = raw_value; // lower bits only, upper are zero (leading zeros)
             prev_bits = prev_bits ^ xor_val;
-            values.push_back(bits_to_float(prev_bits));
+            out[i] = static_cast<Out>(Word::from_bits(prev_bits));
         } else {
             // Flag 11 — new leading context
-            uint64_t lead_code = reader.read(3);
+            uint64_t lead_code = side ? code & 7 : reader.read(3);
             int leading = chimp_leading_decode[lead_code];
-            int raw_bits = 64 - leading;
+            int raw_bits = W - leading;
             uint64_t raw_value = reader.read(raw_bits);
             uint64_t xor_val = raw_value;
             prev_bits = prev_bits ^ xor_val;
-            values.push_back(bits_to_float(prev_bits));
+            out[i] = static_cast<Out>(Word::from_bits(prev_bits));
             stored_leading = leading;
         }
     }
-
-    return values;
 }
 
 // ---------------------------------------------------------------------------
-// Chimp128 value compression — XOR with best of 128 previous values
+// Chimp128 value compression — XOR with best of N previous values
 // ---------------------------------------------------------------------------
 //
-// Flags 00 and 01 reference a ring buffer entry via 7-bit index.
+// Flags 00 and 01 reference a ring buffer entry via a log2(N)-bit index.
 // Flags 10 and 11 XOR with the most recent value (same as basic Chimp).
-// Threshold raised to 13 (6 + log2(128)).
+// Threshold raised to 6 + log2(N).
+//
+// The window N is 128 by default; 32, 64 and 256 are recorded in flag bits
+// 10-11 (0 = 128, 1 = 32, 2 = 64, 3 = 256) so older chunks read unchanged.
+
+template <int LOG2N>
+struct Chimp128Window {
+    static constexpr int N = 1 << LOG2N;
+    static constexpr int THRESHOLD = 6 + LOG2N;
+    static constexpr uint64_t HASH_MASK = (1ULL << (THRESHOLD + 1)) - 1;
+};
 
-static constexpr int CHIMP128_N = 128;
-static constexpr int CHIMP128_LOG2N = 7;
-static constexpr int CHIMP128_THRESHOLD = 6 + CHIMP128_LOG2N; // 13
-static constexpr uint64_t CHIMP128_HASH_MASK = (1ULL << (CHIMP128_THRESHOLD + 1)) - 1;
+static constexpr int CHIMP128_DEFAULT_WINDOW = 128;
 
-static ValueEncodeResult encode_values_chimp128(const std::vector<double> &values) {
+// Flag bits 10-11 for a window size; -1 if the size is not supported.
+static int chimp128_window_code(int window) {
+    switch (window) {
+        case 128: return 0;
+        case 32:  return 1;
+        case 64:  return 2;
+        case 256: return 3;
+        default:  return -1;
+    }
+}
+
+static int chimp128_window_from_flags(uint32_t flags) {
+    static const int windows[4] = {128, 32, 64, 256};
+    return windows[(flags >> 10) & 0x3];
+}
+
+// Per-thread hash index of 16-bit ring positions, left dirty between calls
+// rather than cleared. An entry is only trusted when it is within the
+// window and the ring slot it names still holds a value with the same hash
+// key; a stale entry from an earlier call or from 64K points back names a
+// slot whose value has another key (that value's key would have replaced
+// the entry), so this picks exactly the reference a cleared table would.
+template <int LOG2N>
+static uint16_t *chimp128_index_table() {
+    thread_local uint16_t table[Chimp128Window<LOG2N>::HASH_MASK + 1];
+    return table;
+}
+
+template <typename Word, int LOG2N>
+static ValueEncodeResult encode_values_chimp128(const std::vector<double> &values,
+                                                ControlStreams *side = nullptr) {
+    using Win = Chimp128Window<LOG2N>;
+    constexpr int W = Word::bits;
+    constexpr int N = Win::N;
     ValueEncodeResult result;
     result.count = values.size();
 
@@ -596,73 +1461,75 @@ static ValueEncodeResult encode_values_chimp128(const std::vector<double> &value
         return result;
     }
 
-    result.first_value = values[0];
-    uint64_t first_bits = float_to_bits(values[0]);
-    result.writer.write(first_bits, 64);
+    uint64_t first_bits = Word::to_bits(values[0]);
+    result.first_value = Word::from_bits(first_bits);
+    result.writer.write(first_bits, W);
 
     if (values.size() == 1) {
         return result;
     }
 
     // Ring buffer and hash table
-    uint64_t ring[CHIMP128_N] = {};
-    int ring_indices[CHIMP128_HASH_MASK + 1];
-    memset(ring_indices, -1, sizeof(ring_indices));
+    alignas(64) uint64_t ring[N] = {};
+    uint16_t *ring_indices = chimp128_index_table<LOG2N>();
 
     ring[0] = first_bits;
-    ring_indices[first_bits & CHIMP128_HASH_MASK] = 0;
-    int ring_pos = 1;
+    ring_indices[first_bits & Win::HASH_MASK] = 0;
+    size_t ring_pos = 1;
 
     uint64_t stored_val = first_bits;
     int stored_leading = 65;
 
     for (size_t i = 1; i < values.size(); i++) {
-        uint64_t curr_bits = float_to_bits(values[i]);
+        uint64_t curr_bits = Word::to_bits(values[i]);
 
         // Find best reference: check hash table for a previous value
         // that produces the most trailing zeros
-        uint64_t hash_key = curr_bits & CHIMP128_HASH_MASK;
-        int candidate_idx = ring_indices[hash_key];
+        uint64_t hash_key = curr_bits & Win::HASH_MASK;
+        uint16_t candidate = ring_indices[hash_key];
+        int ref_idx = candidate & (N - 1);
 
         uint64_t xor_prev = curr_bits ^ stored_val;
         uint64_t xor_ring = UINT64_MAX;
-        int best_ring_idx = -1;
-
-        if (candidate_idx >= 0) {
-            // Check if candidate is still in the ring window
-            int distance = ring_pos - candidate_idx;
-            if (distance < 0) distance += CHIMP128_N;
-            if (distance > 0 && distance <= CHIMP128_N) {
-                xor_ring = curr_bits ^ ring[candidate_idx % CHIMP128_N];
-                int trailing_ring = (xor_ring == 0) ? 64 : count_trailing_zeros_64(xor_ring);
-                int trailing_prev = (xor_prev == 0) ? 64 : count_trailing_zeros_64(xor_prev);
-                if (trailing_ring >= trailing_prev) {
-                    best_ring_idx = candidate_idx;
-                }
-            }
+        bool use_ring = false;
+
+        // Check the candidate is in the window and still in its ring slot
+        uint16_t distance = static_cast<uint16_t>(ring_pos - candidate);
+        if (distance > 0 && distance <= N &&
+            (ring_pos >= static_cast<size_t>(N) || static_cast<size_t>(ref_idx) < ring_pos) &&
+            (ring[ref_idx] & Win::HASH_MASK) == hash_key) {
+            xor_ring = curr_bits ^ ring[ref_idx];
+            int trailing_ring = (xor_ring == 0) ? 64 : count_trailing_zeros_64(xor_ring);
+            int trailing_prev = (xor_prev == 0) ? 64 : count_trailing_zeros_64(xor_prev);
+            use_ring = trailing_ring >= trailing_prev;
         }
 
         // Choose: XOR with ring entry (flags 00/01) or with previous (flags 10/11)
-        if (best_ring_idx >= 0) {
+        if (use_ring) {
             uint64_t xor_val = xor_ring;
-            int ref_idx = best_ring_idx % CHIMP128_N;
 
             if (xor_val == 0) {
                 // Flag 00 — exact match with ring entry
-                result.writer.write(0b00, 2);
-                result.writer.write(static_cast<uint64_t>(ref_idx), CHIMP128_LOG2N);
+                put_chimp_code(result.writer, 0b00, 0, side);
+                result.writer.write(static_cast<uint64_t>(ref_idx), LOG2N);
                 stored_leading = 65;
             } else {
                 int trailing = count_trailing_zeros_64(xor_val);
-                if (trailing > CHIMP128_THRESHOLD) {
+                if (trailing > Win::THRESHOLD) {
                     // Flag 01 — ring ref with trailing zeros stripped
-                    int leading = count_leading_zeros_64(xor_val);
-                    int significant = 64 - leading - trailing;
-
-                    result.writer.write(0b01, 2);
-                    result.writer.write(static_cast<uint64_t>(ref_idx), CHIMP128_LOG2N);
-                    result.writer.write(chimp_leading_repr[leading], 3);
-                    result.writer.write(static_cast<uint64_t>(significant), 6);
+                    int leading = word_leading_zeros<Word>(xor_val);
+                    int significant = W - chimp_leading_round[leading] - trailing;
+
+                    // The ring index sits between the flag and the bucket
+                    if (side) {
+                        side->codes.push(0b01 << 3 | chimp_leading_repr[leading]);
+                        result.writer.write(static_cast<uint64_t>(ref_idx), LOG2N);
+                    } else {
+                        result.writer.write(0b01, 2);
+                        result.writer.write(static_cast<uint64_t>(ref_idx), LOG2N);
+                        result.writer.write(chimp_leading_repr[leading], 3);
+                    }
+                    put_chimp_length<Word>(result.writer, significant, side);
                     uint64_t sig_value = (xor_val >> trailing) & bitmask(significant);
                     result.writer.write(sig_value, significant);
                     stored_leading = 65;
@@ -677,25 +1544,24 @@ static ValueEncodeResult encode_values_chimp128(const std::vector<double> &value
 
             if (xor_val == 0) {
                 // Flag 00 with self-reference (current ring position)
-                result.writer.write(0b00, 2);
-                result.writer.write(static_cast<uint64_t>((ring_pos - 1) % CHIMP128_N), CHIMP128_LOG2N);
+                put_chimp_code(result.writer, 0b00, 0, side);
+                result.writer.write(static_cast<uint64_t>((ring_pos - 1) & (N - 1)), LOG2N);
                 stored_leading = 65;
             } else {
-                int leading = count_leading_zeros_64(xor_val);
+                int leading = word_leading_zeros<Word>(xor_val);
 
                 if (leading == stored_leading) {
                     // Flag 10 — reuse leading context
-                    int raw_bits = 64 - stored_leading;
+                    int raw_bits = W - stored_leading;
                     uint64_t raw_value = xor_val & bitmask(raw_bits);
-                    result.writer.write(0b10, 2);
+                    put_chimp_code(result.writer, 0b10, 0, side);
                     result.writer.write(raw_value, raw_bits);
                 } else {
                     // Flag 11 — new leading context
                     int rounded_leading = chimp_leading_round[leading];
-                    int raw_bits = 64 - rounded_leading;
+                    int raw_bits = W - rounded_leading;
                     uint64_t raw_value = xor_val & bitmask(raw_bits);
-                    result.writer.write(0b11, 2);
-                    result.writer.write(chimp_leading_repr[leading], 3);
+                    put_chimp_code(result.writer, 0b11, chimp_leading_repr[leading], side);
                     result.writer.write(raw_value, raw_bits);
                     stored_leading = rounded_leading;
                 }
@@ -703,8 +1569,8 @@ static ValueEncodeResult encode_values_chimp128(const std::vector<double> &value
         }
 
         // Update ring buffer and hash table
-        ring[ring_pos % CHIMP128_N] = curr_bits;
-        ring_indices[curr_bits & CHIMP128_HASH_MASK] = ring_pos;
+        ring[ring_pos & (N - 1)] = curr_bits;
+        ring_indices[hash_key] = static_cast<uint16_t>(ring_pos);
         ring_pos++;
         stored_val = curr_bits;
     }
@@ -712,41 +1578,44 @@ static ValueEncodeResult encode_values_chimp128(const std::vector<double> &value
     return result;
 }
 
-// Chimp128 value decoder
-static std::vector<double> decode_values_chimp128(BitReader &reader, uint32_t count) {
-    std::vector<double> values;
-    values.reserve(count);
-
-    if (count == 0) return values;
+// Chimp128 value decoder. The ring is a power-of-two array indexed by
+// mask, one cache line per 8 entries.
+template <typename Word, int LOG2N, typename Out>
+static void decode_values_chimp128(BitReader &reader, uint32_t count, Out *out,
+                                   ControlStreams *side = nullptr) {
+    constexpr int W = Word::bits;
+    constexpr int N = Chimp128Window<LOG2N>::N;
+    if (count == 0) return;
 
-    uint64_t first_bits = reader.read(64);
-    values.push_back(bits_to_float(first_bits));
-    if (count == 1) return values;
+    uint64_t first_bits = reader.read(W);
+    out[0] = static_cast<Out>(Word::from_bits(first_bits));
+    if (count == 1) return;
 
-    uint64_t ring[CHIMP128_N] = {};
+    alignas(64) uint64_t ring[N] = {};
     ring[0] = first_bits;
-    int ring_pos = 1;
+    uint32_t ring_pos = 1;
 
     uint64_t stored_val = first_bits;
     int stored_leading = 65;
 
     for (uint32_t i = 1; i < count; i++) {
-        uint64_t flag = reader.read(2);
+        uint64_t code = side ? side->codes.pop() : reader.read(2) << 3;
+        uint64_t flag = code >> 3;
         uint64_t new_bits;
 
         if (flag == 0b00) {
             // Exact match with ring entry
-            uint64_t idx = reader.read(CHIMP128_LOG2N);
+            uint64_t idx = reader.read(LOG2N);
             new_bits = ring[idx];
             stored_leading = 65;
         } else if (flag == 0b01) {
             // Ring ref with trailing zeros stripped
-            uint64_t idx = reader.read(CHIMP128_LOG2N);
-            uint64_t lead_code = reader.read(3);
+            uint64_t idx = reader.read(LOG2N);
+            uint64_t lead_code = side ? code & 7 : reader.read(3);
             int leading = chimp_leading_decode[lead_code];
-            uint64_t significant = reader.read(6);
-            if (significant == 0) significant = 64;
-            int trailing = 64 - leading - static_cast<int>(significant);
+            uint64_t significant = side ? side->lengths.pop() : reader.read(Word::length_bits);
+            if (significant == 0) significant = W;
+            int trailing = W - leading - static_cast<int>(significant);
             if (trailing < 0) trailing = 0;
             uint64_t sig_value = reader.read(static_cast<int>(significant));
             uint64_t xor_val = sig_value << trailing;
@@ -754,26 +1623,202 @@ static std::vector<double> decode_values_chimp128(BitReader &reader, uint32_t co
             stored_leading = 65;
         } else if (flag == 0b10) {
             // Reuse leading context, XOR with previous
-            int raw_bits = 64 - stored_leading;
+            int raw_bits = W - stored_leading;
             uint64_t raw_value = reader.read(raw_bits);
             new_bits = stored_val ^ raw_value;
         } else {
             // Flag 11 — new leading context, XOR with previous
-            uint64_t lead_code = reader.read(3);
+            uint64_t lead_code = side ? code & 7 : reader.read(3);
             int leading = chimp_leading_decode[lead_code];
-            int raw_bits = 64 - leading;
+            int raw_bits = W - leading;
             uint64_t raw_value = reader.read(raw_bits);
             new_bits = stored_val ^ raw_value;
             stored_leading = leading;
         }
 
-        values.push_back(bits_to_float(new_bits));
-        ring[ring_pos % CHIMP128_N] = new_bits;
+        out[i] = static_cast<Out>(Word::from_bits(new_bits));
+        ring[ring_pos & (N - 1)] = new_bits;
         ring_pos++;
         stored_val = new_bits;
     }
+}
+
+// ---------------------------------------------------------------------------
+// FPC value compression — XOR with the better of two predictions
+// ---------------------------------------------------------------------------
+//
+// After Burtscher and Ratanaworabhan's FPC. Two hash-indexed tables predict
+// each value from the recent history:
+//   FCM  — the value that followed the same value context last time
+//   DFCM — the previous value plus the stride that followed the same stride
+//          context last time, which follows trends and periodic loads
+// Each value is XORed with the closer prediction and written as
+//   selector (1 bit, 1 = DFCM) + leading zero bytes (3 bits) + residual bytes
+// For 64-bit words a count of 4 zero bytes is coded as 3, so the eight codes
+// cover 0-3 and 5-8. With rANS control streams the selector and count go to
+// the codes stream as selector << 3 | count. Each table holds 2^10 words,
+// 16 KiB for both, so they stay resident in L1.
+
+static constexpr int FPC_TABLE_BITS = 10;
+static constexpr uint64_t FPC_TABLE_MASK = (uint64_t(1) << FPC_TABLE_BITS) - 1;
+
+template <typename Word>
+struct FpcPredictor {
+    static constexpr int W = Word::bits;
+
+    uint64_t fcm[1 << FPC_TABLE_BITS] = {};
+    uint64_t dfcm[1 << FPC_TABLE_BITS] = {};
+    uint64_t fcm_hash = 0;
+    uint64_t dfcm_hash = 0;
+    uint64_t last = 0;
+
+    uint64_t predict_fcm() const { return fcm[fcm_hash]; }
+    uint64_t predict_dfcm() const { return (dfcm[dfcm_hash] + last) & bitmask(W); }
+
+    void update(uint64_t bits) {
+        fcm[fcm_hash] = bits;
+        fcm_hash = ((fcm_hash << 6) ^ (bits >> (W - 16))) & FPC_TABLE_MASK;
+        uint64_t stride = (bits - last) & bitmask(W);
+        dfcm[dfcm_hash] = stride;
+        dfcm_hash = ((dfcm_hash << 2) ^ (stride >> (W - 24))) & FPC_TABLE_MASK;
+        last = bits;
+    }
+};
+
+// Leading zero bytes of a residual, rounded down to one the 3-bit code can
+// express, and that code.
+template <typename Word>
+static inline int fpc_zero_bytes(uint64_t residual, int &code) {
+    int bytes = residual == 0 ? Word::bits / 8 : word_leading_zeros<Word>(residual) / 8;
+    if (Word::bits == 64 && bytes == 4) bytes = 3;
+    code = Word::bits == 64 && bytes > 4 ? bytes - 1 : bytes;
+    return bytes;
+}
+
+template <typename Word>
+static inline int fpc_zero_bytes_from_code(int code) {
+    int bytes = Word::bits == 64 && code >= 4 ? code + 1 : code;
+    if (bytes > Word::bits / 8) throw std::runtime_error("corrupt FPC code");
+    return bytes;
+}
+
+template <typename Word>
+static ValueEncodeResult encode_values_fpc(const std::vector<double> &values,
+                                           ControlStreams *side = nullptr) {
+    constexpr int W = Word::bits;
+    ValueEncodeResult result;
+    result.count = values.size();
+
+    if (values.empty()) {
+        result.first_value = 0.0;
+        return result;
+    }
+
+    uint64_t first_bits = Word::to_bits(values[0]);
+    result.first_value = Word::from_bits(first_bits);
+    result.writer.write(first_bits, W);
+
+    FpcPredictor<Word> predictor;
+    predictor.update(first_bits);
+
+    for (size_t i = 1; i < values.size(); i++) {
+        uint64_t bits = Word::to_bits(values[i]);
+        uint64_t xor_fcm = bits ^ predictor.predict_fcm();
+        uint64_t xor_dfcm = bits ^ predictor.predict_dfcm();
+        int selector = xor_dfcm < xor_fcm ? 1 : 0;
+        uint64_t residual = selector ? xor_dfcm : xor_fcm;
+
+        int code;
+        int residual_bits = W - 8 * fpc_zero_bytes<Word>(residual, code);
+        if (side) {
+            side->codes.push(selector << 3 | code);
+        } else {
+            result.writer.write(static_cast<uint64_t>(selector << 3 | code), 4);
+        }
+        result.writer.write(residual & bitmask(residual_bits), residual_bits);
+
+        predictor.update(bits);
+    }
+
+    return result;
+}
+
+template <typename Word, typename Out>
+static void decode_values_fpc(BitReader &reader, uint32_t count, Out *out,
+                              ControlStreams *side = nullptr) {
+    constexpr int W = Word::bits;
+    if (count == 0) return;
+
+    uint64_t bits = reader.read(W);
+    out[0] = static_cast<Out>(Word::from_bits(bits));
+
+    FpcPredictor<Word> predictor;
+    predictor.update(bits);
+
+    for (size_t i = 1; i < count; i++) {
+        int code = side ? side->codes.pop() : static_cast<int>(reader.read(4));
+        int residual_bits = W - 8 * fpc_zero_bytes_from_code<Word>(code & 7);
+        uint64_t residual = reader.read(residual_bits);
+        uint64_t prediction = (code & 8) ? predictor.predict_dfcm() : predictor.predict_fcm();
+
+        bits = prediction ^ residual;
+        out[i] = static_cast<Out>(Word::from_bits(bits));
+        predictor.update(bits);
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Validity bitmap (flag 0x40)
+// ---------------------------------------------------------------------------
+//
+// Sparse series mark missing points in a run-length coded bitmap that follows
+// the value bitstream. Missing points keep their timestamps but take no slot
+// in the value stream, so a gap leaves the XOR state untouched.
+//
+//   first state : 1 bit (1 = present)
+//   runs        : Elias-gamma coded run lengths of alternating state,
+//                 summing to the point count
+
+static void encode_validity(BitWriter &w, const uint8_t *valid, size_t n) {
+    bool state = valid[0] != 0;
+    w.write(state ? 1 : 0, 1);
+
+    size_t i = 0;
+    while (i < n) {
+        size_t run = 0;
+        while (i < n && (valid[i] != 0) == state) {
+            run++;
+            i++;
+        }
+        int nbits = 64 - count_leading_zeros_64(run);
+        w.write(0, nbits - 1);
+        w.write(run, nbits);
+        state = !state;
+    }
+}
+
+// Fill `valid` with count entries and return the number of present points.
+static size_t decode_validity(BitReader &r, uint32_t count, std::vector<uint8_t> &valid) {
+    valid.assign(count, 0);
+    uint8_t state = static_cast<uint8_t>(r.read_bit());
+
+    size_t pos = 0, present = 0;
+    while (pos < count) {
+        int zeros = 0;
+        while (r.read_bit() == 0) {
+            if (++zeros > 32) throw std::runtime_error("corrupt validity bitmap");
+        }
+        uint64_t run = (uint64_t(1) << zeros) | r.read(zeros);
+        if (run > count - pos) throw std::runtime_error("corrupt validity bitmap");
 
-    return values;
+        if (state) {
+            std::fill(valid.begin() + pos, valid.begin() + pos + run, 1);
+            present += run;
+        }
+        pos += run;
+        state ^= 1;
+    }
+    return present;
 }
 
 // ---------------------------------------------------------------------------
@@ -811,16 +1856,17 @@ static std::vector<uint8_t> build_inner_header(
 // ---------------------------------------------------------------------------
 // Outer metadata header — matches Encoder.Metadata.add_metadata/2
 // ---------------------------------------------------------------------------
-// V1 = 80 bytes, V2 = 84 bytes (has scale_decimals)
+// V1 = 80 bytes, V2 = 84 bytes (has scale_decimals). Version 2 headers
+// (flag 0x80) append a 64-bit xxHash3 of the packed payload: 88 | 92 bytes.
 //
 // Layout (all big-endian):
 //   magic            : 64   "GORILLA"
-//   version          : 16   1
-//   header_size      : 16   80 | 84
+//   version          : 16   1 | 2
+//   header_size      : 16   80 | 84 | 88 | 92
 //   count            : 32
 //   compressed_size  : 32
 //   original_size    : 32
-//   crc32            : 32
+//   crc32            : 32   (0 when xxh3 is present)
 //   first_timestamp  : 64
 //   first_delta      : 32 (signed)
 //   first_value_bits : 64
@@ -831,9 +1877,10 @@ static std::vector<uint8_t> build_inner_header(
 //   creation_time    : 64
 //   flags            : 32
 //   [scale_decimals] : 32   (V2 only)
+//   [xxh3]           : 64   (version 2 only)
 
 static const uint64_t GORILLA_MAGIC = 0x474F52494C4C41ULL;
-static const uint16_t GORILLA_VERSION = 1;
+static const uint16_t GORILLA_VERSION = 2;
 
 static std::vector<uint8_t> build_outer_header(
     uint32_t count,
@@ -849,14 +1896,15 @@ static std::vector<uint8_t> build_outer_header(
     int64_t creation_time,
     uint32_t flags,
     uint32_t scale_decimals,
-    bool v2)
+    bool v2,
+    std::optional<uint64_t> xxh3 = std::nullopt)
 {
-    uint16_t header_size = v2 ? 84 : 80;
+    uint16_t header_size = (v2 ? 84 : 80) + (xxh3 ? 8 : 0);
     uint32_t original_size = count * 16;
 
     BitWriter w;
     w.write(GORILLA_MAGIC, 64);
-    w.write(GORILLA_VERSION, 16);
+    w.write(xxh3 ? GORILLA_VERSION : 1, 16);
     w.write(header_size, 16);
     w.write(count, 32);
     w.write(compressed_size, 32);
@@ -876,11 +1924,52 @@ static std::vector<uint8_t> build_outer_header(
     if (v2) {
         w.write(scale_decimals, 32);
     }
+    if (xxh3) {
+        w.write(*xxh3, 64);
+    }
 
     int trailing;
     return w.to_bytes(trailing);
 }
 
+// ---------------------------------------------------------------------------
+// Lossy mantissa rounding
+// ---------------------------------------------------------------------------
+//
+// Rounds a value to `keep` explicit mantissa bits, so the XOR of neighbouring
+// values ends in a long run of zeros. Round-to-nearest bounds the relative
+// error by 2^-(keep + 1). Zero, subnormals, infinities and NaN pass through
+// untouched; a value that would round up to infinity is truncated instead.
+
+template <typename Float, typename Bits>
+static double round_mantissa(double value, int keep) {
+    constexpr int mantissa = std::numeric_limits<Float>::digits - 1;  // 52 | 23
+    constexpr int width = static_cast<int>(sizeof(Bits)) * 8;
+    constexpr Bits exp_mask = ((Bits(1) << (width - 1 - mantissa)) - 1) << mantissa;
+
+    Float f = static_cast<Float>(value);
+    Bits bits;
+    memcpy(&bits, &f, sizeof(bits));
+
+    Bits exponent = bits & exp_mask;
+    if (keep >= mantissa || exponent == 0 || exponent == exp_mask) return value;
+
+    int drop = mantissa - keep;
+    Bits low = (Bits(1) << drop) - 1;
+    Bits rounded = (bits + (Bits(1) << (drop - 1))) & ~low;
+    if ((rounded & exp_mask) == exp_mask) rounded = bits & ~low;
+
+    memcpy(&f, &rounded, sizeof(f));
+    return f;
+}
+
+// Mantissa bits needed to keep the relative error within max_error.
+static int mantissa_bits_for_error(double max_error) {
+    if (!(max_error > 0.0)) return 52;
+    int bits = static_cast<int>(std::ceil(-std::log2(max_error))) - 1;
+    return std::max(0, std::min(52, bits));
+}
+
 // ---------------------------------------------------------------------------
 // VM preprocessing helpers
 // ---------------------------------------------------------------------------
@@ -923,7 +2012,7 @@ static std::vector<double> scale_values(const std::vector<double> &values, int n
 
 // Delta-encode a counter series
 static std::vector<double> delta_encode_counter(const std::vector<double> &values) {
-    if (values.empty()) return values;
+    if (values.empty()) return {};
     std::vector<double> result;
     result.reserve(values.size());
     result.push_back(values[0]);
@@ -933,123 +2022,304 @@ static std::vector<double> delta_encode_counter(const std::vector<double> &value
     return result;
 }
 
-// Delta-decode a counter series
-static std::vector<double> delta_decode_counter(const std::vector<double> &values) {
-    if (values.empty()) return values;
-    std::vector<double> result;
-    result.reserve(values.size());
-    result.push_back(values[0]);
-    for (size_t i = 1; i < values.size(); i++) {
-        result.push_back(result.back() + values[i]);
+// Delta-decode a counter series in place
+static void delta_decode_counter(double *values, size_t count) {
+    for (size_t i = 1; i < count; i++) {
+        values[i] += values[i - 1];
     }
-    return result;
 }
 
 // ---------------------------------------------------------------------------
-// Encode NIF
+// rANS control streams (flag 0x1000)
 // ---------------------------------------------------------------------------
+//
+// Each control stream is coded with two interleaved 32-bit rANS states
+// over a 12-bit frequency table, renormalising a byte at a time. The
+// streams follow the last bitstream of the chunk, byte aligned, in the
+// order ts, codes, lengths:
+//
+//   count   : 32 bits, symbols in the stream; nothing follows when 0
+//   nsym    : 8 bits, alphabet size
+//   freqs   : nsym LEB128 frequencies summing to 4096
+//   size    : 32 bits, payload bytes
+//   payload : final states of coder 0 and 1 (little-endian 32-bit), then
+//             the renormalisation bytes in decode order
+//
+// Symbol i goes through coder i & 1. Decoding is a table lookup on the
+// low 12 bits of the state.
+
+static constexpr int RANS_PROB_BITS = 12;
+static constexpr uint32_t RANS_PROB_SCALE = 1u << RANS_PROB_BITS;
+static constexpr uint32_t RANS_L = 1u << 23;
+
+// Quantise symbol counts to frequencies summing to RANS_PROB_SCALE; every
+// symbol that occurs keeps at least 1.
+static std::vector<uint32_t> rans_frequencies(const std::vector<uint8_t> &symbols) {
+    std::vector<uint64_t> counts(256, 0);
+    int nsym = 0;
+    for (uint8_t s : symbols) {
+        counts[s]++;
+        nsym = std::max(nsym, s + 1);
+    }
+    std::vector<uint32_t> freq(nsym, 0);
+    uint32_t total = 0;
+    for (int s = 0; s < nsym; s++) {
+        if (counts[s] == 0) continue;
+        freq[s] = static_cast<uint32_t>(
+            std::max<uint64_t>(1, counts[s] * RANS_PROB_SCALE / symbols.size()));
+        total += freq[s];
+    }
+    // The rounding error goes to (or comes from) the most frequent symbol
+    while (total != RANS_PROB_SCALE) {
+        auto largest = std::max_element(freq.begin(), freq.end());
+        if (total < RANS_PROB_SCALE) {
+            *largest += RANS_PROB_SCALE - total;
+            total = RANS_PROB_SCALE;
+        } else {
+            (*largest)--;
+            total--;
+        }
+    }
+    return freq;
+}
 
-// Atoms for option keys
-static auto atom_victoria_metrics = fine::Atom("victoria_metrics");
-static auto atom_is_counter = fine::Atom("is_counter");
-static auto atom_scale_decimals = fine::Atom("scale_decimals");
-static auto atom_algorithm = fine::Atom("algorithm");
-static auto atom_chimp = fine::Atom("chimp");
-static auto atom_chimp128 = fine::Atom("chimp128");
+static void rans_encode_stream(BitWriter &w, const std::vector<uint8_t> &symbols) {
+    w.write(symbols.size(), 32);
+    if (symbols.empty()) return;
 
-// Fast manual data + opts parsing to avoid FINE's variant/vector overhead
-static fine::Ok<ErlNifBinary>
-nif_gorilla_encode(ErlNifEnv *env,
-                   fine::Term data_term,
-                   fine::Term opts_term)
-{
-    // Parse the list of {timestamp, value} tuples manually
-    unsigned int list_len;
-    if (!enif_get_list_length(env, data_term, &list_len)) {
-        throw std::invalid_argument("expected a list");
+    auto freq = rans_frequencies(symbols);
+    std::vector<uint32_t> cum(freq.size() + 1, 0);
+    for (size_t s = 0; s < freq.size(); s++) cum[s + 1] = cum[s] + freq[s];
+
+    w.write(freq.size(), 8);
+    for (uint32_t f : freq) {
+        for (; f >= 0x80; f >>= 7) w.write((f & 0x7F) | 0x80, 8);
+        w.write(f, 8);
     }
 
-    if (list_len == 0) {
-        ErlNifBinary bin;
-        enif_alloc_binary(0, &bin);
-        return fine::Ok(bin);
+    // Coded back to front; a symbol emits at most two bytes
+    std::vector<uint8_t> buf(symbols.size() * 2 + 8);
+    uint8_t *end = buf.data() + buf.size();
+    uint8_t *ptr = end;
+    uint32_t state[2] = {RANS_L, RANS_L};
+    for (size_t i = symbols.size(); i-- > 0;) {
+        uint32_t &x = state[i & 1];
+        uint8_t s = symbols[i];
+        uint32_t x_max = ((RANS_L >> RANS_PROB_BITS) << 8) * freq[s];
+        while (x >= x_max) {
+            *--ptr = static_cast<uint8_t>(x);
+            x >>= 8;
+        }
+        x = ((x / freq[s]) << RANS_PROB_BITS) + (x % freq[s]) + cum[s];
+    }
+    for (int k = 1; k >= 0; k--) {
+        ptr -= 4;
+        for (int b = 0; b < 4; b++) ptr[b] = static_cast<uint8_t>(state[k] >> (8 * b));
     }
 
-    std::vector<int64_t> timestamps;
-    std::vector<double> values;
-    timestamps.reserve(list_len);
-    values.reserve(list_len);
+    w.write(static_cast<uint64_t>(end - ptr), 32);
+    for (; ptr < end; ptr++) w.write(*ptr, 8);
+}
 
-    ERL_NIF_TERM head, tail;
-    ERL_NIF_TERM list = data_term;
-    while (enif_get_list_cell(env, list, &head, &tail)) {
-        int arity;
-        const ERL_NIF_TERM *tuple;
-        if (!enif_get_tuple(env, head, &arity, &tuple) || arity != 2) {
-            throw std::invalid_argument("expected {timestamp, value} tuples");
+// Decode one stream at the (byte aligned) reader position into `out`.
+// Streams longer than max_count or with an alphabet over max_sym are
+// rejected before anything is allocated or decoded.
+static void rans_decode_stream(BitReader &r, size_t max_count, int max_sym, SymbolStream &out) {
+    uint32_t count = static_cast<uint32_t>(r.read(32));
+    out.symbols.clear();
+    out.pos = 0;
+    if (count == 0) return;
+    if (count > max_count) throw std::runtime_error("corrupt control stream");
+
+    int nsym = static_cast<int>(r.read(8));
+    if (nsym == 0 || nsym > max_sym) throw std::runtime_error("corrupt control stream");
+    uint32_t freq[256], cum[256];
+    uint32_t total = 0;
+    for (int s = 0; s < nsym; s++) {
+        uint32_t f = 0;
+        for (int shift = 0;; shift += 7) {
+            uint32_t byte = static_cast<uint32_t>(r.read(8));
+            if (shift > 7) throw std::runtime_error("corrupt control stream");
+            f |= (byte & 0x7F) << shift;
+            if (!(byte & 0x80)) break;
         }
+        cum[s] = total;
+        freq[s] = f;
+        total += f;
+    }
+    if (total != RANS_PROB_SCALE) throw std::runtime_error("corrupt control stream");
 
-        ErlNifSInt64 ts;
-        if (!enif_get_int64(env, tuple[0], &ts)) {
-            throw std::invalid_argument("timestamp must be an integer");
-        }
-        timestamps.push_back(static_cast<int64_t>(ts));
+    uint8_t slot_symbol[RANS_PROB_SCALE];
+    for (int s = 0; s < nsym; s++) {
+        std::fill(slot_symbol + cum[s], slot_symbol + cum[s] + freq[s], static_cast<uint8_t>(s));
+    }
 
-        double val;
-        if (!enif_get_double(env, tuple[1], &val)) {
-            // Try integer
-            ErlNifSInt64 ival;
-            if (!enif_get_int64(env, tuple[1], &ival)) {
-                throw std::invalid_argument("value must be a number");
-            }
-            val = static_cast<double>(ival);
+    size_t size = static_cast<size_t>(r.read(32));
+    if (size < 8 || size * 8 > r.remaining()) throw std::runtime_error("corrupt control stream");
+    const uint8_t *p = r.data() + r.position() / 8;
+    const uint8_t *end = p + size;
+    r.seek(r.position() + size * 8);
+
+    uint32_t x0 = 0, x1 = 0;
+    for (int b = 0; b < 4; b++) x0 |= static_cast<uint32_t>(p[b]) << (8 * b);
+    for (int b = 0; b < 4; b++) x1 |= static_cast<uint32_t>(p[4 + b]) << (8 * b);
+    p += 8;
+
+    auto step = [&](uint32_t &x) {
+        uint32_t slot = x & (RANS_PROB_SCALE - 1);
+        uint8_t s = slot_symbol[slot];
+        x = freq[s] * (x >> RANS_PROB_BITS) + slot - cum[s];
+        while (x < RANS_L) {
+            if (p == end) throw std::runtime_error("corrupt control stream");
+            x = (x << 8) | *p++;
         }
-        values.push_back(val);
+        return s;
+    };
+
+    out.symbols.resize(count);
+    uint8_t *sym = out.symbols.data();
+    uint32_t i = 0;
+    for (; i + 1 < count; i += 2) {
+        sym[i] = step(x0);
+        sym[i + 1] = step(x1);
+    }
+    if (i < count) sym[i] = step(x0);
+}
 
-        list = tail;
+// Inline size of the control symbols, which the rANS streams must beat.
+// `algorithm` holds the value algorithm flags of the chunk.
+static size_t control_plain_bits(const ControlStreams &c, uint32_t algorithm, int length_bits) {
+    size_t bits = 0;
+    for (uint8_t k : c.ts.symbols) bits += DOD_PREFIX_LEN[k];
+    for (uint8_t code : c.codes.symbols) {
+        if (algorithm & 0x2000) {
+            bits += 4;
+        } else if (algorithm & 0xC) {
+            bits += (code >> 3) & 1 ? 5 : 2;
+        } else {
+            bits += code == 0 ? 1 : code == 1 ? 2 : 7;
+        }
     }
+    return bits + c.lengths.symbols.size() * static_cast<size_t>(length_bits);
+}
 
-    // Parse options map manually
+static void encode_control_streams(BitWriter &w, const ControlStreams &c) {
+    rans_encode_stream(w, c.ts.symbols);
+    rans_encode_stream(w, c.codes.symbols);
+    rans_encode_stream(w, c.lengths.symbols);
+}
+
+// Streams of a chunk of `count` points with `flags`.
+static void decode_control_streams(BitReader &r, uint32_t count, uint32_t flags,
+                                   ControlStreams &c) {
+    bool chimp = (flags & (0xC | 0x2000)) != 0;  // Chimp and FPC codes fit 5 bits
+    int length_bits = (flags & 0x10) ? Float32Word::length_bits : Float64Word::length_bits;
+    rans_decode_stream(r, count, 5, c.ts);
+    rans_decode_stream(r, count, chimp ? 32 : 34, c.codes);
+    rans_decode_stream(r, count, 1 << length_bits, c.lengths);
+}
+
+// ---------------------------------------------------------------------------
+// Chunk encoding
+// ---------------------------------------------------------------------------
+
+struct EncodeOptions {
     bool vm_enabled = false;
     bool is_counter = false;
     bool use_chimp = false;
     bool use_chimp128 = false;
+    int chimp128_window = CHIMP128_DEFAULT_WINDOW;
+    bool use_fpc = false;
+    bool use_f32 = false;
     int scale_n = -1;  // -1 means :auto when vm_enabled
+    int mantissa_bits = -1;  // -1 means lossless
+    bool use_xxh3 = false;
+    TimestampCodec timestamp_codec = TimestampCodec::delta_of_delta;
+    bool entropy = false;  // rANS control streams, flag 0x1000
+    bool deterministic = false;  // creation_time 0, for byte-identical chunks
+};
 
-    ERL_NIF_TERM opt_val;
-    if (enif_get_map_value(env, opts_term,
-            fine::encode(env, atom_victoria_metrics), &opt_val)) {
-        vm_enabled = fine::decode<bool>(env, opt_val);
+// Fixed delta-of-delta buckets hold at most 32-bit deltas, which nanosecond
+// or sparse imported series can exceed. Switch those to adaptive buckets,
+// which are lossless at any width, rather than truncate; other codecs already
+// handle wide deltas.
+static void fit_timestamp_codec(EncodeOptions &opts, const int64_t *ts, size_t n) {
+    if (opts.timestamp_codec == TimestampCodec::delta_of_delta &&
+        dod_stream_bits(ts, n) == SIZE_MAX) {
+        opts.timestamp_codec = TimestampCodec::adaptive;
     }
-    if (enif_get_map_value(env, opts_term,
-            fine::encode(env, atom_is_counter), &opt_val)) {
-        is_counter = fine::decode<bool>(env, opt_val);
+}
+
+// Append a bitstream of nbits (MSB-aligned bytes) to a writer.
+static void append_bits(BitWriter &w, const std::vector<uint8_t> &bytes, size_t nbits) {
+    size_t full_bytes = nbits / 8;
+    int remaining = nbits % 8;
+    w.write_bytes(bytes.data(), full_bytes);
+    if (remaining > 0) {
+        // Write remaining bits from the last byte (MSB-aligned)
+        w.write(bytes[full_bytes] >> (8 - remaining), remaining);
     }
-    if (enif_get_map_value(env, opts_term,
-            fine::encode(env, atom_scale_decimals), &opt_val)) {
-        ErlNifSInt64 sval;
-        if (enif_get_int64(env, opt_val, &sval)) {
-            scale_n = static_cast<int>(sval);
+}
+
+// Encode values with the algorithm chosen in opts.
+template <typename Word>
+static ValueEncodeResult encode_value_stream(const std::vector<double> &values,
+                                             const EncodeOptions &opts,
+                                             ControlStreams *side = nullptr)
+{
+    if (opts.use_chimp128) {
+        switch (opts.chimp128_window) {
+            case 32:  return encode_values_chimp128<Word, 5>(values, side);
+            case 64:  return encode_values_chimp128<Word, 6>(values, side);
+            case 256: return encode_values_chimp128<Word, 8>(values, side);
+            default:  return encode_values_chimp128<Word, 7>(values, side);
         }
-        // else :auto → stays -1
     }
-    if (enif_get_map_value(env, opts_term,
-            fine::encode(env, atom_algorithm), &opt_val)) {
-        if (enif_is_identical(opt_val, fine::encode(env, atom_chimp))) {
-            use_chimp = true;
-        } else if (enif_is_identical(opt_val, fine::encode(env, atom_chimp128))) {
-            use_chimp128 = true;
+    if (opts.use_chimp) return encode_values_chimp<Word>(values, side);
+    if (opts.use_fpc) return encode_values_fpc<Word>(values, side);
+    return encode_values<Word>(values, opts.mantissa_bits >= 0, side);
+}
+
+static bool fits_float32(const std::vector<double> &values) {
+    for (double v : values) {
+        if (static_cast<double>(static_cast<float>(v)) != v && !std::isnan(v)) return false;
+    }
+    return true;
+}
+
+// Rounding and VM preprocessing of one series' values, in the order the
+// decoder undoes them. Returns the flags they set.
+static uint32_t preprocess_values(std::vector<double> &values, const EncodeOptions &opts,
+                                  uint32_t &scale_decimals)
+{
+    // Float32 series are single precision at the source; round once up front
+    // so VM preprocessing sees the values that will be stored.
+    if (opts.use_f32) {
+        for (double &v : values) v = static_cast<float>(v);
+    }
+
+    uint32_t flags = 0;
+
+    // Lossy mode rounds the inputs, again before VM preprocessing. The kept
+    // mantissa width goes in flag bits 16-21 next to the 0x20 lossy flag.
+    int max_mantissa = opts.use_f32 ? 23 : 52;
+    if (opts.mantissa_bits >= 0 && opts.mantissa_bits < max_mantissa) {
+        int keep = opts.mantissa_bits;
+        for (double &v : values) {
+            v = opts.use_f32 ? round_mantissa<float, uint32_t>(v, keep)
+                             : round_mantissa<double, uint64_t>(v, keep);
         }
+        flags |= 0x20 | (static_cast<uint32_t>(keep) << 16);
     }
 
     // VM preprocessing
-    uint32_t flags = 0;
-    uint32_t scale_decimals = 0;
+    scale_decimals = 0;
+    int scale_n = opts.scale_n;
 
-    if (vm_enabled) {
+    if (opts.vm_enabled) {
         flags |= 0x1;
 
-        if (is_counter) {
+        if (opts.is_counter) {
             flags |= 0x2;
             values = delta_encode_counter(values);
         }
@@ -1061,30 +2331,38 @@ nif_gorilla_encode(ErlNifEnv *env,
         scale_decimals = static_cast<uint32_t>(scale_n);
         values = scale_values(values, scale_n);
     }
+    return flags;
+}
 
-    bool v2 = vm_enabled || (is_counter && scale_decimals >= 0);
+// Flags of the value algorithm chosen in opts.
+static uint32_t algorithm_flags(const EncodeOptions &opts) {
+    if (opts.use_chimp128) {
+        // bit 3 = Chimp128, bits 10-11 = window size
+        return 0x8 | static_cast<uint32_t>(chimp128_window_code(opts.chimp128_window)) << 10;
+    }
+    if (opts.use_chimp) return 0x4; // bit 2 = Chimp
+    if (opts.use_fpc) return 0x2000; // bit 13 = FPC predictors
+    return 0;
+}
 
-    // Encode timestamps
-    auto ts_result = encode_timestamps(timestamps);
+// Pack the bitstreams of one series into a complete chunk: outer header,
+// inner header, timestamps, values, then the validity bitmap and control
+// streams when given.
+static std::vector<uint8_t> assemble_chunk(size_t n, const TimestampEncodeResult &ts_result,
+                                           const ValueEncodeResult &val_result,
+                                           const BitWriter *validity_writer,
+                                           const BitWriter *control_writer,
+                                           uint32_t flags, uint32_t scale_decimals,
+                                           const EncodeOptions &opts)
+{
+    bool v2 = opts.vm_enabled || opts.is_counter;
     size_t ts_bit_len = ts_result.writer.total_bits();
-
-    // Encode values — Gorilla, Chimp, or Chimp128
-    ValueEncodeResult val_result;
-    if (use_chimp128) {
-        val_result = encode_values_chimp128(values);
-        flags |= 0x8; // bit 3 = Chimp128
-    } else if (use_chimp) {
-        val_result = encode_values_chimp(values);
-        flags |= 0x4; // bit 2 = Chimp
-    } else {
-        val_result = encode_values(values);
-    }
     size_t val_bit_len = val_result.writer.total_bits();
 
     // Build inner header
     uint64_t first_value_bits = float_to_bits(val_result.first_value);
     auto inner_header = build_inner_header(
-        static_cast<uint32_t>(timestamps.size()),
+        static_cast<uint32_t>(n),
         ts_result.first_timestamp,
         first_value_bits,
         static_cast<int32_t>(ts_result.first_delta),
@@ -1105,30 +2383,12 @@ nif_gorilla_encode(ErlNifEnv *env,
         packed.write(b, 8);
     }
 
-    // Write timestamp bits
-    // Full bytes
-    if (ts_bit_len > 0) {
-        size_t full_bytes = ts_bit_len / 8;
-        int remaining = ts_bit_len % 8;
-        for (size_t i = 0; i < full_bytes; i++) {
-            packed.write(ts_bytes[i], 8);
-        }
-        if (remaining > 0) {
-            // Write remaining bits from the last byte (MSB-aligned)
-            packed.write(ts_bytes[full_bytes] >> (8 - remaining), remaining);
-        }
-    }
-
-    // Write value bits
-    if (val_bit_len > 0) {
-        size_t full_bytes = val_bit_len / 8;
-        int remaining = val_bit_len % 8;
-        for (size_t i = 0; i < full_bytes; i++) {
-            packed.write(val_bytes[i], 8);
-        }
-        if (remaining > 0) {
-            packed.write(val_bytes[full_bytes] >> (8 - remaining), remaining);
-        }
+    append_bits(packed, ts_bytes, ts_bit_len);
+    append_bits(packed, val_bytes, val_bit_len);
+    if (validity_writer) {
+        int validity_trailing;
+        append_bits(packed, validity_writer->to_bytes(validity_trailing),
+                    validity_writer->total_bits());
     }
 
     // Pad to byte boundary
@@ -1137,25 +2397,36 @@ nif_gorilla_encode(ErlNifEnv *env,
     if (pad_bits > 0) {
         packed.write(0, pad_bits);
     }
+    if (control_writer) {
+        append_bits(packed, control_writer->bytes(), control_writer->total_bits());
+    }
     total_bits = packed.total_bits();
 
     // Get packed data
     int packed_trailing;
     auto packed_data = packed.to_bytes(packed_trailing);
 
-    // Calculate CRC32 of packed data
-    uint32_t checksum = crc32(packed_data.data(), packed_data.size());
+    // Checksum of packed data: CRC32 in the v1 header field, or xxHash3 in
+    // a version 2 header (flag 0x80)
+    uint32_t checksum = 0;
+    std::optional<uint64_t> xxh3;
+    if (opts.use_xxh3) {
+        xxh3 = xxh3_64(packed_data.data(), packed_data.size());
+        flags |= 0x80; // bit 7 = xxHash3 checksum
+    } else {
+        checksum = crc32(packed_data.data(), packed_data.size());
+    }
 
     // Build outer header
-    int64_t creation_time = static_cast<int64_t>(time(nullptr));
+    int64_t creation_time = opts.deterministic ? 0 : static_cast<int64_t>(time(nullptr));
     uint32_t compressed_size = static_cast<uint32_t>(packed_data.size());
-    uint32_t count = static_cast<uint32_t>(timestamps.size());
+    uint32_t count = static_cast<uint32_t>(n);
     uint32_t original_size = count * 16;
     double compression_ratio = original_size > 0
         ? static_cast<double>(compressed_size) / static_cast<double>(original_size)
         : 0.0;
 
-    auto outer_header = build_outer_header(
+    auto chunk = build_outer_header(
         count,
         compressed_size,
         checksum,
@@ -1169,287 +2440,3871 @@ nif_gorilla_encode(ErlNifEnv *env,
         creation_time,
         flags,
         scale_decimals,
-        v2);
+        v2,
+        xxh3);
 
     // Combine outer header + packed data
-    size_t total_size = outer_header.size() + packed_data.size();
-    ErlNifBinary result_bin;
-    enif_alloc_binary(total_size, &result_bin);
-    memcpy(result_bin.data, outer_header.data(), outer_header.size());
-    memcpy(result_bin.data + outer_header.size(), packed_data.data(), packed_data.size());
-
-    return fine::Ok(result_bin);
+    chunk.insert(chunk.end(), packed_data.begin(), packed_data.end());
+    return chunk;
 }
-FINE_NIF(nif_gorilla_encode, ERL_NIF_DIRTY_JOB_CPU_BOUND);
-
-// ---------------------------------------------------------------------------
-// Decode helpers
-// ---------------------------------------------------------------------------
 
-static int64_t decode_first_delta(BitReader &reader) {
-    uint64_t bit = reader.read_bit();
-    if (bit == 0) return 0;
-
-    bit = reader.read_bit();
-    if (bit == 0) return reader.read_signed(7);
+// Timestamp codec flags of an encoded timestamp stream.
+static uint32_t timestamp_flags(const TimestampEncodeResult &ts_result) {
+    if (ts_result.block) return 0x100;    // bit 8 = block timestamps
+    if (ts_result.adaptive) return 0x200; // bit 9 = adaptive delta-of-delta buckets
+    return 0;
+}
 
-    bit = reader.read_bit();
-    if (bit == 0) return reader.read_signed(9);
+// Encode one series into a complete chunk: outer header + packed payload.
+// `values` is taken by value because VM preprocessing rewrites it. When
+// `validity` is given (n entries, 0 = missing) and marks any point missing,
+// only the present values are encoded and the bitmap follows them.
+static std::vector<uint8_t> encode_chunk_impl(const int64_t *timestamps, size_t n,
+                                              std::vector<double> values,
+                                              const EncodeOptions &opts,
+                                              const uint8_t *validity)
+{
+    if (n == 0) return {};
 
-    bit = reader.read_bit();
-    if (bit == 0) return reader.read_signed(12);
+    // algorithm: 0 = Gorilla, 1 = Chimp, 2 = Chimp128, 3 = FPC
+    GORILLA_PROBE2(encode__start, n,
+                   opts.use_fpc ? 3 : opts.use_chimp128 ? 2 : opts.use_chimp ? 1 : 0);
 
-    return reader.read_signed(32);
-}
+    bool sparse = validity && std::find(validity, validity + n, 0) != validity + n;
+    if (sparse) {
+        size_t present = 0;
+        for (size_t i = 0; i < n; i++) {
+            if (validity[i]) values[present++] = values[i];
+        }
+        values.resize(present);
+    }
 
-static int64_t decode_delta_of_delta(BitReader &reader) {
-    uint64_t bit = reader.read_bit();
-    if (bit == 0) return 0;
+    uint32_t scale_decimals;
+    uint32_t flags = preprocess_values(values, opts, scale_decimals);
 
-    bit = reader.read_bit();
-    if (bit == 0) return reader.read_signed(7);
+    // Control symbols go to side streams when the chunk is entropy coded
+    ControlStreams control;
+    ControlStreams *side = opts.entropy ? &control : nullptr;
 
-    bit = reader.read_bit();
-    if (bit == 0) return reader.read_signed(9);
+    // Encode timestamps
+    auto ts_result = encode_timestamps(timestamps, n, opts.timestamp_codec, side);
+    flags |= timestamp_flags(ts_result);
+    GORILLA_PROBE2(encode__timestamps, n, ts_result.writer.total_bits());
 
-    bit = reader.read_bit();
-    if (bit == 0) return reader.read_signed(12);
+    // Float32 words only when every (preprocessed) value survives the
+    // narrowing; VM scaling can produce integers beyond float precision.
+    bool use_f32 = opts.use_f32 && fits_float32(values);
 
-    return reader.read_signed(32);
-}
+    // Encode values — Gorilla, Chimp, or Chimp128
+    auto encode_values_with = [&](ControlStreams *s) {
+        return use_f32 ? encode_value_stream<Float32Word>(values, opts, s)
+                       : encode_value_stream<Float64Word>(values, opts, s);
+    };
+    ValueEncodeResult val_result = encode_values_with(side);
+    if (use_f32) {
+        flags |= 0x10; // bit 4 = float32 values
+    }
+    flags |= algorithm_flags(opts);
+
+    // Keep the rANS streams only when they beat the inline control bits,
+    // which short chunks and flat distributions rarely do; otherwise encode
+    // both bitstreams again the plain way.
+    BitWriter control_writer;
+    if (side) {
+        encode_control_streams(control_writer, control);
+        int length_bits = use_f32 ? Float32Word::length_bits : Float64Word::length_bits;
+        if (control_writer.total_bits() <
+            control_plain_bits(control, algorithm_flags(opts), length_bits)) {
+            flags |= 0x1000; // bit 12 = rANS control streams
+        } else {
+            side = nullptr;
+            ts_result = encode_timestamps(timestamps, n, opts.timestamp_codec);
+            val_result = encode_values_with(nullptr);
+        }
+    }
+    GORILLA_PROBE3(encode__values, values.size(), val_result.writer.total_bits(), flags);
+
+    BitWriter validity_writer;
+    if (sparse) {
+        encode_validity(validity_writer, validity, n);
+        flags |= 0x40; // bit 6 = validity bitmap
+    }
+
+    auto chunk = assemble_chunk(n, ts_result, val_result, sparse ? &validity_writer : nullptr,
+                                side ? &control_writer : nullptr, flags, scale_decimals, opts);
+    GORILLA_PROBE3(encode__done, n, flags, chunk.size());
+    return chunk;
+}
+
+#define GORILLA_ENCODE_VARIANT(tag, arch)                                               \
+    __attribute__((target(arch), flatten))                                              \
+    static std::vector<uint8_t> encode_chunk_##tag(const int64_t *timestamps, size_t n, \
+                                                   std::vector<double> values,          \
+                                                   const EncodeOptions &opts,           \
+                                                   const uint8_t *validity) {           \
+        return encode_chunk_impl(timestamps, n, std::move(values), opts, validity);     \
+    }
+GORILLA_ISA_VARIANTS(GORILLA_ENCODE_VARIANT)
+#undef GORILLA_ENCODE_VARIANT
+
+static std::vector<uint8_t> encode_chunk(const int64_t *timestamps, size_t n,
+                                         std::vector<double> values,
+                                         const EncodeOptions &opts,
+                                         const uint8_t *validity = nullptr)
+{
+    switch (selected_isa()) {
+#define GORILLA_ENCODE_CASE(tag, arch) \
+    case Isa::tag: return encode_chunk_##tag(timestamps, n, std::move(values), opts, validity);
+    GORILLA_ISA_VARIANTS(GORILLA_ENCODE_CASE)
+#undef GORILLA_ENCODE_CASE
+    default: return encode_chunk_impl(timestamps, n, std::move(values), opts, validity);
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Lockstep batch encoding
+// ---------------------------------------------------------------------------
+//
+// Collectors emit groups of series on one clock. Their timestamps are encoded
+// once, and the Gorilla value streams of up to LOCKSTEP_LANES series advance
+// together one point at a time: XORs, leading/trailing zero counts and window
+// decisions for every lane are branch-free fixed-length loops over lane
+// arrays, which the AVX2 and AVX-512 variants vectorise, and only the bit
+// writes are scattered to each series' own writer. Every chunk is
+// byte-identical to encoding it alone.
+
+static constexpr size_t LOCKSTEP_LANES = 16;
+
+// Leading zeros of a 64-bit word (64 for 0) for the lane loops. AVX2 has no
+// vector lzcnt, so on x86 this is a select-only binary search the AVX2 and
+// AVX-512 variants can vectorise; elsewhere the scalar instruction wins.
+static inline int lane_leading_zeros_64(uint64_t x) {
+#if defined(__x86_64__) || defined(_M_X64)
+    int n = 0;
+    int t;
+    t = (x >> 32) == 0; n += t << 5; x = t ? x << 32 : x;
+    t = (x >> 48) == 0; n += t << 4; x = t ? x << 16 : x;
+    t = (x >> 56) == 0; n += t << 3; x = t ? x << 8 : x;
+    t = (x >> 60) == 0; n += t << 2; x = t ? x << 4 : x;
+    t = (x >> 62) == 0; n += t << 1; x = t ? x << 2 : x;
+    t = (x >> 63) == 0; n += t;      x = t ? x << 1 : x;
+    return n + static_cast<int>((x >> 63) == 0);
+#else
+    return count_leading_zeros_64(x);
+#endif
+}
+
+// Gorilla-encode `lanes` (at most LOCKSTEP_LANES) equal-length series into
+// results[0..lanes). Unused lanes repeat lane 0 and are never written out.
+// Each lane packs its bits into a 64-bit accumulator flushed a word at a
+// time into a buffer sized for the worst case, instead of a BitWriter.
+template <typename Word>
+static void encode_values_lockstep(const std::vector<double> *const *values, size_t lanes,
+                                   bool fresh_window, ValueEncodeResult *results)
+{
+    constexpr int W = Word::bits;
+    constexpr size_t L = LOCKSTEP_LANES;
+    const size_t n = values[0]->size();
+
+    const double *src[L];
+    alignas(64) uint64_t prev[L];
+    alignas(64) int32_t prev_leading[L];
+    alignas(64) int32_t prev_trailing[L];
+    for (size_t l = 0; l < L; l++) {
+        src[l] = values[l < lanes ? l : 0]->data();
+        prev[l] = Word::to_bits(src[l][0]);
+        prev_leading[l] = fresh_window ? W : 0;  // W leaves an empty window
+        prev_trailing[l] = 0;
+    }
+
+    // At most W bits for the first value and 7 + length_bits + W per XOR,
+    // plus a word of slack for the final flush
+    size_t max_bytes = (W + (n - 1) * (7 + Word::length_bits + W)) / 8 + 16;
+    std::vector<uint8_t> buffers[L];
+    uint8_t *out[L];
+    uint64_t acc[L] = {};  // pending bits, MSB-aligned
+    int fill[L] = {};
+
+    auto put = [&](size_t l, uint64_t v, int nbits) {
+        if (nbits == 0) return;
+        int total = fill[l] + nbits;
+        if (total < 64) {
+            acc[l] |= v << (64 - total);
+            fill[l] = total;
+        } else {
+            int rem = total - 64;
+            store_be64(out[l], acc[l] | (v >> rem));
+            out[l] += 8;
+            acc[l] = rem ? v << (64 - rem) : 0;
+            fill[l] = rem;
+        }
+    };
+
+    for (size_t l = 0; l < lanes; l++) {
+        buffers[l].resize(max_bytes);
+        out[l] = buffers[l].data();
+        results[l].count = n;
+        results[l].first_value = Word::from_bits(prev[l]);
+        put(l, prev[l], W);
+    }
+
+    // Per point and lane: a control code of ctrl_bits, then `width` bits of
+    // the XOR starting at `shift` (width 0 for an identical value)
+    alignas(64) uint64_t xor_val[L];
+    alignas(64) uint64_t ctrl[L];
+    alignas(64) int32_t ctrl_bits[L];
+    alignas(64) int32_t shift[L];
+    alignas(64) int32_t width[L];
+
+    for (size_t i = 1; i < n; i++) {
+        for (size_t l = 0; l < L; l++) {
+            uint64_t curr = Word::to_bits(src[l][i]);
+            xor_val[l] = curr ^ prev[l];
+            prev[l] = curr;
+        }
+
+        // Branch-free so the per-ISA variants vectorise it: the counts are
+        // garbage for x == 0, but an identical value never reads them
+        for (size_t l = 0; l < L; l++) {
+            uint64_t x = xor_val[l];
+            int leading = lane_leading_zeros_64(x) - (64 - W);
+            int trailing = 63 - lane_leading_zeros_64(x & (~x + 1));
+            int pl = prev_leading[l];
+            int pt = prev_trailing[l];
+            bool zero = x == 0;
+            bool reuse = !zero & (leading >= pl) & (trailing >= pt) & ((W - pl - pt) > 0);
+            bool fresh = !zero & !reuse;
+
+            // New window: '11' + 5 bits leading + (length-1) + meaningful bits
+            int adj_leading = leading < 31 ? leading : 31;
+            int meaningful = W - leading - trailing;
+            int adj_meaningful = meaningful > 1 ? meaningful : 1;
+            uint64_t header = (uint64_t(0b11) << (5 + Word::length_bits)) |
+                              (uint64_t(adj_leading) << Word::length_bits) |
+                              uint64_t(adj_meaningful - 1);
+
+            // Identical: '0'; reuse: '10' + meaningful bits of the old window
+            ctrl[l] = fresh ? header : reuse ? 0b10 : 0;
+            ctrl_bits[l] = fresh ? 7 + Word::length_bits : reuse ? 2 : 1;
+            shift[l] = fresh ? trailing : reuse ? pt : 0;
+            width[l] = fresh ? adj_meaningful : reuse ? W - pl - pt : 0;
+            prev_leading[l] = fresh ? adj_leading : pl;
+            prev_trailing[l] = fresh ? trailing : pt;
+        }
+
+        for (size_t l = 0; l < lanes; l++) {
+            put(l, ctrl[l], ctrl_bits[l]);
+            put(l, (xor_val[l] >> shift[l]) & bitmask(width[l]), width[l]);
+        }
+    }
+
+    for (size_t l = 0; l < lanes; l++) {
+        size_t nbits = static_cast<size_t>(out[l] - buffers[l].data()) * 8 + fill[l];
+        store_be64(out[l], acc[l]);
+        results[l].writer = BitWriter(std::move(buffers[l]), nbits);
+    }
+}
+
+// Encode series sharing one timestamp column into one chunk each. A series
+// with a non-empty validity vector (0 = missing) is sparse. Gorilla series
+// without gaps or entropy coding go through the lockstep encoder; the rest,
+// and every series of Chimp or Chimp128 batches, are encoded one at a time.
+static std::vector<std::vector<uint8_t>>
+encode_batch_impl(const int64_t *timestamps, size_t n,
+                  std::vector<std::vector<double>> &series,
+                  const std::vector<std::vector<uint8_t>> &validity,
+                  const EncodeOptions &opts)
+{
+    std::vector<std::vector<uint8_t>> chunks(series.size());
+    if (n == 0) return chunks;
+
+    bool lockstep = !opts.use_chimp && !opts.use_chimp128 && !opts.use_fpc && !opts.entropy;
+
+    // Lockstep series split by word size, with their preprocessing results
+    std::vector<size_t> groups[2];  // 0 = float64, 1 = float32
+    std::vector<uint32_t> flags(series.size(), 0);
+    std::vector<uint32_t> scale_decimals(series.size(), 0);
+    for (size_t s = 0; s < series.size(); s++) {
+        if (!lockstep || !validity[s].empty()) {
+            chunks[s] = encode_chunk_impl(timestamps, n, std::move(series[s]), opts,
+                                          validity[s].empty() ? nullptr : validity[s].data());
+            continue;
+        }
+        flags[s] = preprocess_values(series[s], opts, scale_decimals[s]);
+        bool use_f32 = opts.use_f32 && fits_float32(series[s]);
+        if (use_f32) {
+            flags[s] |= 0x10; // bit 4 = float32 values
+        }
+        groups[use_f32].push_back(s);
+    }
+
+    size_t lockstep_series = groups[0].size() + groups[1].size();
+    GORILLA_PROBE3(encode__batch, series.size(), n, lockstep_series);
+    if (lockstep_series == 0) return chunks;
+
+    auto ts_result = encode_timestamps(timestamps, n, opts.timestamp_codec);
+    uint32_t shared_flags = timestamp_flags(ts_result) | algorithm_flags(opts);
+    bool fresh_window = opts.mantissa_bits >= 0;
+
+    for (int f32 = 0; f32 < 2; f32++) {
+        const auto &group = groups[f32];
+        for (size_t base = 0; base < group.size(); base += LOCKSTEP_LANES) {
+            size_t lanes = std::min(LOCKSTEP_LANES, group.size() - base);
+            const std::vector<double> *lane_values[LOCKSTEP_LANES];
+            for (size_t l = 0; l < lanes; l++) lane_values[l] = &series[group[base + l]];
+
+            ValueEncodeResult results[LOCKSTEP_LANES];
+            if (f32) {
+                encode_values_lockstep<Float32Word>(lane_values, lanes, fresh_window, results);
+            } else {
+                encode_values_lockstep<Float64Word>(lane_values, lanes, fresh_window, results);
+            }
+
+            for (size_t l = 0; l < lanes; l++) {
+                size_t s = group[base + l];
+                chunks[s] = assemble_chunk(n, ts_result, results[l], nullptr, nullptr,
+                                           flags[s] | shared_flags, scale_decimals[s], opts);
+                GORILLA_PROBE3(encode__done, n, flags[s] | shared_flags, chunks[s].size());
+            }
+        }
+    }
+    return chunks;
+}
+
+#define GORILLA_BATCH_VARIANT(tag, arch)                                                 \
+    __attribute__((target(arch), flatten))                                               \
+    static std::vector<std::vector<uint8_t>> encode_batch_##tag(                         \
+        const int64_t *timestamps, size_t n, std::vector<std::vector<double>> &series,   \
+        const std::vector<std::vector<uint8_t>> &validity, const EncodeOptions &opts) {  \
+        return encode_batch_impl(timestamps, n, series, validity, opts);                 \
+    }
+GORILLA_ISA_VARIANTS(GORILLA_BATCH_VARIANT)
+#undef GORILLA_BATCH_VARIANT
+
+static std::vector<std::vector<uint8_t>>
+encode_batch(const int64_t *timestamps, size_t n, std::vector<std::vector<double>> &series,
+             const std::vector<std::vector<uint8_t>> &validity, const EncodeOptions &opts)
+{
+    switch (selected_isa()) {
+#define GORILLA_BATCH_CASE(tag, arch) \
+    case Isa::tag: return encode_batch_##tag(timestamps, n, series, validity, opts);
+    GORILLA_ISA_VARIANTS(GORILLA_BATCH_CASE)
+#undef GORILLA_BATCH_CASE
+    default: return encode_batch_impl(timestamps, n, series, validity, opts);
+    }
+}
+
+// Copy an encoded chunk into a fresh binary owned by the caller.
+static ErlNifBinary chunk_to_binary(const std::vector<uint8_t> &chunk) {
+    ErlNifBinary bin;
+    if (!enif_alloc_binary(chunk.size(), &bin)) {
+        throw std::runtime_error("failed to allocate binary");
+    }
+    if (!chunk.empty()) {
+        memcpy(bin.data, chunk.data(), chunk.size());
+    }
+    return bin;
+}
+
+// ---------------------------------------------------------------------------
+// Rollup sidecars
+// ---------------------------------------------------------------------------
+//
+// Aggregates per aligned time window, computed from the points in the same
+// call that encodes them, so long-range queries never touch the bitstreams.
+// One sidecar per window width, stored next to the chunk (all integers and
+// floats big-endian):
+//
+//   magic   : 32   "GSR1"
+//   window  : 64   width in timestamp units
+//   buckets : 32
+//   then per bucket, 44 bytes:
+//     start : 64   signed, a multiple of the window
+//     count : 32
+//     min, max, sum, last : float-64 each
+//
+// Missing (nil) points are left out. A new bucket starts whenever a point
+// falls in a different window than the one before, so ascending timestamps
+// give one bucket per window.
+
+static const uint32_t ROLLUP_MAGIC = 0x47535231; // "GSR1"
+static const size_t ROLLUP_HEADER_BYTES = 16;
+static const size_t ROLLUP_BUCKET_BYTES = 44;
+
+struct RollupBucket {
+    int64_t start;
+    uint32_t count;
+    double min, max, sum, last;
+};
+
+static void store_be_double(uint8_t *p, double v) {
+    uint64_t bits;
+    memcpy(&bits, &v, sizeof(bits));
+    store_be64(p, bits);
+}
+
+static std::vector<uint8_t> build_rollup(const int64_t *timestamps, const double *values,
+                                         const uint8_t *validity, size_t n, int64_t window)
+{
+    std::vector<uint8_t> out(ROLLUP_HEADER_BYTES);
+    store_be32(out.data(), ROLLUP_MAGIC);
+    store_be64(out.data() + 4, static_cast<uint64_t>(window));
+
+    uint32_t buckets = 0;
+    RollupBucket b{};
+    auto flush = [&]() {
+        size_t at = out.size();
+        out.resize(at + ROLLUP_BUCKET_BYTES);
+        uint8_t *p = out.data() + at;
+        store_be64(p, static_cast<uint64_t>(b.start));
+        store_be32(p + 8, b.count);
+        store_be_double(p + 12, b.min);
+        store_be_double(p + 20, b.max);
+        store_be_double(p + 28, b.sum);
+        store_be_double(p + 36, b.last);
+        buckets++;
+    };
+
+    for (size_t i = 0; i < n; i++) {
+        if (validity && !validity[i]) continue;
+        double v = values[i];
+        int64_t offset = timestamps[i] % window;
+        if (offset < 0) offset += window;
+        int64_t start = timestamps[i] - offset;
+
+        if (b.count == 0 || start != b.start) {
+            if (b.count > 0) flush();
+            b = {start, 0, v, v, 0.0, v};
+        }
+        b.count++;
+        b.min = std::min(b.min, v);
+        b.max = std::max(b.max, v);
+        b.sum += v;
+        b.last = v;
+    }
+    if (b.count > 0) flush();
+
+    store_be32(out.data() + 12, buckets);
+    return out;
+}
+
+// ---------------------------------------------------------------------------
+// Encode NIF
+// ---------------------------------------------------------------------------
+
+// Atoms for option keys
+static auto atom_victoria_metrics = fine::Atom("victoria_metrics");
+static auto atom_is_counter = fine::Atom("is_counter");
+static auto atom_scale_decimals = fine::Atom("scale_decimals");
+static auto atom_algorithm = fine::Atom("algorithm");
+static auto atom_chimp = fine::Atom("chimp");
+static auto atom_chimp128 = fine::Atom("chimp128");
+static auto atom_fpc = fine::Atom("fpc");
+static auto atom_value_type = fine::Atom("value_type");
+static auto atom_f32 = fine::Atom("f32");
+static auto atom_mantissa_bits = fine::Atom("mantissa_bits");
+static auto atom_max_relative_error = fine::Atom("max_relative_error");
+static auto atom_nil = fine::Atom("nil");
+static auto atom_checksum = fine::Atom("checksum");
+static auto atom_xxh3 = fine::Atom("xxh3");
+static auto atom_timestamp_codec = fine::Atom("timestamp_codec");
+static auto atom_block = fine::Atom("block");
+static auto atom_auto = fine::Atom("auto");
+static auto atom_adaptive = fine::Atom("adaptive");
+static auto atom_chimp128_window = fine::Atom("chimp128_window");
+static auto atom_entropy = fine::Atom("entropy");
+static auto atom_rans = fine::Atom("rans");
+static auto atom_deterministic = fine::Atom("deterministic");
+
+// Parse the encode options map shared by every encoding NIF
+static EncodeOptions parse_encode_options(ErlNifEnv *env, ERL_NIF_TERM opts_term) {
+    EncodeOptions opts;
+
+    ERL_NIF_TERM opt_val;
+    if (enif_get_map_value(env, opts_term,
+            fine::encode(env, atom_victoria_metrics), &opt_val)) {
+        opts.vm_enabled = fine::decode<bool>(env, opt_val);
+    }
+    if (enif_get_map_value(env, opts_term,
+            fine::encode(env, atom_is_counter), &opt_val)) {
+        opts.is_counter = fine::decode<bool>(env, opt_val);
+    }
+    if (enif_get_map_value(env, opts_term,
+            fine::encode(env, atom_scale_decimals), &opt_val)) {
+        ErlNifSInt64 sval;
+        if (enif_get_int64(env, opt_val, &sval)) {
+            opts.scale_n = static_cast<int>(sval);
+        }
+        // else :auto → stays -1
+    }
+    if (enif_get_map_value(env, opts_term,
+            fine::encode(env, atom_algorithm), &opt_val)) {
+        if (enif_is_identical(opt_val, fine::encode(env, atom_chimp))) {
+            opts.use_chimp = true;
+        } else if (enif_is_identical(opt_val, fine::encode(env, atom_chimp128))) {
+            opts.use_chimp128 = true;
+        } else if (enif_is_identical(opt_val, fine::encode(env, atom_fpc))) {
+            opts.use_fpc = true;
+        }
+    }
+    if (enif_get_map_value(env, opts_term,
+            fine::encode(env, atom_chimp128_window), &opt_val)) {
+        int window;
+        if (!enif_get_int(env, opt_val, &window) || chimp128_window_code(window) < 0) {
+            throw std::invalid_argument("chimp128_window must be 32, 64, 128 or 256");
+        }
+        opts.chimp128_window = window;
+    }
+    if (enif_get_map_value(env, opts_term,
+            fine::encode(env, atom_value_type), &opt_val)) {
+        opts.use_f32 = enif_is_identical(opt_val, fine::encode(env, atom_f32));
+    }
+    if (enif_get_map_value(env, opts_term,
+            fine::encode(env, atom_mantissa_bits), &opt_val)) {
+        ErlNifSInt64 bits;
+        if (enif_get_int64(env, opt_val, &bits)) {
+            opts.mantissa_bits = static_cast<int>(std::clamp<ErlNifSInt64>(bits, 0, 52));
+        }
+    }
+    if (enif_get_map_value(env, opts_term,
+            fine::encode(env, atom_max_relative_error), &opt_val)) {
+        double max_error;
+        if (enif_get_double(env, opt_val, &max_error)) {
+            // The tighter of the two settings wins
+            opts.mantissa_bits = std::max(opts.mantissa_bits, mantissa_bits_for_error(max_error));
+        }
+    }
+    if (enif_get_map_value(env, opts_term,
+            fine::encode(env, atom_checksum), &opt_val)) {
+        opts.use_xxh3 = enif_is_identical(opt_val, fine::encode(env, atom_xxh3));
+    }
+    if (enif_get_map_value(env, opts_term,
+            fine::encode(env, atom_timestamp_codec), &opt_val)) {
+        if (enif_is_identical(opt_val, fine::encode(env, atom_block))) {
+            opts.timestamp_codec = TimestampCodec::block;
+        } else if (enif_is_identical(opt_val, fine::encode(env, atom_auto))) {
+            opts.timestamp_codec = TimestampCodec::automatic;
+        } else if (enif_is_identical(opt_val, fine::encode(env, atom_adaptive))) {
+            opts.timestamp_codec = TimestampCodec::adaptive;
+        }
+    }
+    if (enif_get_map_value(env, opts_term,
+            fine::encode(env, atom_entropy), &opt_val)) {
+        opts.entropy = enif_is_identical(opt_val, fine::encode(env, atom_rans));
+    }
+    if (enif_get_map_value(env, opts_term,
+            fine::encode(env, atom_deterministic), &opt_val)) {
+        opts.deterministic = fine::decode<bool>(env, opt_val);
+    }
+
+    return opts;
+}
+
+// Read one point value, a float or an integer. A nil value is a missing
+// point: it keeps its timestamp and is marked in the validity bitmap, so
+// false is returned and `val` is 0.0.
+static bool get_point_value(ErlNifEnv *env, ERL_NIF_TERM term, ERL_NIF_TERM nil, double &val) {
+    val = 0.0;
+    if (enif_is_identical(term, nil)) return false;
+    if (!enif_get_double(env, term, &val)) {
+        // Try integer
+        ErlNifSInt64 ival;
+        if (!enif_get_int64(env, term, &ival)) {
+            throw std::invalid_argument("value must be a number or nil");
+        }
+        val = static_cast<double>(ival);
+    }
+    return true;
+}
+
+// Parse the list of {timestamp, value} tuples manually, to avoid FINE's
+// variant/vector overhead. Returns true when some value is nil; `validity`
+// then marks the present points.
+static bool parse_points(ErlNifEnv *env, ERL_NIF_TERM data_term,
+                         std::vector<int64_t> &timestamps, std::vector<double> &values,
+                         std::vector<uint8_t> &validity)
+{
+    unsigned int list_len;
+    if (!enif_get_list_length(env, data_term, &list_len)) {
+        throw std::invalid_argument("expected a list");
+    }
+
+    timestamps.reserve(list_len);
+    values.reserve(list_len);
+    validity.reserve(list_len);
+
+    ERL_NIF_TERM nil = fine::encode(env, atom_nil);
+    bool sparse = false;
+
+    ERL_NIF_TERM head, tail;
+    ERL_NIF_TERM list = data_term;
+    while (enif_get_list_cell(env, list, &head, &tail)) {
+        int arity;
+        const ERL_NIF_TERM *tuple;
+        if (!enif_get_tuple(env, head, &arity, &tuple) || arity != 2) {
+            throw std::invalid_argument("expected {timestamp, value} tuples");
+        }
+
+        ErlNifSInt64 ts;
+        if (!enif_get_int64(env, tuple[0], &ts)) {
+            throw std::invalid_argument("timestamp must be an integer");
+        }
+        timestamps.push_back(static_cast<int64_t>(ts));
+
+        double val;
+        bool missing = !get_point_value(env, tuple[1], nil, val);
+        sparse |= missing;
+        values.push_back(val);
+        validity.push_back(missing ? 0 : 1);
+
+        list = tail;
+    }
+    return sparse;
+}
+
+static fine::Ok<ErlNifBinary>
+nif_gorilla_encode(ErlNifEnv *env,
+                   fine::Term data_term,
+                   fine::Term opts_term)
+{
+    std::vector<int64_t> timestamps;
+    std::vector<double> values;
+    std::vector<uint8_t> validity;
+    bool sparse = parse_points(env, data_term, timestamps, values, validity);
+
+    if (timestamps.empty()) {
+        ErlNifBinary bin;
+        enif_alloc_binary(0, &bin);
+        return fine::Ok(bin);
+    }
+
+    EncodeOptions opts = parse_encode_options(env, opts_term);
+    auto chunk = encode_chunk(timestamps.data(), timestamps.size(), std::move(values), opts,
+                              sparse ? validity.data() : nullptr);
+    return fine::Ok(chunk_to_binary(chunk));
+}
+FINE_NIF(nif_gorilla_encode, ERL_NIF_DIRTY_JOB_CPU_BOUND);
+
+// Encode like nif_gorilla_encode and build one rollup sidecar per window
+// width, in the order given. The rollups see the values as passed in,
+// before any scaling or lossy rounding of the encoder.
+static fine::Ok<std::tuple<ErlNifBinary, std::vector<ErlNifBinary>>>
+nif_gorilla_encode_rollups(ErlNifEnv *env,
+                           fine::Term data_term,
+                           fine::Term opts_term,
+                           std::vector<int64_t> windows)
+{
+    for (int64_t window : windows) {
+        if (window <= 0) throw std::invalid_argument("rollup windows must be positive");
+    }
+
+    std::vector<int64_t> timestamps;
+    std::vector<double> values;
+    std::vector<uint8_t> validity;
+    bool sparse = parse_points(env, data_term, timestamps, values, validity);
+    size_t n = timestamps.size();
+
+    std::vector<ErlNifBinary> rollups;
+    for (int64_t window : windows) {
+        rollups.push_back(chunk_to_binary(build_rollup(
+            timestamps.data(), values.data(), sparse ? validity.data() : nullptr, n, window)));
+    }
+
+    std::vector<uint8_t> chunk;
+    if (n > 0) {
+        EncodeOptions opts = parse_encode_options(env, opts_term);
+        chunk = encode_chunk(timestamps.data(), n, std::move(values), opts,
+                             sparse ? validity.data() : nullptr);
+    }
+    return fine::Ok(std::make_tuple(chunk_to_binary(chunk), rollups));
+}
+FINE_NIF(nif_gorilla_encode_rollups, ERL_NIF_DIRTY_JOB_CPU_BOUND);
+
+// Encode several series that share one timestamp list into one chunk each,
+// in input order. Every value list must be as long as the timestamp list.
+static fine::Ok<std::vector<ErlNifBinary>>
+nif_gorilla_encode_batch(ErlNifEnv *env,
+                         fine::Term timestamps_term,
+                         fine::Term series_term,
+                         fine::Term opts_term)
+{
+    unsigned int n;
+    if (!enif_get_list_length(env, timestamps_term, &n)) {
+        throw std::invalid_argument("expected a list of timestamps");
+    }
+
+    std::vector<int64_t> timestamps;
+    timestamps.reserve(n);
+    ERL_NIF_TERM head, tail;
+    ERL_NIF_TERM list = timestamps_term;
+    while (enif_get_list_cell(env, list, &head, &tail)) {
+        ErlNifSInt64 ts;
+        if (!enif_get_int64(env, head, &ts)) {
+            throw std::invalid_argument("timestamp must be an integer");
+        }
+        timestamps.push_back(static_cast<int64_t>(ts));
+        list = tail;
+    }
+
+    ERL_NIF_TERM nil = fine::encode(env, atom_nil);
+    std::vector<std::vector<double>> series;
+    std::vector<std::vector<uint8_t>> validity;
+
+    ERL_NIF_TERM series_list = series_term;
+    while (enif_get_list_cell(env, series_list, &head, &tail)) {
+        unsigned int len;
+        if (!enif_get_list_length(env, head, &len)) {
+            throw std::invalid_argument("expected a list of value lists");
+        }
+        if (len != n) {
+            throw std::invalid_argument("every series must have one value per timestamp");
+        }
+
+        std::vector<double> values;
+        std::vector<uint8_t> valid;
+        values.reserve(n);
+        valid.reserve(n);
+        bool sparse = false;
+
+        ERL_NIF_TERM value_head, value_tail;
+        ERL_NIF_TERM values_list = head;
+        while (enif_get_list_cell(env, values_list, &value_head, &value_tail)) {
+            double val;
+            bool present = get_point_value(env, value_head, nil, val);
+            sparse |= !present;
+            values.push_back(val);
+            valid.push_back(present ? 1 : 0);
+            values_list = value_tail;
+        }
+
+        series.push_back(std::move(values));
+        validity.push_back(sparse ? std::move(valid) : std::vector<uint8_t>());
+        series_list = tail;
+    }
+
+    EncodeOptions opts = parse_encode_options(env, opts_term);
+    auto chunks = encode_batch(timestamps.data(), timestamps.size(), series, validity, opts);
+
+    std::vector<ErlNifBinary> result;
+    result.reserve(chunks.size());
+    for (const auto &chunk : chunks) {
+        result.push_back(chunk_to_binary(chunk));
+    }
+    return fine::Ok(result);
+}
+FINE_NIF(nif_gorilla_encode_batch, ERL_NIF_DIRTY_JOB_CPU_BOUND);
+
+// ---------------------------------------------------------------------------
+// Decode helpers
+// ---------------------------------------------------------------------------
+
+// Bucket 0-4 from a '0'/'10'/'110'/'1110'/'1111' prefix or the side stream.
+static inline int get_dod_prefix(BitReader &reader, ControlStreams *side) {
+    if (side) return side->ts.pop();
+    int k = 0;
+    while (k < 4 && reader.read_bit()) k++;
+    return k;
+}
+
+static int64_t decode_delta_of_delta(BitReader &reader, ControlStreams *side = nullptr) {
+    int k = get_dod_prefix(reader, side);
+    return k == 0 ? 0 : reader.read_signed(DOD_FIELD_BITS[k]);
+}
+
+static int64_t decode_first_delta(BitReader &reader, ControlStreams *side = nullptr) {
+    return decode_delta_of_delta(reader, side);
+}
+
+// Blocks from encode_timestamp_blocks, after out[0]. Fields are unpacked
+// with one unaligned load each while a block sits 8 bytes clear of the end
+// of the buffer; otherwise, and for widths over 56 bits, bit by bit.
+static void decode_timestamp_blocks(BitReader &reader, uint32_t count, int64_t *out) {
+    const uint8_t *data = reader.data();
+    size_t total_bytes = reader.size_bits() / 8;
+    uint64_t fields[TS_BLOCK_SIZE];
+    uint64_t prev_base = 0;
+    uint64_t ts = static_cast<uint64_t>(out[0]);
+
+    for (uint32_t start = 1; start < count; start += TS_BLOCK_SIZE) {
+        uint32_t k = std::min(TS_BLOCK_SIZE, count - start);
+        int width = static_cast<int>(reader.read(7));
+        int base_width = static_cast<int>(reader.read(7));
+        if (width > 64 || base_width > 64) {
+            throw std::runtime_error("corrupt timestamp block");
+        }
+        uint64_t base = prev_base + zigzag_decode(reader.read(base_width));
+        prev_base = base;
+
+        size_t pos = reader.position();
+        size_t block_bits = static_cast<size_t>(k) * width;
+        if (block_bits > reader.remaining()) {
+            throw std::runtime_error("BitReader: read past end");
+        }
+        size_t last = pos + static_cast<size_t>(k - 1) * width;
+        if (width == 0) {
+            std::fill(fields, fields + k, 0);
+        } else if (width <= 56 && last / 8 + 8 <= total_bytes) {
+            for (uint32_t i = 0; i < k; i++) {
+                size_t p = pos + static_cast<size_t>(i) * width;
+                fields[i] = (load_be64(data + p / 8) << (p % 8)) >> (64 - width);
+            }
+        } else {
+            for (uint32_t i = 0; i < k; i++) fields[i] = reader.read(width);
+        }
+        reader.seek(pos + block_bits);
+
+        for (uint32_t i = 0; i < k; i++) {
+            ts += base + fields[i];
+            out[start + i] = static_cast<int64_t>(ts);
+        }
+    }
+}
+
+// Adaptive-bucket stream from encode_timestamps_adaptive, after out[0].
+// While 8 bytes remain past the read position, a value is decoded from one
+// unaligned load: the run of leading ones (at most 4) picks the bucket and
+// the field follows the prefix. Tables wider than 53 bits, and the last
+// few bytes, go through the bit reader. With control streams the buckets
+// come from the side stream and only the fields are read here.
+static void decode_timestamps_adaptive(BitReader &reader, uint32_t count, int64_t *out,
+                                       ControlStreams *side = nullptr) {
+    int width[4];
+    for (int k = 0; k < 4; k++) width[k] = static_cast<int>(reader.read(6)) + 1;
+
+    if (side) {
+        uint64_t prev_delta = 0;
+        uint64_t ts = static_cast<uint64_t>(out[0]);
+        for (uint32_t i = 1; i < count; i++) {
+            int k = side->ts.pop();
+            if (k > 0) prev_delta += static_cast<uint64_t>(reader.read_signed(width[k - 1]));
+            ts += prev_delta;
+            out[i] = static_cast<int64_t>(ts);
+        }
+        return;
+    }
+
+    const uint8_t *data = reader.data();
+    size_t total_bytes = reader.size_bits() / 8;
+    bool fast = width[3] <= 53;
+    size_t pos = reader.position();
+    uint64_t prev_delta = 0;
+    uint64_t ts = static_cast<uint64_t>(out[0]);
+
+    for (uint32_t i = 1; i < count; i++) {
+        uint64_t dod;
+        if (fast && pos / 8 + 8 <= total_bytes) {
+            uint64_t word = load_be64(data + pos / 8) << (pos % 8);
+            int ones = std::min(count_leading_zeros_64(~word), 4);
+            if (ones == 0) {
+                dod = 0;
+                pos += 1;
+            } else {
+                int len = ones == 4 ? 4 : ones + 1;
+                int w = width[ones - 1];
+                uint64_t sign = uint64_t(1) << (w - 1);
+                dod = (((word << len) >> (64 - w)) ^ sign) - sign;
+                pos += static_cast<size_t>(len + w);
+            }
+        } else {
+            reader.seek(pos);
+            if (reader.read_bit() == 0) {
+                dod = 0;
+            } else {
+                int k = 0;
+                while (k < 3 && reader.read_bit()) k++;
+                dod = static_cast<uint64_t>(reader.read_signed(width[k]));
+            }
+            pos = reader.position();
+        }
+        prev_delta += dod;
+        ts += prev_delta;
+        out[i] = static_cast<int64_t>(ts);
+    }
+    reader.seek(pos);
+}
+
+// `flags` are the chunk flags; 0x100 and 0x200 select the block and
+// adaptive-bucket codecs. Bucket prefixes come from `side` when given.
+static void decode_timestamps(BitReader &reader, uint32_t count, int64_t *out,
+                              uint32_t flags = 0, ControlStreams *side = nullptr) {
+    if (count == 0) return;
+
+    int64_t first_ts = static_cast<int64_t>(reader.read(64));
+    out[0] = first_ts;
+
+    if (count == 1) return;
+
+    if (flags & 0x100) {
+        decode_timestamp_blocks(reader, count, out);
+        return;
+    }
+    if (flags & 0x200) {
+        decode_timestamps_adaptive(reader, count, out, side);
+        return;
+    }
+
+    int64_t first_delta = decode_first_delta(reader, side);
+    out[1] = first_ts + first_delta;
+
+    int64_t prev_delta = first_delta;
+    for (uint32_t i = 2; i < count; i++) {
+        int64_t dod = decode_delta_of_delta(reader, side);
+        int64_t current_delta = prev_delta + dod;
+        out[i] = out[i - 1] + current_delta;
+        prev_delta = current_delta;
+    }
+}
+
+template <typename Word, typename Out>
+static void decode_values(BitReader &reader, uint32_t count, Out *out,
+                          ControlStreams *side = nullptr) {
+    constexpr int W = Word::bits;
+    if (count == 0) return;
+
+    uint64_t first_bits = reader.read(W);
+    out[0] = static_cast<Out>(Word::from_bits(first_bits));
+
+    if (count == 1) return;
+
+    uint64_t prev_bits = first_bits;
+    int prev_leading = 0;
+    int prev_trailing = 0;
+
+    for (uint32_t i = 1; i < count; i++) {
+        int code;
+        if (side) {
+            code = side->codes.pop();
+        } else if (reader.read_bit() == 0) {
+            code = 0;
+        } else if (reader.read_bit() == 0) {
+            code = 1;
+        } else {
+            code = 2 + static_cast<int>(reader.read(5));
+        }
+
+        if (code == 0) {
+            // Identical to previous
+            out[i] = out[i - 1];
+            continue;
+        }
+
+        if (code == 1) {
+            // Reuse previous window
+            int meaningful_length = W - prev_leading - prev_trailing;
+            uint64_t meaningful_value = reader.read(meaningful_length);
+            uint64_t xor_val = meaningful_value << prev_trailing;
+            uint64_t new_bits = prev_bits ^ xor_val;
+            out[i] = static_cast<Out>(Word::from_bits(new_bits));
+            prev_bits = new_bits;
+        } else {
+            // New window
+            int leading = code - 2;
+            int meaningful_length =
+                (side ? side->lengths.pop() : static_cast<int>(reader.read(Word::length_bits))) + 1;
+            int trailing = W - leading - meaningful_length;
+            if (trailing < 0) {
+                throw std::runtime_error("corrupt value stream");
+            }
+
+            uint64_t meaningful_value = reader.read(meaningful_length);
+            uint64_t xor_val = meaningful_value << trailing;
+            uint64_t new_bits = prev_bits ^ xor_val;
+            out[i] = static_cast<Out>(Word::from_bits(new_bits));
+            prev_bits = new_bits;
+            prev_leading = leading;
+            prev_trailing = trailing;
+        }
+    }
+}
+
+// Decode a value bitstream with the algorithm and word size named by the
+// chunk flags.
+template <typename Word, typename Out>
+static void decode_value_stream(BitReader &reader, uint32_t flags, uint32_t count, Out *out,
+                                ControlStreams *side = nullptr) {
+    if (flags & 0x8) {
+        switch (chimp128_window_from_flags(flags)) {
+            case 32:  decode_values_chimp128<Word, 5>(reader, count, out, side); break;
+            case 64:  decode_values_chimp128<Word, 6>(reader, count, out, side); break;
+            case 256: decode_values_chimp128<Word, 8>(reader, count, out, side); break;
+            default:  decode_values_chimp128<Word, 7>(reader, count, out, side); break;
+        }
+    } else if (flags & 0x4) {
+        decode_values_chimp<Word>(reader, count, out, side);
+    } else if (flags & 0x2000) {
+        decode_values_fpc<Word>(reader, count, out, side);
+    } else {
+        decode_values<Word>(reader, count, out, side);
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Chunk header parsing
+// ---------------------------------------------------------------------------
+
+struct ChunkHeader {
+    uint32_t version;
+    uint32_t header_size;
+    uint32_t count;
+    uint32_t compressed_size;
+    uint32_t original_size;
+    uint32_t checksum;
+    int64_t first_timestamp;
+    int32_t first_delta;
+    uint64_t first_value_bits;
+    uint32_t ts_bit_len;
+    uint32_t val_bit_len;
+    uint32_t total_bits;
+    double compression_ratio;
+    int64_t creation_time;
+    uint32_t flags;
+    uint32_t scale_decimals;
+    bool has_xxh3;
+    uint64_t xxh3;
+};
+
+// Parse and validate the outer header. Throws on malformed input.
+static ChunkHeader parse_chunk_header(const uint8_t *ptr, size_t len) {
+    // Parse outer header — minimum 80 bytes
+    if (len < 80) {
+        throw std::runtime_error("data too small for header");
+    }
+
+    BitReader hdr(ptr, len * 8);
+
+    uint64_t magic = hdr.read(64);
+    if (magic != GORILLA_MAGIC) {
+        throw std::runtime_error("invalid magic number");
+    }
+
+    uint64_t version = hdr.read(16);
+    if (version > GORILLA_VERSION) {
+        throw std::runtime_error("unsupported version");
+    }
+
+    ChunkHeader h;
+    h.version = static_cast<uint32_t>(version);
+    h.header_size = static_cast<uint32_t>(hdr.read(16));
+    bool has_scale = h.header_size == 84 || h.header_size == 92;
+    bool has_xxh3 = h.header_size == 88 || h.header_size == 92;
+    if (!has_scale && h.header_size != 80 && !has_xxh3) {
+        throw std::runtime_error("invalid header size");
+    }
+    if (has_xxh3 != (version == 2)) {
+        throw std::runtime_error("invalid header size");
+    }
+
+    if (len < h.header_size) {
+        throw std::runtime_error("data smaller than header");
+    }
+
+    h.count = static_cast<uint32_t>(hdr.read(32));
+    h.compressed_size = static_cast<uint32_t>(hdr.read(32));
+    h.original_size = static_cast<uint32_t>(hdr.read(32));
+    h.checksum = static_cast<uint32_t>(hdr.read(32));
+    h.first_timestamp = static_cast<int64_t>(hdr.read(64));
+    h.first_delta = static_cast<int32_t>(hdr.read_signed(32));
+    h.first_value_bits = hdr.read(64);
+    h.ts_bit_len = static_cast<uint32_t>(hdr.read(32));
+    h.val_bit_len = static_cast<uint32_t>(hdr.read(32));
+    h.total_bits = static_cast<uint32_t>(hdr.read(32));
+    h.compression_ratio = bits_to_float(hdr.read(64));  // float-64 bits
+    h.creation_time = static_cast<int64_t>(hdr.read(64));
+    h.flags = static_cast<uint32_t>(hdr.read(32));
+
+    h.scale_decimals = 0;
+    if (has_scale) {
+        h.scale_decimals = static_cast<uint32_t>(hdr.read(32));
+    }
+    h.has_xxh3 = has_xxh3;
+    h.xxh3 = has_xxh3 ? hdr.read(64) : 0;
+
+    if (static_cast<size_t>(h.header_size) + h.compressed_size > len) {
+        throw std::runtime_error("compressed data extends beyond input");
+    }
+
+    return h;
+}
+
+// ---------------------------------------------------------------------------
+// Columnar chunk decode
+// ---------------------------------------------------------------------------
+
+// Decode the value bitstream of a chunk, picking the word size from its flags.
+template <typename Out>
+static void decode_value_column(BitReader &reader, const ChunkHeader &hdr,
+                                uint32_t count, Out *out, ControlStreams *side = nullptr) {
+    if (hdr.flags & 0x10) {
+        decode_value_stream<Float32Word>(reader, hdr.flags, count, out, side);
+    } else {
+        decode_value_stream<Float64Word>(reader, hdr.flags, count, out, side);
+    }
+}
+
+// Decode a whole chunk into caller-provided columns of hdr.count entries.
+// Both output columns are written in place, so callers can point them
+// straight into a result binary. Values are written as double or float.
+// Missing points of a sparse chunk come out as NaN; pass `validity` to
+// also receive the bitmap (left empty for dense chunks). A null column is
+// skipped: the value bitstream starts at ts_bit_len from the inner header,
+// so neither column depends on decoding the other.
+template <typename Out>
+static void decode_chunk_impl(const uint8_t *ptr, const ChunkHeader &hdr,
+                              int64_t *ts_out, Out *val_out,
+                              std::vector<uint8_t> *validity)
+{
+    // Compressed data follows the header
+    const uint8_t *packed_data = ptr + hdr.header_size;
+    size_t packed_size = hdr.compressed_size;
+    GORILLA_PROBE3(decode__start, hdr.count, hdr.flags, hdr.header_size + packed_size);
+
+    // xxHash3 chunks opted into a strong check, so a mismatch is an error.
+    // CRC32 mismatches are tolerated (the Elixir decoder flags them and continues).
+    if (hdr.has_xxh3) {
+        if (xxh3_64(packed_data, packed_size) != hdr.xxh3) {
+            throw std::runtime_error("checksum mismatch");
+        }
+    } else {
+        uint32_t actual_crc = crc32(packed_data, packed_size);
+        if (actual_crc != hdr.checksum) {
+            // Allow checksum mismatch
+        }
+    }
+
+    uint32_t count = hdr.count;
+    if (validity) validity->clear();
+    if (count == 0) return;
+
+    // Parse inner header (32 bytes) from packed data
+    if (packed_size < 32) {
+        throw std::runtime_error("packed data too small for inner header");
+    }
+
+    BitReader inner(packed_data, packed_size * 8);
+
+    /*uint32_t inner_count =*/ inner.read(32);
+    /*int64_t inner_first_ts =*/ inner.read(64);
+    /*uint64_t inner_first_val =*/ inner.read(64);
+    /*int32_t inner_first_delta =*/ inner.read_signed(32);
+    uint32_t ts_bit_len = static_cast<uint32_t>(inner.read(32));
+    uint32_t val_bit_len = static_cast<uint32_t>(inner.read(32));
+
+    // The inner header is 256 bits = 32 bytes; the timestamp bitstream
+    // follows it and the value bitstream follows the timestamps.
+    size_t ts_start = 256;
+    size_t val_start = ts_start + ts_bit_len;
+
+    // A sparse chunk only stores its present values; the bitmap after the
+    // value bitstream says where they go.
+    std::vector<uint8_t> bitmap;
+    uint32_t present = count;
+    BitReader tail_reader(packed_data, packed_size * 8);
+    if (hdr.flags & (0x40 | 0x1000)) {
+        tail_reader.seek(static_cast<size_t>(val_start) + val_bit_len);
+    }
+    if (hdr.flags & 0x40) {
+        present = static_cast<uint32_t>(decode_validity(tail_reader, count, bitmap));
+    }
+
+    // rANS control streams start at the next byte boundary
+    ControlStreams control;
+    ControlStreams *side = nullptr;
+    if (hdr.flags & 0x1000) {
+        tail_reader.seek(std::min((tail_reader.position() + 7) / 8 * 8, packed_size * 8));
+        decode_control_streams(tail_reader, count, hdr.flags, control);
+        side = &control;
+    }
+
+    if (ts_out) {
+        BitReader ts_reader(packed_data, packed_size * 8);
+        ts_reader.seek(ts_start);
+        decode_timestamps(ts_reader, count, ts_out, hdr.flags, side);
+        GORILLA_PROBE2(decode__timestamps, count, ts_bit_len);
+    }
+    if (!val_out) {
+        GORILLA_PROBE2(decode__done, count, hdr.flags);
+        return;
+    }
+
+    BitReader val_reader(packed_data, packed_size * 8);
+    val_reader.seek(val_start);
+
+    bool vm_enabled = (hdr.flags & 0x1) != 0;
+    bool is_counter = (hdr.flags & 0x2) != 0;
+
+    if (!vm_enabled) {
+        decode_value_column(val_reader, hdr, present, val_out, side);
+    } else {
+        // VM postprocessing runs in double precision; float columns are
+        // narrowed from a scratch column afterwards.
+        std::vector<double> scratch;
+        double *values;
+        if constexpr (std::is_same_v<Out, double>) {
+            values = val_out;
+        } else {
+            scratch.resize(present);
+            values = scratch.data();
+        }
+        decode_value_column(val_reader, hdr, present, values, side);
+
+        if (hdr.scale_decimals > 0) {
+            double scale = std::pow(10.0, static_cast<double>(hdr.scale_decimals));
+            for (uint32_t i = 0; i < present; i++) {
+                values[i] = values[i] / scale;
+            }
+        }
+        if (is_counter) {
+            delta_decode_counter(values, present);
+        }
+
+        if constexpr (!std::is_same_v<Out, double>) {
+            for (uint32_t i = 0; i < present; i++) {
+                val_out[i] = static_cast<Out>(values[i]);
+            }
+        }
+    }
+
+    GORILLA_PROBE3(decode__values, present, val_bit_len, hdr.flags);
+
+    if (present < count) {
+        // Spread the present values out to their slots, back to front so
+        // nothing is overwritten before it moves.
+        uint32_t src = present;
+        for (uint32_t i = count; i-- > 0;) {
+            val_out[i] = bitmap[i] ? val_out[--src] : std::numeric_limits<Out>::quiet_NaN();
+        }
+    }
+    if (validity && !bitmap.empty()) *validity = std::move(bitmap);
+    GORILLA_PROBE2(decode__done, count, hdr.flags);
+}
+
+#define GORILLA_DECODE_VARIANT(tag, arch)                                      \
+    template <typename Out>                                                    \
+    __attribute__((target(arch), flatten))                                     \
+    static void decode_chunk_##tag(const uint8_t *ptr, const ChunkHeader &hdr, \
+                                   int64_t *ts_out, Out *val_out,              \
+                                   std::vector<uint8_t> *validity) {           \
+        decode_chunk_impl(ptr, hdr, ts_out, val_out, validity);                \
+    }
+GORILLA_ISA_VARIANTS(GORILLA_DECODE_VARIANT)
+#undef GORILLA_DECODE_VARIANT
+
+template <typename Out>
+static void decode_chunk_into(const uint8_t *ptr, const ChunkHeader &hdr,
+                              int64_t *ts_out, Out *val_out,
+                              std::vector<uint8_t> *validity = nullptr)
+{
+    switch (selected_isa()) {
+#define GORILLA_DECODE_CASE(tag, arch) \
+    case Isa::tag: return decode_chunk_##tag(ptr, hdr, ts_out, val_out, validity);
+    GORILLA_ISA_VARIANTS(GORILLA_DECODE_CASE)
+#undef GORILLA_DECODE_CASE
+    default: return decode_chunk_impl(ptr, hdr, ts_out, val_out, validity);
+    }
+}
+
+// ErlNifBinary released on scope exit unless ownership is handed to the VM,
+// so a decode error part-way through does not leak the result buffer.
+class OwnedBinary {
+public:
+    explicit OwnedBinary(size_t size) {
+        if (!enif_alloc_binary(size, &bin_)) {
+            throw std::runtime_error("failed to allocate binary");
+        }
+    }
+    ~OwnedBinary() {
+        if (owned_) enif_release_binary(&bin_);
+    }
+    OwnedBinary(const OwnedBinary &) = delete;
+    OwnedBinary &operator=(const OwnedBinary &) = delete;
+
+    uint8_t *data() { return bin_.data; }
+
+    ErlNifBinary release() {
+        owned_ = false;
+        return bin_;
+    }
+
+private:
+    ErlNifBinary bin_;
+    bool owned_ = true;
+};
+
+// ---------------------------------------------------------------------------
+// Decode NIF
+// ---------------------------------------------------------------------------
+
+// Missing points of a sparse chunk decode to nil.
+using DecodedPoint = std::tuple<int64_t, std::optional<double>>;
+
+static fine::Ok<std::vector<DecodedPoint>>
+nif_gorilla_decode(ErlNifEnv *env, ErlNifBinary data)
+{
+    if (data.size == 0) {
+        return fine::Ok(std::vector<DecodedPoint>{});
+    }
+
+    ChunkHeader hdr = parse_chunk_header(data.data, data.size);
+
+    std::vector<int64_t> timestamps(hdr.count);
+    std::vector<double> values(hdr.count);
+    std::vector<uint8_t> validity;
+    decode_chunk_into(data.data, hdr, timestamps.data(), values.data(), &validity);
+
+    // Combine into result
+    std::vector<DecodedPoint> result;
+    result.reserve(hdr.count);
+    for (uint32_t i = 0; i < hdr.count; i++) {
+        if (validity.empty() || validity[i]) {
+            result.emplace_back(timestamps[i], values[i]);
+        } else {
+            result.emplace_back(timestamps[i], std::nullopt);
+        }
+    }
+
+    return fine::Ok(result);
+}
+FINE_NIF(nif_gorilla_decode, ERL_NIF_DIRTY_JOB_CPU_BOUND);
+
+// Single-column decodes for queries that need only one of the two, e.g.
+// counting points per bucket or building a value histogram. The other
+// bitstream is never read.
+static fine::Ok<std::vector<int64_t>>
+nif_gorilla_decode_timestamps(ErlNifEnv *env, ErlNifBinary data)
+{
+    if (data.size == 0) {
+        return fine::Ok(std::vector<int64_t>{});
+    }
+
+    ChunkHeader hdr = parse_chunk_header(data.data, data.size);
+
+    std::vector<int64_t> timestamps(hdr.count);
+    decode_chunk_into(data.data, hdr, timestamps.data(), static_cast<double *>(nullptr));
+    return fine::Ok(timestamps);
+}
+FINE_NIF(nif_gorilla_decode_timestamps, ERL_NIF_DIRTY_JOB_CPU_BOUND);
+
+static fine::Ok<std::vector<std::optional<double>>>
+nif_gorilla_decode_values(ErlNifEnv *env, ErlNifBinary data)
+{
+    if (data.size == 0) {
+        return fine::Ok(std::vector<std::optional<double>>{});
+    }
+
+    ChunkHeader hdr = parse_chunk_header(data.data, data.size);
+
+    std::vector<double> values(hdr.count);
+    std::vector<uint8_t> validity;
+    decode_chunk_into(data.data, hdr, static_cast<int64_t *>(nullptr), values.data(), &validity);
+
+    std::vector<std::optional<double>> result;
+    result.reserve(hdr.count);
+    for (uint32_t i = 0; i < hdr.count; i++) {
+        if (validity.empty() || validity[i]) {
+            result.emplace_back(values[i]);
+        } else {
+            result.emplace_back(std::nullopt);
+        }
+    }
+
+    return fine::Ok(result);
+}
+FINE_NIF(nif_gorilla_decode_values, ERL_NIF_DIRTY_JOB_CPU_BOUND);
+
+// ---------------------------------------------------------------------------
+// Columnar decode NIFs
+// ---------------------------------------------------------------------------
+//
+// Decode straight into two native-endian binaries — int64 timestamps and
+// float64 values — laid out exactly as Nx.from_binary/2 expects for {:s, 64}
+// and {:f, 64}. With value_type: :f32 the values column holds float32
+// ({:f, 32}) instead. No per-point terms are built. ERTS refc binaries are
+// word-aligned, so the columns are written through typed pointers.
+
+using ColumnPair = std::tuple<ErlNifBinary, ErlNifBinary>;
+
+static bool wants_f32_columns(ErlNifEnv *env, ERL_NIF_TERM opts_term) {
+    ERL_NIF_TERM opt_val;
+    return enif_get_map_value(env, opts_term, fine::encode(env, atom_value_type), &opt_val) &&
+           enif_is_identical(opt_val, fine::encode(env, atom_f32));
+}
+
+template <typename Out>
+static ColumnPair decode_columns(const ErlNifBinary &data) {
+    if (data.size == 0) {
+        OwnedBinary ts_bin(0), val_bin(0);
+        return ColumnPair(ts_bin.release(), val_bin.release());
+    }
+
+    ChunkHeader hdr = parse_chunk_header(data.data, data.size);
+
+    OwnedBinary ts_bin(static_cast<size_t>(hdr.count) * sizeof(int64_t));
+    OwnedBinary val_bin(static_cast<size_t>(hdr.count) * sizeof(Out));
+    decode_chunk_into(data.data, hdr,
+                      reinterpret_cast<int64_t *>(ts_bin.data()),
+                      reinterpret_cast<Out *>(val_bin.data()));
+
+    return ColumnPair(ts_bin.release(), val_bin.release());
+}
+
+static fine::Ok<ColumnPair>
+nif_gorilla_decode_columns(ErlNifEnv *env, ErlNifBinary data, fine::Term opts_term)
+{
+    if (wants_f32_columns(env, opts_term)) {
+        return fine::Ok(decode_columns<float>(data));
+    }
+    return fine::Ok(decode_columns<double>(data));
+}
+FINE_NIF(nif_gorilla_decode_columns, ERL_NIF_DIRTY_JOB_CPU_BOUND);
+
+using BatchColumns = std::tuple<ErlNifBinary, ErlNifBinary, std::vector<int64_t>>;
+
+template <typename Out>
+static std::tuple<ErlNifBinary, ErlNifBinary>
+decode_columns_batch(const std::vector<ErlNifBinary> &chunks,
+                     const std::vector<ChunkHeader> &headers, size_t total)
+{
+    OwnedBinary ts_bin(total * sizeof(int64_t));
+    OwnedBinary val_bin(total * sizeof(Out));
+    int64_t *ts_out = reinterpret_cast<int64_t *>(ts_bin.data());
+    Out *val_out = reinterpret_cast<Out *>(val_bin.data());
+
+    size_t offset = 0;
+    for (size_t i = 0; i < chunks.size(); i++) {
+        if (headers[i].count == 0) continue;
+        decode_chunk_into(chunks[i].data, headers[i], ts_out + offset, val_out + offset);
+        offset += headers[i].count;
+    }
+
+    return ColumnPair(ts_bin.release(), val_bin.release());
+}
+
+// Decode a list of chunks into one pair of concatenated columns plus the
+// per-chunk point counts. Headers are parsed first so the output is
+// allocated exactly once.
+static fine::Ok<BatchColumns>
+nif_gorilla_decode_columns_batch(ErlNifEnv *env, fine::Term chunks_term, fine::Term opts_term)
+{
+    std::vector<ErlNifBinary> chunks;
+    std::vector<ChunkHeader> headers;
+    std::vector<int64_t> counts;
+    size_t total = 0;
+
+    ERL_NIF_TERM head, tail;
+    ERL_NIF_TERM list = chunks_term;
+    while (enif_get_list_cell(env, list, &head, &tail)) {
+        ErlNifBinary chunk;
+        if (!enif_inspect_binary(env, head, &chunk)) {
+            throw std::invalid_argument("expected a list of binaries");
+        }
+
+        ChunkHeader hdr{};
+        if (chunk.size > 0) {
+            hdr = parse_chunk_header(chunk.data, chunk.size);
+        }
+
+        chunks.push_back(chunk);
+        headers.push_back(hdr);
+        counts.push_back(static_cast<int64_t>(hdr.count));
+        total += hdr.count;
+        list = tail;
+    }
+
+    auto [ts_bin, val_bin] = wants_f32_columns(env, opts_term)
+        ? decode_columns_batch<float>(chunks, headers, total)
+        : decode_columns_batch<double>(chunks, headers, total);
+
+    return fine::Ok(BatchColumns(ts_bin, val_bin, counts));
+}
+FINE_NIF(nif_gorilla_decode_columns_batch, ERL_NIF_DIRTY_JOB_CPU_BOUND);
+
+// ---------------------------------------------------------------------------
+// Chunk scan NIF
+// ---------------------------------------------------------------------------
+//
+// Index chunks stored back to back in one binary from their outer headers
+// alone, each being header_size + compressed_size bytes. The index is
+// columnar and native-endian like the decode columns: offsets, lengths and
+// first/last timestamps as int64, counts and flags as uint32, and content
+// hashes as 16 bytes each.
+
+static auto atom_last_timestamp = fine::Atom("last_timestamp");
+static auto atom_content_hash = fine::Atom("content_hash");
+
+using ChunkIndex = std::tuple<ErlNifBinary, ErlNifBinary, ErlNifBinary, ErlNifBinary,
+                              std::optional<ErlNifBinary>, ErlNifBinary,
+                              std::optional<ErlNifBinary>>;
+
+// The content hash covers everything after creation_time: the flags word,
+// the optional scale and xxh3 fields and the packed payload. The fields
+// before it either repeat the payload's inner header or derive from the
+// payload, so chunks of the same data encoded the same way hash alike
+// whenever they were written. XXH3-128, stored big-endian (high half first).
+static const size_t CONTENT_HASH_OFFSET = 76;
+
+static void chunk_content_hash(const uint8_t *ptr, const ChunkHeader &hdr, uint8_t *out) {
+    size_t end = static_cast<size_t>(hdr.header_size) + hdr.compressed_size;
+    Hash128 h = xxh3_128(ptr + CONTENT_HASH_OFFSET, end - CONTENT_HASH_OFFSET);
+    store_be64(out, h.hi);
+    store_be64(out + 8, h.lo);
+}
+
+// Last timestamp of a chunk. Headers only carry the first timestamp and
+// delta, so chunks of three or more points decode into scratch columns.
+static int64_t chunk_last_timestamp(const uint8_t *ptr, const ChunkHeader &hdr) {
+    if (hdr.count <= 1) return hdr.first_timestamp;
+    // The header's first delta is exact only for the fixed delta-of-delta
+    // codec; block and adaptive streams allow deltas wider than its int32
+    if (hdr.count == 2 && !(hdr.flags & (0x100 | 0x200))) {
+        return hdr.first_timestamp + hdr.first_delta;
+    }
+
+    std::vector<int64_t> timestamps(hdr.count);
+    decode_chunk_into(ptr, hdr, timestamps.data(), static_cast<double *>(nullptr));
+    return timestamps.back();
+}
+
+// Walk the concatenated chunks, then fill each column in one pass. With
+// `last_timestamp: true` the last timestamps are filled in too; otherwise
+// that column is nil.
+static fine::Ok<ChunkIndex>
+nif_gorilla_scan_chunks(ErlNifEnv *env, ErlNifBinary data, fine::Term opts_term)
+{
+    bool with_last = false;
+    bool with_hash = false;
+    ERL_NIF_TERM opt_val;
+    if (enif_get_map_value(env, opts_term, fine::encode(env, atom_last_timestamp), &opt_val)) {
+        with_last = fine::decode<bool>(env, opt_val);
+    }
+    if (enif_get_map_value(env, opts_term, fine::encode(env, atom_content_hash), &opt_val)) {
+        with_hash = fine::decode<bool>(env, opt_val);
+    }
+
+    std::vector<size_t> offsets;
+    std::vector<ChunkHeader> headers;
+    size_t offset = 0;
+    while (offset < data.size) {
+        ChunkHeader hdr = parse_chunk_header(data.data + offset, data.size - offset);
+        offsets.push_back(offset);
+        headers.push_back(hdr);
+        offset += static_cast<size_t>(hdr.header_size) + hdr.compressed_size;
+    }
+
+    size_t n = headers.size();
+    OwnedBinary offset_bin(n * sizeof(int64_t));
+    OwnedBinary length_bin(n * sizeof(int64_t));
+    OwnedBinary count_bin(n * sizeof(uint32_t));
+    OwnedBinary first_bin(n * sizeof(int64_t));
+    OwnedBinary flags_bin(n * sizeof(uint32_t));
+    int64_t *offset_out = reinterpret_cast<int64_t *>(offset_bin.data());
+    int64_t *length_out = reinterpret_cast<int64_t *>(length_bin.data());
+    uint32_t *count_out = reinterpret_cast<uint32_t *>(count_bin.data());
+    int64_t *first_out = reinterpret_cast<int64_t *>(first_bin.data());
+    uint32_t *flags_out = reinterpret_cast<uint32_t *>(flags_bin.data());
+
+    for (size_t i = 0; i < n; i++) {
+        offset_out[i] = static_cast<int64_t>(offsets[i]);
+        length_out[i] = static_cast<int64_t>(headers[i].header_size) + headers[i].compressed_size;
+        count_out[i] = headers[i].count;
+        first_out[i] = headers[i].first_timestamp;
+        flags_out[i] = headers[i].flags;
+    }
+
+    std::optional<OwnedBinary> last_bin;
+    if (with_last) {
+        last_bin.emplace(n * sizeof(int64_t));
+        int64_t *last_out = reinterpret_cast<int64_t *>(last_bin->data());
+        for (size_t i = 0; i < n; i++) {
+            last_out[i] = chunk_last_timestamp(data.data + offsets[i], headers[i]);
+        }
+    }
+
+    std::optional<OwnedBinary> hash_bin;
+    if (with_hash) {
+        hash_bin.emplace(n * 16);
+        for (size_t i = 0; i < n; i++) {
+            chunk_content_hash(data.data + offsets[i], headers[i], hash_bin->data() + 16 * i);
+        }
+    }
+
+    std::optional<ErlNifBinary> last;
+    if (last_bin) last = last_bin->release();
+    std::optional<ErlNifBinary> hashes;
+    if (hash_bin) hashes = hash_bin->release();
+    return fine::Ok(ChunkIndex(offset_bin.release(), length_bin.release(), count_bin.release(),
+                               first_bin.release(), last, flags_bin.release(), hashes));
+}
+FINE_NIF(nif_gorilla_scan_chunks, ERL_NIF_DIRTY_JOB_CPU_BOUND);
+
+// Content hash of a single chunk; trailing bytes after it are ignored.
+static fine::Ok<ErlNifBinary>
+nif_gorilla_content_hash(ErlNifEnv *env, ErlNifBinary data)
+{
+    ChunkHeader hdr = parse_chunk_header(data.data, data.size);
+    OwnedBinary hash_bin(16);
+    chunk_content_hash(data.data, hdr, hash_bin.data());
+    return fine::Ok(hash_bin.release());
+}
+FINE_NIF(nif_gorilla_content_hash, ERL_NIF_DIRTY_JOB_CPU_BOUND);
+
+// ---------------------------------------------------------------------------
+// Chunk info NIFs
+// ---------------------------------------------------------------------------
+//
+// The outer header of a chunk as a map keyed like Decoder.Metadata, without
+// touching the bitstreams. With verify_checksum: true the payload is hashed
+// too and checksum_failed says whether it matched; otherwise it is nil.
+
+static auto atom_verify_checksum = fine::Atom("verify_checksum");
+static auto atom_checksum_failed = fine::Atom("checksum_failed");
+static auto atom_checksum_type = fine::Atom("checksum_type");
+static auto atom_crc32 = fine::Atom("crc32");
+static auto atom_version = fine::Atom("version");
+static auto atom_header_length = fine::Atom("header_length");
+static auto atom_count = fine::Atom("count");
+static auto atom_compressed_size = fine::Atom("compressed_size");
+static auto atom_original_size = fine::Atom("original_size");
+static auto atom_first_timestamp = fine::Atom("first_timestamp");
+static auto atom_first_delta = fine::Atom("first_delta");
+static auto atom_first_value = fine::Atom("first_value");
+static auto atom_timestamp_bit_length = fine::Atom("timestamp_bit_length");
+static auto atom_value_bit_length = fine::Atom("value_bit_length");
+static auto atom_total_bits = fine::Atom("total_bits");
+static auto atom_compression_ratio = fine::Atom("compression_ratio");
+static auto atom_creation_time = fine::Atom("creation_time");
+static auto atom_flags = fine::Atom("flags");
+
+static bool verify_checksum_option(ErlNifEnv *env, ERL_NIF_TERM opts_term) {
+    ERL_NIF_TERM opt_val;
+    return enif_get_map_value(env, opts_term, fine::encode(env, atom_verify_checksum), &opt_val) &&
+           fine::decode<bool>(env, opt_val);
+}
+
+static ERL_NIF_TERM chunk_info_term(ErlNifEnv *env, const ErlNifBinary &data, bool verify) {
+    ChunkHeader hdr = parse_chunk_header(data.data, data.size);
+
+    ERL_NIF_TERM checksum_failed = fine::encode(env, atom_nil);
+    if (verify) {
+        const uint8_t *payload = data.data + hdr.header_size;
+        bool ok = hdr.has_xxh3 ? xxh3_64(payload, hdr.compressed_size) == hdr.xxh3
+                               : crc32(payload, hdr.compressed_size) == hdr.checksum;
+        checksum_failed = fine::encode(env, !ok);
+    }
+
+    // NaN and infinities are not BEAM floats
+    double first_value = bits_to_float(hdr.first_value_bits);
+    ERL_NIF_TERM first_value_term = std::isfinite(first_value)
+        ? fine::encode(env, first_value) : fine::encode(env, atom_nil);
+
+    ERL_NIF_TERM keys[] = {
+        fine::encode(env, atom_version),
+        fine::encode(env, atom_header_length),
+        fine::encode(env, atom_count),
+        fine::encode(env, atom_compressed_size),
+        fine::encode(env, atom_original_size),
+        fine::encode(env, atom_checksum),
+        fine::encode(env, atom_checksum_type),
+        fine::encode(env, atom_checksum_failed),
+        fine::encode(env, atom_first_timestamp),
+        fine::encode(env, atom_first_delta),
+        fine::encode(env, atom_first_value),
+        fine::encode(env, atom_timestamp_bit_length),
+        fine::encode(env, atom_value_bit_length),
+        fine::encode(env, atom_total_bits),
+        fine::encode(env, atom_compression_ratio),
+        fine::encode(env, atom_creation_time),
+        fine::encode(env, atom_flags),
+        fine::encode(env, atom_scale_decimals),
+    };
+    ERL_NIF_TERM values[] = {
+        fine::encode(env, static_cast<uint64_t>(hdr.version)),
+        fine::encode(env, static_cast<uint64_t>(hdr.header_size)),
+        fine::encode(env, static_cast<uint64_t>(hdr.count)),
+        fine::encode(env, static_cast<uint64_t>(hdr.compressed_size)),
+        fine::encode(env, static_cast<uint64_t>(hdr.original_size)),
+        fine::encode(env, hdr.has_xxh3 ? hdr.xxh3 : static_cast<uint64_t>(hdr.checksum)),
+        fine::encode(env, hdr.has_xxh3 ? atom_xxh3 : atom_crc32),
+        checksum_failed,
+        fine::encode(env, hdr.first_timestamp),
+        fine::encode(env, static_cast<int64_t>(hdr.first_delta)),
+        first_value_term,
+        fine::encode(env, static_cast<uint64_t>(hdr.ts_bit_len)),
+        fine::encode(env, static_cast<uint64_t>(hdr.val_bit_len)),
+        fine::encode(env, static_cast<uint64_t>(hdr.total_bits)),
+        fine::encode(env, hdr.compression_ratio),
+        fine::encode(env, hdr.creation_time),
+        fine::encode(env, static_cast<uint64_t>(hdr.flags)),
+        fine::encode(env, static_cast<uint64_t>(hdr.scale_decimals)),
+    };
+
+    ERL_NIF_TERM map;
+    if (!enif_make_map_from_arrays(env, keys, values, std::size(keys), &map)) {
+        throw std::runtime_error("failed to build info map");
+    }
+    return map;
+}
+
+static fine::Ok<fine::Term>
+nif_gorilla_info(ErlNifEnv *env, ErlNifBinary data, fine::Term opts_term)
+{
+    return fine::Ok(fine::Term(chunk_info_term(env, data, verify_checksum_option(env, opts_term))));
+}
+FINE_NIF(nif_gorilla_info, ERL_NIF_DIRTY_JOB_CPU_BOUND);
+
+// One entry per chunk; a chunk whose header does not parse gets nil rather
+// than failing the batch.
+static fine::Ok<std::vector<std::optional<fine::Term>>>
+nif_gorilla_info_batch(ErlNifEnv *env, fine::Term chunks_term, fine::Term opts_term)
+{
+    bool verify = verify_checksum_option(env, opts_term);
+
+    std::vector<std::optional<fine::Term>> result;
+    ERL_NIF_TERM head, tail;
+    ERL_NIF_TERM list = chunks_term;
+    while (enif_get_list_cell(env, list, &head, &tail)) {
+        ErlNifBinary chunk;
+        if (!enif_inspect_binary(env, head, &chunk)) {
+            throw std::invalid_argument("expected a list of binaries");
+        }
+        try {
+            result.emplace_back(chunk_info_term(env, chunk, verify));
+        } catch (const std::runtime_error &) {
+            result.emplace_back(std::nullopt);
+        }
+        list = tail;
+    }
+    return fine::Ok(result);
+}
+FINE_NIF(nif_gorilla_info_batch, ERL_NIF_DIRTY_JOB_CPU_BOUND);
+
+// ---------------------------------------------------------------------------
+// Framed wire format
+// ---------------------------------------------------------------------------
+//
+// Chunks shipped between nodes travel as a sequence of frames, one chunk each
+// (all integers big-endian):
+//
+//   magic      : 32   "GSF1"
+//   flags      : 32   bit 0 = metadata present
+//   chunk_len  : 32
+//   [meta_len] : 32   (flag bit 0)
+//   [metadata] : meta_len bytes, Erlang external term format
+//   chunk      : chunk_len bytes
+//
+// Frames are written as iodata on the Elixir side. The reader hands back
+// chunks and metadata as sub-binaries of its input, so nothing is copied, and
+// a trailing partial frame is returned for the caller to complete.
+
+static const uint32_t FRAME_MAGIC = 0x47534631; // "GSF1"
+static const uint32_t FRAME_FLAG_METADATA = 0x1;
+
+using Frame = std::tuple<fine::Term, std::optional<fine::Term>>;
+using FrameBatch = std::tuple<std::vector<Frame>, fine::Term>;
+
+static fine::Ok<FrameBatch>
+nif_gorilla_decode_frames(ErlNifEnv *env, fine::Term input)
+{
+    ErlNifBinary bin;
+    if (!enif_inspect_binary(env, input, &bin)) {
+        throw std::invalid_argument("expected a binary");
+    }
+
+    std::vector<Frame> frames;
+    size_t pos = 0;
+    while (bin.size - pos >= 12) {
+        const uint8_t *p = bin.data + pos;
+        size_t left = bin.size - pos;
+        if (load_be32(p) != FRAME_MAGIC) {
+            throw std::runtime_error("invalid frame magic");
+        }
+        uint32_t flags = load_be32(p + 4);
+        if (flags & ~FRAME_FLAG_METADATA) {
+            throw std::runtime_error("unsupported frame flags");
+        }
+        bool has_meta = flags & FRAME_FLAG_METADATA;
+        size_t header = has_meta ? 16 : 12;
+        if (left < header) break;
+
+        uint64_t chunk_len = load_be32(p + 8);
+        uint64_t meta_len = has_meta ? load_be32(p + 12) : 0;
+        if (left - header < meta_len + chunk_len) break;
+
+        std::optional<fine::Term> meta;
+        if (has_meta) {
+            meta = enif_make_sub_binary(env, input, pos + header, meta_len);
+        }
+        ERL_NIF_TERM chunk = enif_make_sub_binary(env, input, pos + header + meta_len, chunk_len);
+        frames.emplace_back(chunk, meta);
+        pos += header + meta_len + chunk_len;
+    }
+
+    ERL_NIF_TERM rest = enif_make_sub_binary(env, input, pos, bin.size - pos);
+    return fine::Ok(FrameBatch(std::move(frames), rest));
+}
+FINE_NIF(nif_gorilla_decode_frames, ERL_NIF_DIRTY_JOB_CPU_BOUND);
+
+// ---------------------------------------------------------------------------
+// Transcode NIFs
+// ---------------------------------------------------------------------------
+//
+// Re-encode chunks with different options (algorithm, VM preprocessing)
+// through scratch columns, without building per-point terms.
+
+static auto atom_parallel = fine::Atom("parallel");
+
+static std::vector<uint8_t> transcode_chunk(const uint8_t *data, size_t len,
+                                            const EncodeOptions &opts)
+{
+    if (len == 0) return {};
+
+    ChunkHeader hdr = parse_chunk_header(data, len);
+    std::vector<int64_t> timestamps(hdr.count);
+    std::vector<double> values(hdr.count);
+    std::vector<uint8_t> validity;
+    decode_chunk_into(data, hdr, timestamps.data(), values.data(), &validity);
+    return encode_chunk(timestamps.data(), timestamps.size(), std::move(values), opts,
+                        validity.empty() ? nullptr : validity.data());
+}
+
+static fine::Ok<ErlNifBinary>
+nif_gorilla_transcode(ErlNifEnv *env, ErlNifBinary data, fine::Term opts_term)
+{
+    EncodeOptions opts = parse_encode_options(env, opts_term);
+    return fine::Ok(chunk_to_binary(transcode_chunk(data.data, data.size, opts)));
+}
+FINE_NIF(nif_gorilla_transcode, ERL_NIF_DIRTY_JOB_CPU_BOUND);
+
+// Transcode a list of chunks. With `parallel: true` (or a thread count) the
+// chunks are split across worker threads; binaries are only allocated once
+// every worker has finished.
+static fine::Ok<std::vector<ErlNifBinary>>
+nif_gorilla_transcode_batch(ErlNifEnv *env, fine::Term chunks_term, fine::Term opts_term)
+{
+    EncodeOptions opts = parse_encode_options(env, opts_term);
+
+    size_t threads = 1;
+    ERL_NIF_TERM opt_val;
+    if (enif_get_map_value(env, opts_term, fine::encode(env, atom_parallel), &opt_val)) {
+        ErlNifSInt64 n;
+        if (enif_get_int64(env, opt_val, &n)) {
+            threads = n > 1 ? static_cast<size_t>(n) : 1;
+        } else if (fine::decode<bool>(env, opt_val)) {
+            threads = std::max(1u, std::thread::hardware_concurrency());
+        }
+    }
+
+    std::vector<ErlNifBinary> inputs;
+    ERL_NIF_TERM head, tail;
+    ERL_NIF_TERM list = chunks_term;
+    while (enif_get_list_cell(env, list, &head, &tail)) {
+        ErlNifBinary chunk;
+        if (!enif_inspect_binary(env, head, &chunk)) {
+            throw std::invalid_argument("expected a list of binaries");
+        }
+        inputs.push_back(chunk);
+        list = tail;
+    }
+
+    std::vector<std::vector<uint8_t>> outputs(inputs.size());
+    threads = std::min(threads, inputs.size());
+
+    if (threads <= 1) {
+        for (size_t i = 0; i < inputs.size(); i++) {
+            outputs[i] = transcode_chunk(inputs[i].data, inputs[i].size, opts);
+        }
+    } else {
+        // Workers take chunks round-robin and stop at the first error
+        std::vector<std::exception_ptr> errors(threads);
+        std::vector<std::thread> workers;
+        for (size_t t = 0; t < threads; t++) {
+            workers.emplace_back([&, t] {
+                try {
+                    for (size_t i = t; i < inputs.size(); i += threads) {
+                        outputs[i] = transcode_chunk(inputs[i].data, inputs[i].size, opts);
+                    }
+                } catch (...) {
+                    errors[t] = std::current_exception();
+                }
+            });
+        }
+        for (auto &w : workers) w.join();
+        for (auto &e : errors) {
+            if (e) std::rethrow_exception(e);
+        }
+    }
+
+    std::vector<ErlNifBinary> result;
+    result.reserve(outputs.size());
+    for (const auto &chunk : outputs) {
+        result.push_back(chunk_to_binary(chunk));
+    }
+    return fine::Ok(result);
+}
+FINE_NIF(nif_gorilla_transcode_batch, ERL_NIF_DIRTY_JOB_CPU_BOUND);
+
+// ---------------------------------------------------------------------------
+// FlatBuffers — minimal writer and reader for Arrow IPC metadata
+// ---------------------------------------------------------------------------
+//
+// Arrow IPC metadata is FlatBuffers-encoded. Only the handful of tables the
+// exporter and importer need are written, so instead of a generic builder
+// this lays objects out front-to-back: a parent is written first with
+// placeholder offset slots, and each child is appended later and patched
+// into its slot (uoffsets always point forward). All integers are
+// little-endian, as FlatBuffers requires.
+
+class FbWriter {
+public:
+    size_t size() const { return buf_.size(); }
+    const std::vector<uint8_t> &bytes() const { return buf_; }
+
+    void pad_to(size_t align) {
+        while (buf_.size() % align) buf_.push_back(0);
+    }
+
+    void put(uint64_t v, int nbytes) {
+        for (int i = 0; i < nbytes; i++) buf_.push_back(static_cast<uint8_t>(v >> (8 * i)));
+    }
+
+    void put_at(size_t pos, uint64_t v, int nbytes) {
+        for (int i = 0; i < nbytes; i++) buf_[pos + i] = static_cast<uint8_t>(v >> (8 * i));
+    }
+
+    // Reserve a 4-byte uoffset to be pointed at an object written later.
+    size_t offset_slot() {
+        pad_to(4);
+        size_t pos = size();
+        put(0, 4);
+        return pos;
+    }
+
+    void patch(size_t slot, size_t target) {
+        put_at(slot, static_cast<uint32_t>(target - slot), 4);
+    }
+
+    size_t string(const std::string &s) {
+        pad_to(4);
+        size_t pos = size();
+        put(s.size(), 4);
+        buf_.insert(buf_.end(), s.begin(), s.end());
+        buf_.push_back(0);
+        return pos;
+    }
+
+    // Vector of `n` offset slots; returns the vector position and slot positions.
+    size_t offset_vector(size_t n, std::vector<size_t> &slots) {
+        pad_to(4);
+        size_t pos = size();
+        put(n, 4);
+        slots.clear();
+        for (size_t i = 0; i < n; i++) {
+            slots.push_back(size());
+            put(0, 4);
+        }
+        return pos;
+    }
+
+    // Vector of 8-byte-aligned structs made of int64 words (FieldNode,
+    // Buffer). The length prefix sits right before the aligned data.
+    size_t struct_vector(const std::vector<std::vector<int64_t>> &items) {
+        while ((buf_.size() + 4) % 8) buf_.push_back(0);
+        size_t pos = size();
+        put(items.size(), 4);
+        for (const auto &item : items) {
+            for (int64_t word : item) put(static_cast<uint64_t>(word), 8);
+        }
+        return pos;
+    }
+
+private:
+    std::vector<uint8_t> buf_;
+};
+
+// A table under construction: fields are declared, then finish() writes the
+// vtable followed by the table, laying fields out largest-first so every
+// scalar is naturally aligned.
+class FbTable {
+public:
+    FbTable &scalar(uint16_t id, uint64_t value, int size) {
+        fields_.push_back({id, size, value, false});
+        return *this;
+    }
+
+    FbTable &offset(uint16_t id) {
+        fields_.push_back({id, 4, 0, true});
+        return *this;
+    }
+
+    // Position of the offset slot declared for `id` (valid after finish()).
+    size_t slot(uint16_t id) const {
+        for (const auto &f : fields_) {
+            if (f.id == id) return table_pos_ + f.pos;
+        }
+        throw std::logic_error("FbTable: no such field");
+    }
+
+    size_t finish(FbWriter &w) {
+        std::stable_sort(fields_.begin(), fields_.end(),
+                         [](const Field &a, const Field &b) { return a.size > b.size; });
+
+        int max_align = 4;
+        uint16_t max_id = 0;
+        size_t pos = 4;  // after the soffset to the vtable
+        for (auto &f : fields_) {
+            max_align = std::max(max_align, f.size);
+            max_id = std::max(max_id, f.id);
+            pos = (pos + f.size - 1) / f.size * f.size;
+            f.pos = pos;
+            pos += f.size;
+        }
+        size_t table_size = pos;
+        size_t num_slots = fields_.empty() ? 0 : max_id + 1;
+
+        w.pad_to(2);
+        size_t vtable_pos = w.size();
+        w.put(4 + 2 * num_slots, 2);
+        w.put(table_size, 2);
+        for (size_t id = 0; id < num_slots; id++) {
+            uint64_t field_off = 0;
+            for (const auto &f : fields_) {
+                if (f.id == id) field_off = f.pos;
+            }
+            w.put(field_off, 2);
+        }
+
+        w.pad_to(max_align);
+        table_pos_ = w.size();
+        w.put(static_cast<uint32_t>(table_pos_ - vtable_pos), 4);
+        while (w.size() < table_pos_ + table_size) w.put(0, 1);
+        for (const auto &f : fields_) {
+            if (!f.is_offset) w.put_at(table_pos_ + f.pos, f.value, f.size);
+        }
+        return table_pos_;
+    }
+
+private:
+    struct Field {
+        uint16_t id;
+        int size;
+        uint64_t value;
+        bool is_offset;
+        size_t pos = 0;
+    };
+
+    std::vector<Field> fields_;
+    size_t table_pos_ = 0;
+};
+
+// Bounds-checked view of a table inside a FlatBuffer.
+class FbTableReader {
+public:
+    FbTableReader(const uint8_t *buf, size_t len, size_t table_pos)
+        : buf_(buf), len_(len), pos_(table_pos)
+    {
+        int64_t vt = static_cast<int64_t>(pos_) - static_cast<int32_t>(get(pos_, 4));
+        if (vt < 0 || static_cast<size_t>(vt) + 4 > len_) malformed();
+        vtable_ = static_cast<size_t>(vt);
+        vtable_size_ = get(vtable_, 2);
+    }
+
+    static FbTableReader root(const uint8_t *buf, size_t len) {
+        if (len < 4) malformed();
+        return FbTableReader(buf, len, static_cast<size_t>(read_le(buf, 4)));
+    }
+
+    bool has(uint16_t id) const { return field_pos(id) != 0; }
+
+    uint64_t scalar(uint16_t id, int size, uint64_t def = 0) const {
+        size_t p = field_pos(id);
+        return p ? get(p, size) : def;
+    }
+
+    // Absolute position of the object an offset field points to.
+    size_t target(uint16_t id) const {
+        size_t p = field_pos(id);
+        if (!p) malformed();
+        return p + get(p, 4);
+    }
+
+    FbTableReader table(uint16_t id) const { return FbTableReader(buf_, len_, target(id)); }
+
+    size_t vector_length(uint16_t id) const {
+        return has(id) ? get(target(id), 4) : 0;
+    }
+
+    // Table element `i` of a vector of tables.
+    FbTableReader vector_table(uint16_t id, size_t i) const {
+        size_t elem = target(id) + 4 + 4 * i;
+        return FbTableReader(buf_, len_, elem + get(elem, 4));
+    }
+
+    // int64 word `word` of struct element `i` in a vector of int64 structs.
+    int64_t vector_struct_word(uint16_t id, size_t i, size_t words, size_t word) const {
+        if (i >= vector_length(id)) malformed();
+        size_t elem = target(id) + 4 + 8 * (i * words + word);
+        return static_cast<int64_t>(get(elem, 8));
+    }
+
+    std::string string(uint16_t id) const {
+        if (!has(id)) return std::string();
+        size_t p = target(id);
+        size_t n = get(p, 4);
+        if (p + 4 + n > len_) malformed();
+        return std::string(reinterpret_cast<const char *>(buf_ + p + 4), n);
+    }
+
+private:
+    [[noreturn]] static void malformed() {
+        throw std::runtime_error("malformed Arrow IPC metadata");
+    }
+
+    static uint64_t read_le(const uint8_t *p, int nbytes) {
+        uint64_t v = 0;
+        for (int i = nbytes - 1; i >= 0; i--) v = (v << 8) | p[i];
+        return v;
+    }
+
+    uint64_t get(size_t pos, int nbytes) const {
+        if (pos + nbytes > len_) malformed();
+        return read_le(buf_ + pos, nbytes);
+    }
+
+    size_t field_pos(uint16_t id) const {
+        size_t entry = 4 + 2 * static_cast<size_t>(id);
+        if (entry + 2 > vtable_size_) return 0;
+        size_t off = get(vtable_ + entry, 2);
+        return off ? pos_ + off : 0;
+    }
+
+    const uint8_t *buf_;
+    size_t len_;
+    size_t pos_;
+    size_t vtable_;
+    size_t vtable_size_;
+};
+
+// ---------------------------------------------------------------------------
+// Arrow IPC — export and import of {timestamp, float64} record batches
+// ---------------------------------------------------------------------------
+//
+// Stream format: [schema message] [record batch message]* [end-of-stream]
+// File format:   "ARROW1\0\0" [stream] [footer] [footer size: 32] "ARROW1"
+// Each message:  0xFFFFFFFF, metadata size: 32, Message flatbuffer padded to
+//                8 bytes, then the body (bodyLength bytes).
+//
+// A record batch body holds, per column, an empty validity buffer followed by
+// the native-endian data buffer, so decoded chunks are written straight into
+// their final place in the output binary.
+
+enum ArrowType : uint8_t {
+    ARROW_TYPE_NULL = 1, ARROW_TYPE_INT = 2, ARROW_TYPE_FLOATING_POINT = 3,
+    ARROW_TYPE_BINARY = 4, ARROW_TYPE_UTF8 = 5, ARROW_TYPE_BOOL = 6,
+    ARROW_TYPE_DECIMAL = 7, ARROW_TYPE_DATE = 8, ARROW_TYPE_TIME = 9,
+    ARROW_TYPE_TIMESTAMP = 10, ARROW_TYPE_INTERVAL = 11, ARROW_TYPE_LIST = 12,
+    ARROW_TYPE_STRUCT = 13, ARROW_TYPE_UNION = 14, ARROW_TYPE_FIXED_SIZE_BINARY = 15,
+    ARROW_TYPE_FIXED_SIZE_LIST = 16, ARROW_TYPE_MAP = 17, ARROW_TYPE_DURATION = 18,
+    ARROW_TYPE_LARGE_BINARY = 19, ARROW_TYPE_LARGE_UTF8 = 20, ARROW_TYPE_LARGE_LIST = 21,
+};
+
+static constexpr uint16_t ARROW_METADATA_V5 = 4;
+static constexpr uint8_t ARROW_HEADER_SCHEMA = 1;
+static constexpr uint8_t ARROW_HEADER_RECORD_BATCH = 3;
+static constexpr uint16_t ARROW_PRECISION_SINGLE = 1;
+static constexpr uint16_t ARROW_PRECISION_DOUBLE = 2;
+static const char ARROW_FILE_MAGIC[] = "ARROW1";
+
+struct ArrowExportOptions {
+    bool file_format = false;
+    uint16_t time_unit = 3;  // TimeUnit.NANOSECOND
+    std::string timestamp_name = "timestamp";
+    std::string value_name = "value";
+};
+
+static void write_arrow_field(FbWriter &w, size_t slot, const std::string &name,
+                              ArrowType type, const FbTable &type_fields)
+{
+    FbTable field;
+    field.offset(0)                      // name
+         .scalar(1, 0, 1)                // nullable: false
+         .scalar(2, type, 1)             // type_type
+         .offset(3)                      // type
+         .offset(5);                     // children
+    w.patch(slot, field.finish(w));
+
+    w.patch(field.slot(0), w.string(name));
+    FbTable type_table = type_fields;
+    w.patch(field.slot(3), type_table.finish(w));
+    std::vector<size_t> none;
+    w.patch(field.slot(5), w.offset_vector(0, none));
+}
+
+// Write a Schema table for the two columns into `slot`.
+static void write_arrow_schema(FbWriter &w, size_t slot, const ArrowExportOptions &opts) {
+    FbTable schema;
+    schema.scalar(0, IS_BIG_ENDIAN ? 1 : 0, 2)  // endianness
+          .offset(1);                           // fields
+    w.patch(slot, schema.finish(w));
+
+    std::vector<size_t> field_slots;
+    w.patch(schema.slot(1), w.offset_vector(2, field_slots));
+
+    FbTable timestamp_type;
+    timestamp_type.scalar(0, opts.time_unit, 2);
+    write_arrow_field(w, field_slots[0], opts.timestamp_name, ARROW_TYPE_TIMESTAMP, timestamp_type);
+
+    FbTable double_type;
+    double_type.scalar(0, ARROW_PRECISION_DOUBLE, 2);
+    write_arrow_field(w, field_slots[1], opts.value_name, ARROW_TYPE_FLOATING_POINT, double_type);
+}
+
+// Finish a Message flatbuffer and prepend the continuation marker and
+// padded metadata length.
+static std::vector<uint8_t> frame_arrow_message(const FbWriter &w) {
+    size_t padded = (w.size() + 7) / 8 * 8;
+    std::vector<uint8_t> out;
+    out.reserve(8 + padded);
+    FbWriter prefix;
+    prefix.put(0xFFFFFFFFu, 4);
+    prefix.put(padded, 4);
+    out.insert(out.end(), prefix.bytes().begin(), prefix.bytes().end());
+    out.insert(out.end(), w.bytes().begin(), w.bytes().end());
+    out.resize(8 + padded, 0);
+    return out;
+}
+
+static std::vector<uint8_t> build_arrow_schema_message(const ArrowExportOptions &opts) {
+    FbWriter w;
+    size_t root = w.offset_slot();
+
+    FbTable message;
+    message.scalar(0, ARROW_METADATA_V5, 2)
+           .scalar(1, ARROW_HEADER_SCHEMA, 1)
+           .offset(2)
+           .scalar(3, 0, 8);  // bodyLength
+    w.patch(root, message.finish(w));
+    write_arrow_schema(w, message.slot(2), opts);
+
+    return frame_arrow_message(w);
+}
+
+static std::vector<uint8_t> build_arrow_batch_message(int64_t rows) {
+    int64_t column_bytes = rows * 8;
+
+    FbWriter w;
+    size_t root = w.offset_slot();
+
+    FbTable message;
+    message.scalar(0, ARROW_METADATA_V5, 2)
+           .scalar(1, ARROW_HEADER_RECORD_BATCH, 1)
+           .offset(2)
+           .scalar(3, static_cast<uint64_t>(column_bytes * 2), 8);
+    w.patch(root, message.finish(w));
+
+    FbTable batch;
+    batch.scalar(0, static_cast<uint64_t>(rows), 8)  // length
+         .offset(1)                                  // nodes
+         .offset(2);                                 // buffers
+    w.patch(message.slot(2), batch.finish(w));
+
+    w.patch(batch.slot(1), w.struct_vector({{rows, 0}, {rows, 0}}));
+    w.patch(batch.slot(2), w.struct_vector({
+        {0, 0}, {0, column_bytes},                        // timestamp validity, data
+        {column_bytes, 0}, {column_bytes, column_bytes},  // value validity, data
+    }));
+
+    return frame_arrow_message(w);
+}
+
+struct ArrowBlock {
+    int64_t offset;
+    int32_t metadata_length;
+    int64_t body_length;
+};
+
+static std::vector<uint8_t> build_arrow_footer(const ArrowExportOptions &opts,
+                                               const std::vector<ArrowBlock> &blocks)
+{
+    FbWriter w;
+    size_t root = w.offset_slot();
+
+    FbTable footer;
+    footer.scalar(0, ARROW_METADATA_V5, 2)
+          .offset(1)   // schema
+          .offset(2)   // dictionaries
+          .offset(3);  // recordBatches
+    w.patch(root, footer.finish(w));
+    write_arrow_schema(w, footer.slot(1), opts);
+
+    // Block is {offset: long, metaDataLength: int, <pad>, bodyLength: long}
+    std::vector<std::vector<int64_t>> items;
+    for (const auto &b : blocks) {
+        items.push_back({b.offset, static_cast<int64_t>(static_cast<uint32_t>(b.metadata_length)), b.body_length});
+    }
+    w.patch(footer.slot(2), w.struct_vector({}));
+    w.patch(footer.slot(3), w.struct_vector(items));
+
+    return w.bytes();
+}
+
+// ---------------------------------------------------------------------------
+// Arrow IPC import
+// ---------------------------------------------------------------------------
+
+struct ArrowColumnRef {
+    int field = -1;          // top-level field index
+    size_t node = 0;         // FieldNode index
+    size_t buffer = 0;       // index of the validity buffer
+    ArrowType type = ARROW_TYPE_NULL;
+    uint16_t precision = 0;  // FloatingPoint only
+    int32_t bit_width = 0;   // Int only
+};
+
+struct ArrowSchemaInfo {
+    bool big_endian = false;
+    std::vector<std::string> names;
+    std::vector<ArrowColumnRef> columns;  // one per top-level field
+};
+
+// Walk a field (and its children, depth-first) counting the FieldNodes and
+// buffers it occupies in every record batch.
+static void walk_arrow_field(const FbTableReader &field, size_t &node, size_t &buffer,
+                             ArrowColumnRef *ref)
+{
+    ArrowType type = static_cast<ArrowType>(field.scalar(2, 1));
+    if (ref) {
+        ref->node = node;
+        ref->buffer = buffer;
+        ref->type = type;
+        if (type == ARROW_TYPE_FLOATING_POINT) {
+            ref->precision = static_cast<uint16_t>(field.table(3).scalar(0, 2));
+        } else if (type == ARROW_TYPE_INT) {
+            FbTableReader t = field.table(3);
+            ref->bit_width = static_cast<int32_t>(t.scalar(0, 4));
+        }
+    }
+
+    node += 1;
+    switch (type) {
+    case ARROW_TYPE_NULL:
+        break;
+    case ARROW_TYPE_STRUCT:
+    case ARROW_TYPE_FIXED_SIZE_LIST:
+        buffer += 1;
+        break;
+    case ARROW_TYPE_BINARY:
+    case ARROW_TYPE_UTF8:
+    case ARROW_TYPE_LARGE_BINARY:
+    case ARROW_TYPE_LARGE_UTF8:
+        buffer += 3;
+        break;
+    case ARROW_TYPE_LIST:
+    case ARROW_TYPE_LARGE_LIST:
+    case ARROW_TYPE_MAP:
+    case ARROW_TYPE_INT:
+    case ARROW_TYPE_FLOATING_POINT:
+    case ARROW_TYPE_BOOL:
+    case ARROW_TYPE_DECIMAL:
+    case ARROW_TYPE_DATE:
+    case ARROW_TYPE_TIME:
+    case ARROW_TYPE_TIMESTAMP:
+    case ARROW_TYPE_INTERVAL:
+    case ARROW_TYPE_FIXED_SIZE_BINARY:
+    case ARROW_TYPE_DURATION:
+        buffer += 2;
+        break;
+    default:
+        throw std::runtime_error("unsupported Arrow type in schema");
+    }
+
+    size_t n_children = field.vector_length(5);
+    for (size_t i = 0; i < n_children; i++) {
+        walk_arrow_field(field.vector_table(5, i), node, buffer, nullptr);
+    }
+}
+
+static ArrowSchemaInfo parse_arrow_schema(const FbTableReader &schema) {
+    ArrowSchemaInfo info;
+    info.big_endian = schema.scalar(0, 2) == 1;
+
+    size_t node = 0, buffer = 0;
+    size_t n_fields = schema.vector_length(1);
+    for (size_t i = 0; i < n_fields; i++) {
+        FbTableReader field = schema.vector_table(1, i);
+        ArrowColumnRef ref;
+        ref.field = static_cast<int>(i);
+        walk_arrow_field(field, node, buffer, &ref);
+        info.names.push_back(field.string(0));
+        info.columns.push_back(ref);
+    }
+    return info;
+}
+
+// Resolve a column by name, or the first column accepted by `pred`.
+template <typename Pred>
+static const ArrowColumnRef &select_arrow_column(const ArrowSchemaInfo &info,
+                                                 const std::string &name, Pred pred,
+                                                 const char *what)
+{
+    for (size_t i = 0; i < info.columns.size(); i++) {
+        bool matches = name.empty() ? pred(info.columns[i]) : info.names[i] == name;
+        if (matches) {
+            if (!pred(info.columns[i])) {
+                throw std::invalid_argument(std::string(what) + " column has an unsupported type");
+            }
+            return info.columns[i];
+        }
+    }
+    throw std::invalid_argument(std::string("no ") + what + " column found in Arrow schema");
+}
+
+static bool arrow_timestamp_like(const ArrowColumnRef &c) {
+    return c.type == ARROW_TYPE_TIMESTAMP || (c.type == ARROW_TYPE_INT && c.bit_width == 64);
+}
+
+static bool arrow_value_like(const ArrowColumnRef &c) {
+    return (c.type == ARROW_TYPE_FLOATING_POINT &&
+            (c.precision == ARROW_PRECISION_DOUBLE || c.precision == ARROW_PRECISION_SINGLE)) ||
+           (c.type == ARROW_TYPE_INT && c.bit_width == 64);
+}
+
+static uint64_t load_word(const uint8_t *p, int nbytes, bool swap) {
+    uint64_t v = 0;
+    memcpy(&v, p, nbytes);
+    if (swap) v = byte_swap_64(v) >> (64 - 8 * nbytes);
+    return v;
+}
+
+struct ArrowBatchView {
+    const uint8_t *body;
+    size_t body_len;
+    FbTableReader batch;
+};
+
+// Locate the data buffer of `col` in a record batch and check it holds
+// `rows` elements of `width` bytes with no nulls.
+static const uint8_t *arrow_column_data(const ArrowBatchView &view, const ArrowColumnRef &col,
+                                        int64_t rows, int width)
+{
+    if (view.batch.has(3)) {
+        throw std::runtime_error("compressed Arrow record batches are not supported");
+    }
+    int64_t null_count = view.batch.vector_struct_word(1, col.node, 2, 1);
+    if (null_count != 0) {
+        throw std::runtime_error("Arrow columns with nulls are not supported");
+    }
+    int64_t offset = view.batch.vector_struct_word(2, col.buffer + 1, 2, 0);
+    int64_t length = view.batch.vector_struct_word(2, col.buffer + 1, 2, 1);
+    // Bound rows by the body first so rows * width cannot overflow
+    if (static_cast<uint64_t>(rows) > view.body_len / width || offset < 0 ||
+        length < rows * width ||
+        static_cast<size_t>(offset) > view.body_len - static_cast<size_t>(rows) * width) {
+        throw std::runtime_error("Arrow buffer extends beyond message body");
+    }
+    return view.body + offset;
+}
+
+struct ArrowImportOptions {
+    std::string timestamp_column;
+    std::string value_column;
+};
+
+// Parse an Arrow IPC stream or file and encode every record batch into a
+// chunk, reading the two columns straight out of the message bodies.
+static std::vector<std::vector<uint8_t>> arrow_to_chunks(const uint8_t *data, size_t len,
+                                                         const ArrowImportOptions &aopts,
+                                                         const EncodeOptions &eopts)
+{
+    size_t pos = 0;
+    size_t end = len;
+
+    if (len >= 6 && memcmp(data, ARROW_FILE_MAGIC, 6) == 0) {
+        if (len < 18 || memcmp(data + len - 6, ARROW_FILE_MAGIC, 6) != 0) {
+            throw std::runtime_error("truncated Arrow IPC file");
+        }
+        uint32_t footer_len = static_cast<uint32_t>(load_word(data + len - 10, 4, IS_BIG_ENDIAN));
+        if (footer_len > len - 18) {
+            throw std::runtime_error("truncated Arrow IPC file");
+        }
+        pos = 8;
+        end = len - 10 - footer_len;
+    }
+
+    bool have_schema = false;
+    ArrowSchemaInfo schema;
+    const ArrowColumnRef *ts_col = nullptr;
+    const ArrowColumnRef *val_col = nullptr;
+    std::vector<std::vector<uint8_t>> chunks;
+
+    while (pos + 4 <= end) {
+        uint32_t meta_len = static_cast<uint32_t>(load_word(data + pos, 4, IS_BIG_ENDIAN));
+        pos += 4;
+        if (meta_len == 0xFFFFFFFFu) {
+            if (pos + 4 > end) break;
+            meta_len = static_cast<uint32_t>(load_word(data + pos, 4, IS_BIG_ENDIAN));
+            pos += 4;
+        }
+        if (meta_len == 0) break;  // end-of-stream
+        if (meta_len > end - pos) {
+            throw std::runtime_error("truncated Arrow IPC message");
+        }
+
+        FbTableReader message = FbTableReader::root(data + pos, meta_len);
+        uint8_t header_type = static_cast<uint8_t>(message.scalar(1, 1));
+        int64_t body_len = static_cast<int64_t>(message.scalar(3, 8));
+        const uint8_t *body = data + pos + meta_len;
+        pos += meta_len;
+        if (body_len < 0 || static_cast<size_t>(body_len) > end - pos) {
+            throw std::runtime_error("truncated Arrow IPC message body");
+        }
+        pos += static_cast<size_t>(body_len);
+
+        if (header_type == ARROW_HEADER_SCHEMA) {
+            schema = parse_arrow_schema(message.table(2));
+            ts_col = &select_arrow_column(schema, aopts.timestamp_column,
+                                          arrow_timestamp_like, "timestamp");
+            val_col = &select_arrow_column(schema, aopts.value_column,
+                                           arrow_value_like, "value");
+            have_schema = true;
+        } else if (header_type == ARROW_HEADER_RECORD_BATCH) {
+            if (!have_schema) {
+                throw std::runtime_error("Arrow record batch before schema");
+            }
+            ArrowBatchView view{body, static_cast<size_t>(body_len), message.table(2)};
+            int64_t rows = static_cast<int64_t>(view.batch.scalar(0, 8));
+            if (rows <= 0) continue;
+
+            bool swap = schema.big_endian != static_cast<bool>(IS_BIG_ENDIAN);
+            const uint8_t *ts_data = arrow_column_data(view, *ts_col, rows, 8);
+            int val_width = (val_col->type == ARROW_TYPE_FLOATING_POINT &&
+                             val_col->precision == ARROW_PRECISION_SINGLE) ? 4 : 8;
+            const uint8_t *val_data = arrow_column_data(view, *val_col, rows, val_width);
+
+            std::vector<int64_t> timestamps(static_cast<size_t>(rows));
+            std::vector<double> values(static_cast<size_t>(rows));
+            for (int64_t i = 0; i < rows; i++) {
+                timestamps[i] = static_cast<int64_t>(load_word(ts_data + 8 * i, 8, swap));
+                uint64_t raw = load_word(val_data + val_width * i, val_width, swap);
+                if (val_col->type == ARROW_TYPE_INT) {
+                    values[i] = static_cast<double>(static_cast<int64_t>(raw));
+                } else if (val_width == 4) {
+                    float f;
+                    uint32_t raw32 = static_cast<uint32_t>(raw);
+                    memcpy(&f, &raw32, sizeof(f));
+                    values[i] = f;
+                } else {
+                    memcpy(&values[i], &raw, sizeof(double));
+                }
+            }
+
+            EncodeOptions opts = eopts;
+            fit_timestamp_codec(opts, timestamps.data(), timestamps.size());
+            chunks.push_back(encode_chunk(timestamps.data(), timestamps.size(),
+                                          std::move(values), opts));
+        }
+        // Dictionary batches and other messages are skipped
+    }
+
+    if (!have_schema) {
+        throw std::runtime_error("Arrow IPC data has no schema");
+    }
+    return chunks;
+}
+
+// Decode `chunks` into one Arrow IPC stream (or file), one record batch per
+// non-empty chunk, writing every column directly into the output binary.
+static ErlNifBinary chunks_to_arrow(const std::vector<ErlNifBinary> &input,
+                                    const ArrowExportOptions &opts)
+{
+    std::vector<const uint8_t *> chunks;
+    std::vector<ChunkHeader> headers;
+    for (const auto &chunk : input) {
+        if (chunk.size == 0) continue;
+        ChunkHeader hdr = parse_chunk_header(chunk.data, chunk.size);
+        if (hdr.count == 0) continue;
+        chunks.push_back(chunk.data);
+        headers.push_back(hdr);
+    }
+
+    // Lay out every message up front so the output is allocated once
+    auto schema_msg = build_arrow_schema_message(opts);
+    std::vector<std::vector<uint8_t>> batch_msgs;
+    std::vector<ArrowBlock> blocks;
+    size_t prefix = opts.file_format ? 8 : 0;
+    size_t total = prefix + schema_msg.size();
+    for (const auto &hdr : headers) {
+        batch_msgs.push_back(build_arrow_batch_message(hdr.count));
+        int64_t body = static_cast<int64_t>(hdr.count) * 16;
+        blocks.push_back({static_cast<int64_t>(total),
+                          static_cast<int32_t>(batch_msgs.back().size()), body});
+        total += batch_msgs.back().size() + static_cast<size_t>(body);
+    }
+    total += 8;  // end-of-stream marker
+
+    std::vector<uint8_t> footer;
+    if (opts.file_format) {
+        footer = build_arrow_footer(opts, blocks);
+        total += footer.size() + 4 + 6;
+    }
+
+    OwnedBinary out(total);
+    uint8_t *p = out.data();
+    if (opts.file_format) {
+        memcpy(p, ARROW_FILE_MAGIC, 6);
+        p[6] = p[7] = 0;
+        p += 8;
+    }
+    memcpy(p, schema_msg.data(), schema_msg.size());
+    p += schema_msg.size();
+
+    for (size_t i = 0; i < chunks.size(); i++) {
+        memcpy(p, batch_msgs[i].data(), batch_msgs[i].size());
+        p += batch_msgs[i].size();
+        size_t column_bytes = static_cast<size_t>(headers[i].count) * 8;
+        decode_chunk_into(chunks[i], headers[i],
+                          reinterpret_cast<int64_t *>(p),
+                          reinterpret_cast<double *>(p + column_bytes));
+        p += 2 * column_bytes;
+    }
+
+    FbWriter trailer;
+    trailer.put(0xFFFFFFFFu, 4);  // end-of-stream
+    trailer.put(0, 4);
+    if (opts.file_format) {
+        trailer.put(footer.size(), 4);
+    }
+    memcpy(p, trailer.bytes().data(), 8);
+    p += 8;
+
+    if (opts.file_format) {
+        memcpy(p, footer.data(), footer.size());
+        p += footer.size();
+        memcpy(p, trailer.bytes().data() + 8, 4);
+        p += 4;
+        memcpy(p, ARROW_FILE_MAGIC, 6);
+    }
+
+    return out.release();
+}
+
+// ---------------------------------------------------------------------------
+// Arrow NIFs
+// ---------------------------------------------------------------------------
+
+static auto atom_format = fine::Atom("format");
+static auto atom_file = fine::Atom("file");
+static auto atom_unit = fine::Atom("unit");
+static auto atom_second = fine::Atom("second");
+static auto atom_millisecond = fine::Atom("millisecond");
+static auto atom_microsecond = fine::Atom("microsecond");
+static auto atom_timestamp_column = fine::Atom("timestamp_column");
+static auto atom_value_column = fine::Atom("value_column");
+
+static std::string get_string_option(ErlNifEnv *env, ERL_NIF_TERM opts_term,
+                                     const fine::Atom &key, const std::string &def)
+{
+    ERL_NIF_TERM opt_val;
+    ErlNifBinary bin;
+    if (enif_get_map_value(env, opts_term, fine::encode(env, key), &opt_val) &&
+        enif_inspect_binary(env, opt_val, &bin)) {
+        return std::string(reinterpret_cast<const char *>(bin.data), bin.size);
+    }
+    return def;
+}
+
+// Decode a list of chunks into one Arrow IPC stream (or file) with a
+// timestamp column and a float64 column, one record batch per chunk.
+static fine::Ok<ErlNifBinary>
+nif_gorilla_to_arrow(ErlNifEnv *env, fine::Term chunks_term, fine::Term opts_term)
+{
+    ArrowExportOptions opts;
+    ERL_NIF_TERM opt_val;
+    if (enif_get_map_value(env, opts_term, fine::encode(env, atom_format), &opt_val)) {
+        opts.file_format = enif_is_identical(opt_val, fine::encode(env, atom_file));
+    }
+    if (enif_get_map_value(env, opts_term, fine::encode(env, atom_unit), &opt_val)) {
+        if (enif_is_identical(opt_val, fine::encode(env, atom_second))) {
+            opts.time_unit = 0;
+        } else if (enif_is_identical(opt_val, fine::encode(env, atom_millisecond))) {
+            opts.time_unit = 1;
+        } else if (enif_is_identical(opt_val, fine::encode(env, atom_microsecond))) {
+            opts.time_unit = 2;
+        }
+    }
+    opts.timestamp_name = get_string_option(env, opts_term, atom_timestamp_column, opts.timestamp_name);
+    opts.value_name = get_string_option(env, opts_term, atom_value_column, opts.value_name);
+
+    std::vector<ErlNifBinary> chunks;
+    ERL_NIF_TERM head, tail;
+    ERL_NIF_TERM list = chunks_term;
+    while (enif_get_list_cell(env, list, &head, &tail)) {
+        ErlNifBinary chunk;
+        if (!enif_inspect_binary(env, head, &chunk)) {
+            throw std::invalid_argument("expected a list of binaries");
+        }
+        chunks.push_back(chunk);
+        list = tail;
+    }
+
+    return fine::Ok(chunks_to_arrow(chunks, opts));
+}
+FINE_NIF(nif_gorilla_to_arrow, ERL_NIF_DIRTY_JOB_CPU_BOUND);
+
+// Encode every record batch of an Arrow IPC stream or file into a chunk.
+static fine::Ok<std::vector<ErlNifBinary>>
+nif_gorilla_from_arrow(ErlNifEnv *env, ErlNifBinary data, fine::Term opts_term)
+{
+    ArrowImportOptions aopts;
+    aopts.timestamp_column = get_string_option(env, opts_term, atom_timestamp_column, "");
+    aopts.value_column = get_string_option(env, opts_term, atom_value_column, "");
+    EncodeOptions eopts = parse_encode_options(env, opts_term);
+
+    auto chunks = arrow_to_chunks(data.data, data.size, aopts, eopts);
+
+    std::vector<ErlNifBinary> result;
+    result.reserve(chunks.size());
+    for (const auto &chunk : chunks) {
+        result.push_back(chunk_to_binary(chunk));
+    }
+    return fine::Ok(result);
+}
+FINE_NIF(nif_gorilla_from_arrow, ERL_NIF_DIRTY_JOB_CPU_BOUND);
+
+// ---------------------------------------------------------------------------
+// Prometheus XOR chunks
+// ---------------------------------------------------------------------------
+//
+// Layout of a Prometheus TSDB XOR chunk (chunkenc.XORChunk.Bytes()):
+//   [sample count: 16 BE] then an MSB-first bitstream of
+//   sample 0: varint(t) as whole bytes, value as 64 raw bits
+//   sample 1: uvarint(t - t0) as whole bytes, XOR value
+//   sample n: delta-of-delta in buckets '0' | '10'+14 | '110'+17 | '1110'+20
+//             | '1111'+64 bits, then XOR value
+// XOR values reuse the previous leading/trailing window when it covers the
+// new one, otherwise they write 5 bits of leading zeros (clamped to 31) and
+// 6 bits of significant bits (64 stored as 0).
+//
+// Transcoding goes through the decoded columns only; no terms are built.
+
+static constexpr size_t PROM_MAX_SAMPLES = 65535;
+
+// Prometheus XORs the IEEE 754 bit pattern as an integer, on every platform
+// (unlike float_to_bits, which mirrors the Elixir encoder's byte order).
+static inline uint64_t prom_value_bits(double v) {
+    uint64_t bits;
+    memcpy(&bits, &v, sizeof(bits));
+    return bits;
+}
+
+static inline double prom_bits_value(uint64_t bits) {
+    double v;
+    memcpy(&v, &bits, sizeof(v));
+    return v;
+}
+
+static void prom_write_uvarint(BitWriter &w, uint64_t v) {
+    while (v >= 0x80) {
+        w.write((v & 0x7F) | 0x80, 8);
+        v >>= 7;
+    }
+    w.write(v, 8);
+}
+
+static void prom_write_varint(BitWriter &w, int64_t v) {
+    uint64_t zigzag = (static_cast<uint64_t>(v) << 1) ^ static_cast<uint64_t>(v >> 63);
+    prom_write_uvarint(w, zigzag);
+}
+
+static uint64_t prom_read_uvarint(BitReader &r) {
+    uint64_t v = 0;
+    for (int shift = 0; shift < 70; shift += 7) {
+        uint64_t b = r.read(8);
+        v |= (b & 0x7F) << shift;
+        if (!(b & 0x80)) return v;
+    }
+    throw std::runtime_error("Prometheus chunk: varint overflow");
+}
+
+static int64_t prom_read_varint(BitReader &r) {
+    uint64_t zigzag = prom_read_uvarint(r);
+    return static_cast<int64_t>(zigzag >> 1) ^ -static_cast<int64_t>(zigzag & 1);
+}
+
+// Prometheus' bitRange: the bucket admits -(2^(n-1) - 1) .. 2^(n-1).
+static inline bool prom_bit_range(int64_t x, int nbits) {
+    int64_t half = int64_t(1) << (nbits - 1);
+    return -(half - 1) <= x && x <= half;
+}
+
+static void prom_write_xor(BitWriter &w, uint64_t delta, uint8_t &leading, uint8_t &trailing) {
+    if (delta == 0) {
+        w.write(0, 1);
+        return;
+    }
+    w.write(1, 1);
+
+    uint8_t new_leading = static_cast<uint8_t>(count_leading_zeros_64(delta));
+    uint8_t new_trailing = static_cast<uint8_t>(count_trailing_zeros_64(delta));
+    if (new_leading >= 32) new_leading = 31;
+
+    if (leading != 0xFF && new_leading >= leading && new_trailing >= trailing) {
+        w.write(0, 1);
+        w.write(delta >> trailing, 64 - leading - trailing);
+        return;
+    }
+
+    leading = new_leading;
+    trailing = new_trailing;
+    int sigbits = 64 - leading - trailing;
+    w.write(1, 1);
+    w.write(leading, 5);
+    w.write(static_cast<uint64_t>(sigbits) & 0x3F, 6);
+    w.write(delta >> trailing, sigbits);
+}
+
+// Encode `n` samples (n <= PROM_MAX_SAMPLES) as one XOR chunk.
+static std::vector<uint8_t> encode_prometheus_chunk(const int64_t *ts, const double *vals,
+                                                    size_t n)
+{
+    BitWriter w;
+    w.write(n, 16);
+
+    int64_t prev_ts = 0;
+    uint64_t prev_delta = 0;
+    uint64_t prev_bits = 0;
+    uint8_t leading = 0xFF, trailing = 0;
+
+    for (size_t i = 0; i < n; i++) {
+        uint64_t bits = prom_value_bits(vals[i]);
+        if (i == 0) {
+            prom_write_varint(w, ts[0]);
+            w.write(bits, 64);
+        } else {
+            uint64_t delta = static_cast<uint64_t>(ts[i]) - static_cast<uint64_t>(prev_ts);
+            if (i == 1) {
+                prom_write_uvarint(w, delta);
+            } else {
+                int64_t dod = static_cast<int64_t>(delta - prev_delta);
+                if (dod == 0) {
+                    w.write(0, 1);
+                } else if (prom_bit_range(dod, 14)) {
+                    w.write(0b10, 2);
+                    w.write_signed(dod, 14);
+                } else if (prom_bit_range(dod, 17)) {
+                    w.write(0b110, 3);
+                    w.write_signed(dod, 17);
+                } else if (prom_bit_range(dod, 20)) {
+                    w.write(0b1110, 4);
+                    w.write_signed(dod, 20);
+                } else {
+                    w.write(0b1111, 4);
+                    w.write(static_cast<uint64_t>(dod), 64);
+                }
+            }
+            prom_write_xor(w, bits ^ prev_bits, leading, trailing);
+            prev_delta = delta;
+        }
+        prev_ts = ts[i];
+        prev_bits = bits;
+    }
+
+    return w.to_bytes_padded();
+}
+
+// Decode one XOR chunk, appending its samples to the columns.
+static void decode_prometheus_chunk(const uint8_t *data, size_t len,
+                                    std::vector<int64_t> &ts, std::vector<double> &vals)
+{
+    if (len < 2) {
+        throw std::invalid_argument("Prometheus chunk too short");
+    }
+    size_t count = (static_cast<size_t>(data[0]) << 8) | data[1];
+    BitReader r(data + 2, (len - 2) * 8);
+
+    ts.reserve(ts.size() + count);
+    vals.reserve(vals.size() + count);
+
+    int64_t t = 0;
+    uint64_t delta = 0;
+    uint64_t bits = 0;
+    uint8_t leading = 0, trailing = 0;
+
+    for (size_t i = 0; i < count; i++) {
+        if (i == 0) {
+            t = prom_read_varint(r);
+            bits = r.read(64);
+        } else {
+            if (i == 1) {
+                delta = prom_read_uvarint(r);
+            } else {
+                int sz = 0;
+                if (r.read_bit()) {
+                    sz = 14;
+                    if (r.read_bit()) {
+                        sz = 17;
+                        if (r.read_bit()) {
+                            sz = r.read_bit() ? 64 : 20;
+                        }
+                    }
+                }
+                int64_t dod = 0;
+                if (sz == 64) {
+                    dod = static_cast<int64_t>(r.read(64));
+                } else if (sz > 0) {
+                    uint64_t raw = r.read(sz);
+                    // Prometheus treats 2^(sz-1) itself as positive
+                    if (raw > (uint64_t(1) << (sz - 1))) raw -= uint64_t(1) << sz;
+                    dod = static_cast<int64_t>(raw);
+                }
+                delta += static_cast<uint64_t>(dod);
+            }
+            t = static_cast<int64_t>(static_cast<uint64_t>(t) + delta);
+
+            if (r.read_bit()) {
+                int mbits;
+                if (r.read_bit()) {
+                    leading = static_cast<uint8_t>(r.read(5));
+                    mbits = static_cast<int>(r.read(6));
+                    if (mbits == 0) mbits = 64;
+                    if (leading + mbits > 64) {
+                        throw std::runtime_error("Prometheus chunk: invalid XOR window");
+                    }
+                    trailing = static_cast<uint8_t>(64 - leading - mbits);
+                } else {
+                    mbits = 64 - leading - trailing;
+                }
+                bits ^= r.read(mbits) << trailing;
+            }
+        }
+        ts.push_back(t);
+        vals.push_back(prom_bits_value(bits));
+    }
+}
+
+static auto atom_samples_per_chunk = fine::Atom("samples_per_chunk");
+
+// Re-encode a chunk as Prometheus XOR chunks of at most `samples_per_chunk`
+// samples each (default 120, Prometheus' own target).
+static fine::Ok<std::vector<ErlNifBinary>>
+nif_gorilla_to_prometheus(ErlNifEnv *env, ErlNifBinary data, fine::Term opts_term)
+{
+    size_t per_chunk = 120;
+    ERL_NIF_TERM opt_val;
+    ErlNifSInt64 n;
+    if (enif_get_map_value(env, opts_term, fine::encode(env, atom_samples_per_chunk), &opt_val) &&
+        enif_get_int64(env, opt_val, &n)) {
+        per_chunk = static_cast<size_t>(std::clamp<ErlNifSInt64>(n, 1, PROM_MAX_SAMPLES));
+    }
 
-static std::vector<int64_t> decode_timestamps(BitReader &reader, uint32_t count) {
+    std::vector<ErlNifBinary> result;
+    if (data.size == 0) return fine::Ok(result);
+
+    ChunkHeader hdr = parse_chunk_header(data.data, data.size);
+    std::vector<int64_t> timestamps(hdr.count);
+    std::vector<double> values(hdr.count);
+    decode_chunk_into(data.data, hdr, timestamps.data(), values.data());
+
+    for (size_t start = 0; start < hdr.count; start += per_chunk) {
+        size_t len = std::min<size_t>(per_chunk, hdr.count - start);
+        auto chunk = encode_prometheus_chunk(timestamps.data() + start, values.data() + start, len);
+        result.push_back(chunk_to_binary(chunk));
+    }
+    return fine::Ok(result);
+}
+FINE_NIF(nif_gorilla_to_prometheus, ERL_NIF_DIRTY_JOB_CPU_BOUND);
+
+// Merge a list of consecutive Prometheus XOR chunks into one chunk.
+static fine::Ok<ErlNifBinary>
+nif_gorilla_from_prometheus(ErlNifEnv *env, fine::Term chunks_term, fine::Term opts_term)
+{
     std::vector<int64_t> timestamps;
-    timestamps.reserve(count);
+    std::vector<double> values;
 
-    if (count == 0) return timestamps;
+    ERL_NIF_TERM head, tail;
+    ERL_NIF_TERM list = chunks_term;
+    while (enif_get_list_cell(env, list, &head, &tail)) {
+        ErlNifBinary chunk;
+        if (!enif_inspect_binary(env, head, &chunk)) {
+            throw std::invalid_argument("expected a list of binaries");
+        }
+        decode_prometheus_chunk(chunk.data, chunk.size, timestamps, values);
+        list = tail;
+    }
 
-    int64_t first_ts = static_cast<int64_t>(reader.read(64));
-    timestamps.push_back(first_ts);
+    EncodeOptions opts = parse_encode_options(env, opts_term);
+    fit_timestamp_codec(opts, timestamps.data(), timestamps.size());
+    auto chunk = encode_chunk(timestamps.data(), timestamps.size(), std::move(values), opts);
+    return fine::Ok(chunk_to_binary(chunk));
+}
+FINE_NIF(nif_gorilla_from_prometheus, ERL_NIF_DIRTY_JOB_CPU_BOUND);
+
+// ---------------------------------------------------------------------------
+// Text ingest — InfluxDB line protocol and CSV
+// ---------------------------------------------------------------------------
+//
+// Parses a raw text binary straight into per-series columns and encodes one
+// chunk per series. Series keys and field names are string_views into the
+// input and come back as sub-binaries, so nothing but the columns is copied.
+// Newlines are found with memchr and delimiters with a 16-byte SIMD scan
+// (SSE2 on x86-64, NEON on ARM), both baseline on the supported targets.
+
+// First byte in [p, end) equal to a, b or c; end if there is none.
+static const char *scan_any(const char *p, const char *end, char a, char b, char c) {
+#if defined(__SSE2__)
+    const __m128i va = _mm_set1_epi8(a);
+    const __m128i vb = _mm_set1_epi8(b);
+    const __m128i vc = _mm_set1_epi8(c);
+    while (end - p >= 16) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+        __m128i hit = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, va),
+                                                _mm_cmpeq_epi8(chunk, vb)),
+                                   _mm_cmpeq_epi8(chunk, vc));
+        int mask = _mm_movemask_epi8(hit);
+        if (mask) return p + __builtin_ctz(static_cast<unsigned>(mask));
+        p += 16;
+    }
+#elif defined(__ARM_NEON)
+    const uint8x16_t va = vdupq_n_u8(static_cast<uint8_t>(a));
+    const uint8x16_t vb = vdupq_n_u8(static_cast<uint8_t>(b));
+    const uint8x16_t vc = vdupq_n_u8(static_cast<uint8_t>(c));
+    while (end - p >= 16) {
+        uint8x16_t chunk = vld1q_u8(reinterpret_cast<const uint8_t *>(p));
+        uint8x16_t hit = vorrq_u8(vorrq_u8(vceqq_u8(chunk, va), vceqq_u8(chunk, vb)),
+                                  vceqq_u8(chunk, vc));
+        // Narrow each 0x00/0xFF byte to a nibble: 4 mask bits per input byte
+        uint64_t mask = vget_lane_u64(
+            vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(hit), 4)), 0);
+        if (mask) return p + (__builtin_ctzll(mask) >> 2);
+        p += 16;
+    }
+#endif
+    for (; p < end; p++) {
+        if (*p == a || *p == b || *p == c) return p;
+    }
+    return end;
+}
 
-    if (count == 1) return timestamps;
+static const char *next_line_end(const char *p, const char *end) {
+    const void *nl = memchr(p, '\n', static_cast<size_t>(end - p));
+    return nl ? static_cast<const char *>(nl) : end;
+}
 
-    int64_t first_delta = decode_first_delta(reader);
-    int64_t second_ts = first_ts + first_delta;
-    timestamps.push_back(second_ts);
+[[noreturn]] static void ingest_error(const char *format, size_t line, const char *what) {
+    throw std::invalid_argument(std::string(format) + " line " + std::to_string(line) +
+                                ": " + what);
+}
 
-    int64_t prev_delta = first_delta;
-    for (uint32_t i = 2; i < count; i++) {
-        int64_t dod = decode_delta_of_delta(reader);
-        int64_t current_delta = prev_delta + dod;
-        int64_t ts = timestamps.back() + current_delta;
-        timestamps.push_back(ts);
-        prev_delta = current_delta;
+static bool parse_int64_token(std::string_view tok, int64_t &out) {
+    if (tok.empty()) return false;
+    size_t i = 0;
+    bool neg = false;
+    if (tok[0] == '-' || tok[0] == '+') {
+        neg = tok[0] == '-';
+        i = 1;
+    }
+    if (i == tok.size()) return false;
+    uint64_t v = 0;
+    for (; i < tok.size(); i++) {
+        unsigned d = static_cast<unsigned char>(tok[i]) - '0';
+        if (d > 9) return false;
+        if (v > (UINT64_MAX - d) / 10) return false;
+        v = v * 10 + d;
     }
+    if (neg) {
+        if (v > static_cast<uint64_t>(INT64_MAX) + 1) return false;
+        out = static_cast<int64_t>(0 - v);
+    } else {
+        if (v > static_cast<uint64_t>(INT64_MAX)) return false;
+        out = static_cast<int64_t>(v);
+    }
+    return true;
+}
 
-    return timestamps;
+// strtod needs a terminated string; number tokens are short, so copy to
+// the stack rather than touching the input.
+static bool parse_double_token(std::string_view tok, double &out) {
+    char buf[64];
+    if (tok.empty() || tok.size() >= sizeof(buf)) return false;
+    memcpy(buf, tok.data(), tok.size());
+    buf[tok.size()] = '\0';
+    char *endp;
+    out = std::strtod(buf, &endp);
+    return endp == buf + tok.size();
 }
 
-static std::vector<double> decode_values(BitReader &reader, uint32_t count) {
+// One output series: columns plus the input slices that name it.
+struct IngestSeries {
+    std::string_view series;
+    std::string_view field;
+    int64_t column = -1;  // CSV value column when there is no header
+    std::vector<int64_t> timestamps;
     std::vector<double> values;
-    values.reserve(count);
+};
+
+struct IngestKey {
+    std::string_view series;
+    std::string_view field;
+    int64_t column;
+
+    bool operator==(const IngestKey &o) const {
+        return series == o.series && field == o.field && column == o.column;
+    }
+};
 
-    if (count == 0) return values;
+struct IngestKeyHash {
+    size_t operator()(const IngestKey &k) const {
+        size_t h = std::hash<std::string_view>()(k.series);
+        h ^= std::hash<std::string_view>()(k.field) + 0x9E3779B97F4A7C15ULL + (h << 6) + (h >> 2);
+        return h ^ (static_cast<size_t>(k.column) * 0x9E3779B97F4A7C15ULL);
+    }
+};
 
-    uint64_t first_bits = reader.read(64);
-    values.push_back(bits_to_float(first_bits));
+// Series in first-seen order, looked up by key.
+class IngestSeriesTable {
+public:
+    IngestSeries &get(std::string_view series, std::string_view field, int64_t column) {
+        IngestKey key{series, field, column};
+        auto it = index_.find(key);
+        if (it != index_.end()) return series_[it->second];
+        index_.emplace(key, series_.size());
+        series_.push_back(IngestSeries{series, field, column, {}, {}});
+        return series_.back();
+    }
 
-    if (count == 1) return values;
+    std::vector<IngestSeries> &all() { return series_; }
 
-    uint64_t prev_bits = first_bits;
-    int prev_leading = 0;
-    int prev_trailing = 0;
+private:
+    std::unordered_map<IngestKey, size_t, IngestKeyHash> index_;
+    std::vector<IngestSeries> series_;
+};
 
-    for (uint32_t i = 1; i < count; i++) {
-        uint64_t bit = reader.read_bit();
-        if (bit == 0) {
-            // Identical to previous
-            values.push_back(bits_to_float(prev_bits));
+// Parse a numeric line-protocol field value: floats, integers (1i),
+// unsigned integers (1u) and booleans, all as doubles.
+static bool parse_lp_value(std::string_view tok, double &out) {
+    if (tok.empty()) return false;
+
+    char last = tok.back();
+    std::string_view digits = tok.substr(0, tok.size() - 1);
+    if (last == 'i') {
+        int64_t iv;
+        if (!parse_int64_token(digits, iv)) return false;
+        out = static_cast<double>(iv);
+        return true;
+    }
+    if (last == 'u') {
+        int64_t iv;
+        if (digits.empty() || digits[0] == '-' || !parse_int64_token(digits, iv)) return false;
+        out = static_cast<double>(iv);
+        return true;
+    }
+    if (tok == "t" || tok == "T" || tok == "true" || tok == "True" || tok == "TRUE") {
+        out = 1.0;
+        return true;
+    }
+    if (tok == "f" || tok == "F" || tok == "false" || tok == "False" || tok == "FALSE") {
+        out = 0.0;
+        return true;
+    }
+    return parse_double_token(tok, out);
+}
+
+// Line protocol: measurement[,tag=v...] field=v[,field=v...] [timestamp]
+// The series key is the raw measurement+tag set, so tags must be written in
+// a consistent order (as InfluxDB clients do). A timestamp is required.
+static void parse_line_protocol(const char *begin, const char *end, IngestSeriesTable &table) {
+    struct Field {
+        std::string_view name;
+        double value;
+    };
+    std::vector<Field> fields;
+
+    size_t line_no = 0;
+    for (const char *ls = begin; ls < end;) {
+        const char *le = next_line_end(ls, end);
+        const char *next = le < end ? le + 1 : end;
+        line_no++;
+        if (le > ls && le[-1] == '\r') le--;
+
+        const char *p = ls;
+        while (p < le && (*p == ' ' || *p == '\t')) p++;
+        if (p == le || *p == '#') {
+            ls = next;
             continue;
         }
 
-        bit = reader.read_bit();
-        if (bit == 0) {
-            // Reuse previous window
-            int meaningful_length = 64 - prev_leading - prev_trailing;
-            uint64_t meaningful_value = reader.read(meaningful_length);
-            uint64_t xor_val = meaningful_value << prev_trailing;
-            uint64_t new_bits = prev_bits ^ xor_val;
-            values.push_back(bits_to_float(new_bits));
-            prev_bits = new_bits;
-        } else {
-            // New window
-            int leading = static_cast<int>(reader.read(5));
-            int meaningful_length = static_cast<int>(reader.read(6)) + 1;
-            int trailing = 64 - leading - meaningful_length;
+        // Series key runs to the first unescaped space
+        const char *key_start = p;
+        for (;;) {
+            p = scan_any(p, le, ' ', '\\', '\\');
+            if (p < le && *p == '\\') {
+                p += 2;
+                continue;
+            }
+            break;
+        }
+        if (p >= le || p == key_start) ingest_error("line protocol", line_no, "missing fields");
+        std::string_view series(key_start, static_cast<size_t>(p - key_start));
+        while (p < le && *p == ' ') p++;
+
+        fields.clear();
+        for (;;) {
+            const char *name_start = p;
+            for (;;) {
+                p = scan_any(p, le, '=', '\\', '\\');
+                if (p < le && *p == '\\') {
+                    p += 2;
+                    continue;
+                }
+                break;
+            }
+            if (p >= le || p == name_start) ingest_error("line protocol", line_no, "malformed field");
+            std::string_view name(name_start, static_cast<size_t>(p - name_start));
+            p++;  // '='
+
+            if (p < le && *p == '"') {
+                // String field: skip to the closing unescaped quote
+                p++;
+                for (;;) {
+                    p = scan_any(p, le, '"', '\\', '\\');
+                    if (p < le && *p == '\\') {
+                        p += 2;
+                        continue;
+                    }
+                    break;
+                }
+                if (p >= le) ingest_error("line protocol", line_no, "unterminated string");
+                p++;
+            } else {
+                const char *value_start = p;
+                p = scan_any(p, le, ',', ' ', ' ');
+                std::string_view tok(value_start, static_cast<size_t>(p - value_start));
+                double value;
+                if (!parse_lp_value(tok, value)) {
+                    ingest_error("line protocol", line_no, "invalid field value");
+                }
+                fields.push_back({name, value});
+            }
 
-            uint64_t meaningful_value = reader.read(meaningful_length);
-            uint64_t xor_val = meaningful_value << trailing;
-            uint64_t new_bits = prev_bits ^ xor_val;
-            values.push_back(bits_to_float(new_bits));
-            prev_bits = new_bits;
-            prev_leading = leading;
-            prev_trailing = trailing;
+            if (p < le && *p == ',') {
+                p++;
+                continue;
+            }
+            break;
+        }
+
+        while (p < le && *p == ' ') p++;
+        const char *ts_end = le;
+        while (ts_end > p && (ts_end[-1] == ' ' || ts_end[-1] == '\t')) ts_end--;
+        int64_t ts;
+        if (!parse_int64_token(std::string_view(p, static_cast<size_t>(ts_end - p)), ts)) {
+            ingest_error("line protocol", line_no, "missing or invalid timestamp");
+        }
+
+        for (const auto &f : fields) {
+            IngestSeries &s = table.get(series, f.name, -1);
+            s.timestamps.push_back(ts);
+            s.values.push_back(f.value);
+        }
+        ls = next;
+    }
+}
+
+// A CSV column given by header name (binary) or zero-based index (integer).
+struct CsvColumnRef {
+    bool present = false;
+    std::string_view name;
+    int64_t index = -1;
+};
+
+struct CsvOptions {
+    char delimiter = ',';
+    bool header = true;
+    CsvColumnRef timestamp_column;
+    CsvColumnRef series_column;
+    std::vector<CsvColumnRef> value_columns;
+};
+
+// Split one line into cells. Quoted cells may contain the delimiter ("" is an
+// escaped quote and is left doubled in the returned slice); they may not span
+// lines.
+static void split_csv_line(const char *p, const char *le, char delim, size_t line_no,
+                           std::vector<std::string_view> &cells)
+{
+    cells.clear();
+    for (;;) {
+        if (p < le && *p == '"') {
+            const char *start = ++p;
+            for (;;) {
+                p = scan_any(p, le, '"', '"', '"');
+                if (p + 1 < le && p[1] == '"') {
+                    p += 2;
+                    continue;
+                }
+                break;
+            }
+            if (p >= le) ingest_error("CSV", line_no, "unterminated quoted field");
+            cells.emplace_back(start, static_cast<size_t>(p - start));
+            p++;
+            if (p < le && *p != delim) ingest_error("CSV", line_no, "text after quoted field");
+        } else {
+            const char *start = p;
+            p = scan_any(p, le, delim, delim, delim);
+            cells.emplace_back(start, static_cast<size_t>(p - start));
         }
+        if (p >= le) break;
+        p++;  // delimiter
     }
+}
+
+static int64_t resolve_csv_column(const CsvColumnRef &ref,
+                                  const std::vector<std::string_view> &header)
+{
+    if (ref.index >= 0) return ref.index;
+    for (size_t i = 0; i < header.size(); i++) {
+        if (header[i] == ref.name) return static_cast<int64_t>(i);
+    }
+    throw std::invalid_argument("CSV column not found: " + std::string(ref.name));
+}
+
+static std::string_view trim_cell(std::string_view cell) {
+    while (!cell.empty() && (cell.front() == ' ' || cell.front() == '\t')) cell.remove_prefix(1);
+    while (!cell.empty() && (cell.back() == ' ' || cell.back() == '\t')) cell.remove_suffix(1);
+    return cell;
+}
+
+// CSV: one series per (series column value, value column). Empty or
+// non-numeric value cells are skipped; timestamps must be integers.
+static void parse_csv(const char *begin, const char *end, const CsvOptions &opts,
+                      IngestSeriesTable &table)
+{
+    std::vector<std::string_view> header, cells;
+    bool have_header = !opts.header;
+    int64_t ts_col = -1, series_col = -1;
+    std::vector<int64_t> value_cols;
+    std::vector<std::string_view> value_names;
+    bool resolved = false;
+
+    size_t line_no = 0;
+    for (const char *ls = begin; ls < end;) {
+        const char *le = next_line_end(ls, end);
+        const char *next = le < end ? le + 1 : end;
+        line_no++;
+        if (le > ls && le[-1] == '\r') le--;
+        if (le == ls) {
+            ls = next;
+            continue;
+        }
+
+        split_csv_line(ls, le, opts.delimiter, line_no, cells);
+        ls = next;
+
+        if (!have_header) {
+            header = cells;
+            have_header = true;
+            continue;
+        }
+
+        if (!resolved) {
+            ts_col = opts.timestamp_column.present
+                         ? resolve_csv_column(opts.timestamp_column, header) : 0;
+            if (opts.series_column.present) {
+                series_col = resolve_csv_column(opts.series_column, header);
+            }
+            if (!opts.value_columns.empty()) {
+                for (const auto &ref : opts.value_columns) {
+                    value_cols.push_back(resolve_csv_column(ref, header));
+                }
+            } else {
+                size_t width = opts.header ? header.size() : cells.size();
+                for (size_t i = 0; i < width; i++) {
+                    int64_t col = static_cast<int64_t>(i);
+                    if (col != ts_col && col != series_col) value_cols.push_back(col);
+                }
+            }
+            for (int64_t col : value_cols) {
+                bool named = opts.header && col < static_cast<int64_t>(header.size());
+                value_names.push_back(named ? header[col] : std::string_view());
+            }
+            resolved = true;
+        }
 
-    return values;
+        int64_t n_cells = static_cast<int64_t>(cells.size());
+        if (ts_col >= n_cells || series_col >= n_cells) {
+            ingest_error("CSV", line_no, "missing timestamp or series column");
+        }
+        int64_t ts;
+        if (!parse_int64_token(trim_cell(cells[ts_col]), ts)) {
+            ingest_error("CSV", line_no, "invalid timestamp");
+        }
+        std::string_view series = series_col >= 0 ? cells[series_col] : std::string_view();
+
+        for (size_t i = 0; i < value_cols.size(); i++) {
+            int64_t col = value_cols[i];
+            if (col >= n_cells) continue;
+            double value;
+            if (!parse_double_token(trim_cell(cells[col]), value)) continue;
+            IngestSeries &s = table.get(series, value_names[i],
+                                        value_names[i].empty() ? col : -1);
+            s.timestamps.push_back(ts);
+            s.values.push_back(value);
+        }
+    }
 }
 
 // ---------------------------------------------------------------------------
-// Decode NIF
+// Ingest NIFs
 // ---------------------------------------------------------------------------
 
-using DecodedPoint = std::tuple<int64_t, double>;
+static auto atom_delimiter = fine::Atom("delimiter");
+static auto atom_header = fine::Atom("header");
+static auto atom_series_column = fine::Atom("series_column");
+static auto atom_value_columns = fine::Atom("value_columns");
 
-static fine::Ok<std::vector<DecodedPoint>>
-nif_gorilla_decode(ErlNifEnv *env, ErlNifBinary data)
+using IngestResult = std::tuple<fine::Term, fine::Term, ErlNifBinary>;
+
+static std::vector<IngestResult> encode_ingested(ErlNifEnv *env, ERL_NIF_TERM input,
+                                                 const ErlNifBinary &bin,
+                                                 IngestSeriesTable &table,
+                                                 const EncodeOptions &opts)
 {
-    if (data.size == 0) {
-        return fine::Ok(std::vector<DecodedPoint>{});
+    const char *base = reinterpret_cast<const char *>(bin.data);
+    auto sub = [&](std::string_view v) {
+        size_t offset = v.data() ? static_cast<size_t>(v.data() - base) : 0;
+        return enif_make_sub_binary(env, input, offset, v.size());
+    };
+
+    std::vector<IngestResult> result;
+    result.reserve(table.all().size());
+    for (auto &s : table.all()) {
+        EncodeOptions series_opts = opts;
+        fit_timestamp_codec(series_opts, s.timestamps.data(), s.timestamps.size());
+        auto chunk = encode_chunk(s.timestamps.data(), s.timestamps.size(),
+                                  std::move(s.values), series_opts);
+        ERL_NIF_TERM series = sub(s.series);
+        ERL_NIF_TERM field = s.column >= 0 ? enif_make_int64(env, s.column) : sub(s.field);
+        result.emplace_back(series, field, chunk_to_binary(chunk));
     }
+    return result;
+}
 
-    const uint8_t *ptr = data.data;
-    size_t len = data.size;
+// Parse InfluxDB line protocol into one chunk per {series key, field}.
+static fine::Ok<std::vector<IngestResult>>
+nif_gorilla_ingest_line_protocol(ErlNifEnv *env, fine::Term input, fine::Term opts_term)
+{
+    ErlNifBinary bin;
+    if (!enif_inspect_binary(env, input, &bin)) {
+        throw std::invalid_argument("expected a binary");
+    }
+    EncodeOptions opts = parse_encode_options(env, opts_term);
 
-    // Parse outer header — minimum 80 bytes
-    if (len < 80) {
-        throw std::runtime_error("data too small for header");
+    IngestSeriesTable table;
+    const char *begin = reinterpret_cast<const char *>(bin.data);
+    parse_line_protocol(begin, begin + bin.size, table);
+    return fine::Ok(encode_ingested(env, input, bin, table, opts));
+}
+FINE_NIF(nif_gorilla_ingest_line_protocol, ERL_NIF_DIRTY_JOB_CPU_BOUND);
+
+static CsvColumnRef csv_column_option(ErlNifEnv *env, ERL_NIF_TERM term) {
+    CsvColumnRef ref;
+    ErlNifBinary name;
+    ErlNifSInt64 index;
+    if (enif_inspect_binary(env, term, &name)) {
+        ref.name = std::string_view(reinterpret_cast<const char *>(name.data), name.size);
+    } else if (enif_get_int64(env, term, &index) && index >= 0) {
+        ref.index = index;
+    } else {
+        throw std::invalid_argument("CSV columns must be names or non-negative indexes");
     }
+    ref.present = true;
+    return ref;
+}
 
-    // Read header fields via BitReader
-    BitReader hdr(ptr, len * 8);
+// Parse CSV into one chunk per {series column value, value column}.
+static fine::Ok<std::vector<IngestResult>>
+nif_gorilla_ingest_csv(ErlNifEnv *env, fine::Term input, fine::Term opts_term)
+{
+    ErlNifBinary bin;
+    if (!enif_inspect_binary(env, input, &bin)) {
+        throw std::invalid_argument("expected a binary");
+    }
+    EncodeOptions opts = parse_encode_options(env, opts_term);
 
-    uint64_t magic = hdr.read(64);
-    if (magic != GORILLA_MAGIC) {
-        throw std::runtime_error("invalid magic number");
+    CsvOptions csv;
+    ERL_NIF_TERM opt_val;
+    ErlNifBinary delim;
+    if (enif_get_map_value(env, opts_term, fine::encode(env, atom_delimiter), &opt_val) &&
+        enif_inspect_binary(env, opt_val, &delim) && delim.size == 1) {
+        csv.delimiter = static_cast<char>(delim.data[0]);
+    }
+    if (enif_get_map_value(env, opts_term, fine::encode(env, atom_header), &opt_val)) {
+        csv.header = fine::decode<bool>(env, opt_val);
+    }
+    if (enif_get_map_value(env, opts_term, fine::encode(env, atom_timestamp_column), &opt_val)) {
+        csv.timestamp_column = csv_column_option(env, opt_val);
+    }
+    if (enif_get_map_value(env, opts_term, fine::encode(env, atom_series_column), &opt_val)) {
+        csv.series_column = csv_column_option(env, opt_val);
+    }
+    if (enif_get_map_value(env, opts_term, fine::encode(env, atom_value_columns), &opt_val)) {
+        ERL_NIF_TERM head, tail;
+        while (enif_get_list_cell(env, opt_val, &head, &tail)) {
+            csv.value_columns.push_back(csv_column_option(env, head));
+            opt_val = tail;
+        }
+    }
+    if (csv.delimiter == '"' || csv.delimiter == '\n' || csv.delimiter == '\r') {
+        throw std::invalid_argument("invalid CSV delimiter");
     }
 
-    uint64_t version = hdr.read(16);
-    if (version > GORILLA_VERSION) {
-        throw std::runtime_error("unsupported version");
+    IngestSeriesTable table;
+    const char *begin = reinterpret_cast<const char *>(bin.data);
+    parse_csv(begin, begin + bin.size, csv, table);
+    return fine::Ok(encode_ingested(env, input, bin, table, opts));
+}
+FINE_NIF(nif_gorilla_ingest_csv, ERL_NIF_DIRTY_JOB_CPU_BOUND);
+
+// ---------------------------------------------------------------------------
+// Snappy — raw block decompression
+// ---------------------------------------------------------------------------
+//
+// Block format: uvarint uncompressed length, then elements tagged by the low
+// two bits of their first byte: 00 literal, 01/10/11 back-reference copies
+// with 1-, 2- and 4-byte offsets. Prometheus remote_write bodies use this
+// block format (not the framed stream format).
+
+static uint64_t read_uvarint(const uint8_t *&p, const uint8_t *end, const char *what) {
+    uint64_t v = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        if (p >= end) break;
+        uint8_t b = *p++;
+        v |= static_cast<uint64_t>(b & 0x7F) << shift;
+        if (!(b & 0x80)) return v;
     }
+    throw std::runtime_error(std::string(what) + ": truncated or overlong varint");
+}
 
-    uint64_t header_size = hdr.read(16);
-    if (header_size != 80 && header_size != 84) {
-        throw std::runtime_error("invalid header size");
+static void snappy_decompress(const uint8_t *src, size_t len, size_t max_size,
+                              std::vector<uint8_t> &out)
+{
+    const uint8_t *p = src;
+    const uint8_t *end = src + len;
+    uint64_t expected = read_uvarint(p, end, "snappy");
+    if (expected > max_size) {
+        throw std::runtime_error("snappy: uncompressed size exceeds limit");
     }
 
-    if (len < header_size) {
-        throw std::runtime_error("data smaller than header");
+    out.resize(static_cast<size_t>(expected));
+    uint8_t *dst = out.data();
+    size_t pos = 0;
+
+    while (p < end) {
+        uint8_t tag = *p++;
+        size_t length, offset;
+
+        if ((tag & 3) == 0) {
+            length = tag >> 2;
+            if (length >= 60) {
+                size_t nbytes = length - 59;
+                if (static_cast<size_t>(end - p) < nbytes) {
+                    throw std::runtime_error("snappy: truncated literal length");
+                }
+                length = 0;
+                for (size_t i = 0; i < nbytes; i++) length |= static_cast<size_t>(p[i]) << (8 * i);
+                p += nbytes;
+            }
+            length += 1;
+            if (static_cast<size_t>(end - p) < length || expected - pos < length) {
+                throw std::runtime_error("snappy: literal overruns buffer");
+            }
+            memcpy(dst + pos, p, length);
+            p += length;
+            pos += length;
+            continue;
+        }
+
+        if ((tag & 3) == 1) {
+            if (p >= end) throw std::runtime_error("snappy: truncated copy");
+            length = 4 + ((tag >> 2) & 7);
+            offset = (static_cast<size_t>(tag >> 5) << 8) | *p++;
+        } else if ((tag & 3) == 2) {
+            if (end - p < 2) throw std::runtime_error("snappy: truncated copy");
+            length = 1 + (tag >> 2);
+            offset = static_cast<size_t>(p[0]) | (static_cast<size_t>(p[1]) << 8);
+            p += 2;
+        } else {
+            if (end - p < 4) throw std::runtime_error("snappy: truncated copy");
+            length = 1 + (tag >> 2);
+            offset = static_cast<size_t>(p[0]) | (static_cast<size_t>(p[1]) << 8) |
+                     (static_cast<size_t>(p[2]) << 16) | (static_cast<size_t>(p[3]) << 24);
+            p += 4;
+        }
+
+        if (offset == 0 || offset > pos || expected - pos < length) {
+            throw std::runtime_error("snappy: invalid copy");
+        }
+        // Copies may overlap their own output (run-length style)
+        if (offset >= length) {
+            memcpy(dst + pos, dst + pos - offset, length);
+        } else {
+            for (size_t i = 0; i < length; i++) dst[pos + i] = dst[pos + i - offset];
+        }
+        pos += length;
+    }
+
+    if (pos != expected) {
+        throw std::runtime_error("snappy: output shorter than declared length");
     }
+}
 
-    uint32_t count = static_cast<uint32_t>(hdr.read(32));
-    uint32_t compressed_size = static_cast<uint32_t>(hdr.read(32));
-    /*uint32_t original_size =*/ hdr.read(32);
-    uint32_t expected_crc = static_cast<uint32_t>(hdr.read(32));
-    /*int64_t first_timestamp =*/ hdr.read(64);
-    /*int32_t first_delta =*/ hdr.read_signed(32);
-    /*uint64_t first_value_bits =*/ hdr.read(64);
-    /*uint32_t ts_bit_len =*/ hdr.read(32);
-    /*uint32_t val_bit_len =*/ hdr.read(32);
-    /*uint32_t total_bits =*/ hdr.read(32);
-    /*double compression_ratio_hdr =*/ hdr.read(64);  // float-64 bits
-    /*int64_t creation_time =*/ hdr.read(64);
-    uint32_t flags = static_cast<uint32_t>(hdr.read(32));
+// ---------------------------------------------------------------------------
+// Prometheus remote_write — WriteRequest decoding
+// ---------------------------------------------------------------------------
+//
+//   WriteRequest { repeated TimeSeries timeseries = 1; ... }
+//   TimeSeries   { repeated Label labels = 1; repeated Sample samples = 2; ... }
+//   Label        { string name = 1; string value = 2; }
+//   Sample       { double value = 1; int64 timestamp = 2; }
+//
+// Only these fields are read; metadata, exemplars and native histograms are
+// skipped by wire type. Timeseries with the same label set (in any label
+// order) are merged into one series.
 
-    uint32_t scale_decimals = 0;
-    if (header_size == 84) {
-        scale_decimals = static_cast<uint32_t>(hdr.read(32));
+// Minimal protobuf wire-format reader over [p, end).
+class ProtoReader {
+public:
+    ProtoReader(const uint8_t *p, const uint8_t *end) : p_(p), end_(end) {}
+
+    bool next(uint32_t &field, uint32_t &wire_type) {
+        if (p_ >= end_) return false;
+        uint64_t key = read_uvarint(p_, end_, "remote_write");
+        field = static_cast<uint32_t>(key >> 3);
+        wire_type = static_cast<uint32_t>(key & 7);
+        return true;
     }
 
-    // Compressed data follows the header
-    const uint8_t *packed_data = ptr + header_size;
-    size_t packed_size = compressed_size;
+    uint64_t varint() { return read_uvarint(p_, end_, "remote_write"); }
 
-    if (header_size + packed_size > len) {
-        throw std::runtime_error("compressed data extends beyond input");
+    uint64_t fixed64() {
+        need(8);
+        uint64_t v = 0;
+        for (int i = 7; i >= 0; i--) v = (v << 8) | p_[i];
+        p_ += 8;
+        return v;
     }
 
-    // Verify CRC32
-    uint32_t actual_crc = crc32(packed_data, packed_size);
-    if (actual_crc != expected_crc) {
-        // Allow checksum mismatch (Elixir decoder does the same — flags it but continues)
+    ProtoReader message() {
+        uint64_t n = varint();
+        need(n);
+        ProtoReader sub(p_, p_ + n);
+        p_ += n;
+        return sub;
     }
 
-    if (count == 0) {
-        return fine::Ok(std::vector<DecodedPoint>{});
+    std::string_view bytes() {
+        ProtoReader sub = message();
+        return std::string_view(reinterpret_cast<const char *>(sub.p_),
+                                static_cast<size_t>(sub.end_ - sub.p_));
     }
 
-    // Parse inner header (32 bytes) from packed data
-    if (packed_size < 32) {
-        throw std::runtime_error("packed data too small for inner header");
+    void skip(uint32_t wire_type) {
+        switch (wire_type) {
+        case 0: varint(); break;
+        case 1: need(8); p_ += 8; break;
+        case 2: message(); break;
+        case 5: need(4); p_ += 4; break;
+        default: throw std::runtime_error("remote_write: unsupported protobuf wire type");
+        }
     }
 
-    BitReader inner(packed_data, packed_size * 8);
+private:
+    void need(uint64_t n) {
+        if (static_cast<uint64_t>(end_ - p_) < n) {
+            throw std::runtime_error("remote_write: truncated protobuf message");
+        }
+    }
 
-    uint32_t inner_count = static_cast<uint32_t>(inner.read(32));
-    /*int64_t inner_first_ts =*/ inner.read(64);
-    /*uint64_t inner_first_val =*/ inner.read(64);
-    /*int32_t inner_first_delta =*/ inner.read_signed(32);
-    uint32_t ts_bit_len = static_cast<uint32_t>(inner.read(32));
-    /*uint32_t val_bit_len =*/ inner.read(32);
+    const uint8_t *p_;
+    const uint8_t *end_;
+};
 
-    (void)inner_count;
+using RemoteWriteLabel = std::pair<std::string_view, std::string_view>;
 
-    // Read timestamp bitstream
-    // Create a reader positioned right after the inner header
-    // The inner header is 256 bits = 32 bytes
-    size_t data_start_bits = 256;  // inner header bits
-    size_t ts_start = data_start_bits;
-    size_t val_start = ts_start + ts_bit_len;
+struct RemoteWriteSeries {
+    std::vector<RemoteWriteLabel> labels;  // sorted by name
+    std::vector<int64_t> timestamps;
+    std::vector<double> values;
+};
 
-    // Create readers for timestamp and value bitstreams
-    BitReader ts_reader(packed_data, packed_size * 8);
-    // Skip to timestamp data
-    for (size_t i = 0; i < data_start_bits; i++) {
-        ts_reader.read_bit();
+static uint64_t hash_label_set(const std::vector<RemoteWriteLabel> &labels) {
+    // FNV-1a over name\xff value\xff pairs, as the labels are already sorted
+    uint64_t h = 0xCBF29CE484222325ULL;
+    auto mix = [&h](std::string_view s) {
+        for (unsigned char c : s) {
+            h ^= c;
+            h *= 0x100000001B3ULL;
+        }
+        h ^= 0xFF;
+        h *= 0x100000001B3ULL;
+    };
+    for (const auto &l : labels) {
+        mix(l.first);
+        mix(l.second);
     }
+    return h;
+}
 
-    auto timestamps = decode_timestamps(ts_reader, count);
+static std::vector<RemoteWriteSeries> parse_write_request(const uint8_t *data, size_t len) {
+    std::vector<RemoteWriteSeries> series;
+    std::unordered_multimap<uint64_t, size_t> by_hash;
 
-    // Value reader starts after timestamp bits
-    BitReader val_reader(packed_data, packed_size * 8);
-    for (size_t i = 0; i < val_start; i++) {
-        val_reader.read_bit();
-    }
+    std::vector<RemoteWriteLabel> labels;
+    std::vector<std::pair<int64_t, double>> samples;
 
-    // Dispatch value decoding based on algorithm flag
-    std::vector<double> values;
-    if (flags & 0x8) {
-        values = decode_values_chimp128(val_reader, count);
-    } else if (flags & 0x4) {
-        values = decode_values_chimp(val_reader, count);
-    } else {
-        values = decode_values(val_reader, count);
-    }
+    ProtoReader req(data, data + len);
+    uint32_t field, wire;
+    while (req.next(field, wire)) {
+        if (field != 1 || wire != 2) {
+            req.skip(wire);
+            continue;
+        }
+
+        labels.clear();
+        samples.clear();
+        ProtoReader ts = req.message();
+        while (ts.next(field, wire)) {
+            if (field == 1 && wire == 2) {
+                ProtoReader label = ts.message();
+                std::string_view name, value;
+                while (label.next(field, wire)) {
+                    if (field == 1 && wire == 2) name = label.bytes();
+                    else if (field == 2 && wire == 2) value = label.bytes();
+                    else label.skip(wire);
+                }
+                labels.emplace_back(name, value);
+            } else if (field == 2 && wire == 2) {
+                ProtoReader sample = ts.message();
+                double value = 0.0;
+                int64_t timestamp = 0;
+                while (sample.next(field, wire)) {
+                    if (field == 1 && wire == 1) {
+                        uint64_t bits = sample.fixed64();
+                        memcpy(&value, &bits, sizeof(value));
+                    } else if (field == 2 && wire == 0) {
+                        timestamp = static_cast<int64_t>(sample.varint());
+                    } else {
+                        sample.skip(wire);
+                    }
+                }
+                samples.emplace_back(timestamp, value);
+            } else {
+                ts.skip(wire);
+            }
+        }
+        if (samples.empty()) continue;
 
-    // VM postprocessing
-    bool vm_enabled = (flags & 0x1) != 0;
-    bool is_counter = (flags & 0x2) != 0;
+        std::sort(labels.begin(), labels.end());
+        uint64_t h = hash_label_set(labels);
 
-    if (vm_enabled) {
-        if (scale_decimals > 0) {
-            double scale = std::pow(10.0, static_cast<double>(scale_decimals));
-            for (auto &v : values) {
-                v = v / scale;
+        RemoteWriteSeries *target = nullptr;
+        auto range = by_hash.equal_range(h);
+        for (auto it = range.first; it != range.second; ++it) {
+            if (series[it->second].labels == labels) {
+                target = &series[it->second];
+                break;
             }
         }
-        if (is_counter) {
-            values = delta_decode_counter(values);
+        if (!target) {
+            by_hash.emplace(h, series.size());
+            series.push_back(RemoteWriteSeries{labels, {}, {}});
+            target = &series.back();
+        }
+        for (const auto &s : samples) {
+            target->timestamps.push_back(s.first);
+            target->values.push_back(s.second);
         }
     }
+    return series;
+}
 
-    // Combine into result
-    std::vector<DecodedPoint> result;
-    result.reserve(count);
-    for (uint32_t i = 0; i < count; i++) {
-        result.emplace_back(timestamps[i], values[i]);
+static auto atom_snappy = fine::Atom("snappy");
+static auto atom_max_size = fine::Atom("max_size");
+
+using RemoteWriteResult =
+    std::tuple<std::vector<std::tuple<std::string, std::string>>, ErlNifBinary>;
+
+// Decode a remote_write body (snappy-compressed WriteRequest by default) and
+// encode each distinct label set into one chunk.
+static fine::Ok<std::vector<RemoteWriteResult>>
+nif_gorilla_ingest_remote_write(ErlNifEnv *env, ErlNifBinary body, fine::Term opts_term)
+{
+    EncodeOptions opts = parse_encode_options(env, opts_term);
+
+    bool snappy = true;
+    size_t max_size = size_t(128) << 20;
+    ERL_NIF_TERM opt_val;
+    if (enif_get_map_value(env, opts_term, fine::encode(env, atom_snappy), &opt_val)) {
+        snappy = fine::decode<bool>(env, opt_val);
+    }
+    if (enif_get_map_value(env, opts_term, fine::encode(env, atom_max_size), &opt_val)) {
+        ErlNifSInt64 n;
+        if (enif_get_int64(env, opt_val, &n) && n > 0) max_size = static_cast<size_t>(n);
+    }
+
+    std::vector<uint8_t> decompressed;
+    const uint8_t *data = body.data;
+    size_t len = body.size;
+    if (snappy) {
+        snappy_decompress(body.data, body.size, max_size, decompressed);
+        data = decompressed.data();
+        len = decompressed.size();
     }
 
+    auto series = parse_write_request(data, len);
+
+    std::vector<RemoteWriteResult> result;
+    result.reserve(series.size());
+    for (auto &s : series) {
+        EncodeOptions series_opts = opts;
+        fit_timestamp_codec(series_opts, s.timestamps.data(), s.timestamps.size());
+        auto chunk = encode_chunk(s.timestamps.data(), s.timestamps.size(),
+                                  std::move(s.values), series_opts);
+        std::vector<std::tuple<std::string, std::string>> labels;
+        labels.reserve(s.labels.size());
+        for (const auto &l : s.labels) {
+            labels.emplace_back(std::string(l.first), std::string(l.second));
+        }
+        result.emplace_back(std::move(labels), chunk_to_binary(chunk));
+    }
     return fine::Ok(result);
 }
-FINE_NIF(nif_gorilla_decode, ERL_NIF_DIRTY_JOB_CPU_BOUND);
+FINE_NIF(nif_gorilla_ingest_remote_write, ERL_NIF_DIRTY_JOB_CPU_BOUND);
+
+// ---------------------------------------------------------------------------
+// Build info
+// ---------------------------------------------------------------------------
+
+// Which kernel variant this CPU runs, every variant compiled in, the
+// compiler, and whether this is the profile-guided (`make pgo`) build, so
+// benchmark numbers can be tied to the code that produced them.
+using BuildInfo = std::tuple<std::string, std::vector<std::string>, std::string, bool>;
+
+static fine::Ok<BuildInfo> nif_build_info(ErlNifEnv *env) {
+    std::vector<std::string> variants{isa_name(Isa::baseline)};
+#define GORILLA_ISA_NAME(tag, arch) variants.emplace_back(isa_name(Isa::tag));
+    GORILLA_ISA_VARIANTS(GORILLA_ISA_NAME)
+#undef GORILLA_ISA_NAME
+#if defined(__clang__)
+    std::string compiler = __VERSION__;
+#else
+    std::string compiler = std::string("gcc ") + __VERSION__;
+#endif
+#if defined(GORILLA_PGO)
+    bool pgo = true;
+#else
+    bool pgo = false;
+#endif
+    return fine::Ok(BuildInfo(isa_name(selected_isa()), std::move(variants), compiler, pgo));
+}
+FINE_NIF(nif_build_info, 0);
 
 // ---------------------------------------------------------------------------
 // NIF init
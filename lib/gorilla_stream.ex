@@ -40,6 +40,7 @@ defmodule GorillaStream do
 
   alias GorillaStream.Compression.Gorilla
   alias GorillaStream.Compression.Container
+  alias GorillaStream.Compression.Gorilla.NIF
 
   @doc """
   Compresses time series data using the Gorilla algorithm.
@@ -55,6 +56,11 @@ defmodule GorillaStream do
       - `:victoria_metrics` (boolean, default: true)
       - `:is_counter` (boolean, default: false)
       - `:scale_decimals` (:auto | integer, default: :auto)
+      - `:value_type` (`:f64` | `:f32`, default: :f64) - store single-precision values
+      - `:max_relative_error` / `:mantissa_bits` - opt-in lossy mantissa rounding
+      - `:checksum` (`:crc32` | `:xxh3`, default: :crc32) - payload checksum
+      - `:timestamp_codec` (`:delta_of_delta` | `:adaptive` | `:block` | `:auto`)
+      - `:entropy` (`:none` | `:rans`, default: :none) - rANS-coded control streams
       - `:compression` (`:none` | `:zlib` | `:zstd` | `:auto`, default: :none)
       - `:compression_level` (integer 1-22, zstd only, default: ezstd default)
       - `:zlib` (boolean, default: false) - legacy option, use `:compression` instead
@@ -94,9 +100,13 @@ defmodule GorillaStream do
       - `:compression` (`:none` | `:zlib` | `:zstd` | `:auto`, default: :none)
       - `:compression_level` (integer 1-22, zstd only, default: ezstd default)
       - `:zlib` (boolean, default: false) - legacy option, use `:compression` instead
+      - `:missing` (default: nil) - value returned for missing points of sparse series
+      - `:fields` (`:all` | `:timestamps` | `:values`, default: :all) - decode only one
+        column; the native decoder then skips the other bitstream
 
   ## Returns
-  - `{:ok, decompressed_data}` - List of `{timestamp, value}` tuples
+  - `{:ok, decompressed_data}` - List of `{timestamp, value}` tuples, or a list of
+    timestamps or values with `:fields`
   - `{:error, reason}` - Error with description
 
   ## Examples
@@ -118,6 +128,13 @@ defmodule GorillaStream do
     Gorilla.decompress(compressed_data, opts)
   end
 
+  @doc """
+  Re-compresses data with new options (e.g. `algorithm: :chimp128`) in one native pass.
+
+  See `GorillaStream.Compression.Gorilla.transcode/2`.
+  """
+  def transcode(compressed_data, opts \\ []), do: Gorilla.transcode(compressed_data, opts)
+
   @doc """
   Compresses data using a pre-trained zstd dictionary.
 
@@ -144,4 +161,23 @@ defmodule GorillaStream do
 
   """
   defdelegate zstd_available?, to: Container
+
+  @doc """
+  Reports which native kernels this machine runs.
+
+  The NIF is built for the baseline ISA plus newer levels (x86-64-v2/v3/v4, or SVE on
+  aarch64 Linux) and picks the best one the CPU supports when first used.
+
+  ## Returns
+  - `{:ok, %{isa: isa, variants: variants, compiler: compiler, pgo: pgo}}` - `isa` is the
+    selected variant, `variants` every variant compiled in, `pgo` whether the library
+    is the profile-guided build from `make pgo`
+  - `{:error, :not_loaded}` - The NIF is not available
+  """
+  def nif_build_info do
+    {:ok, {isa, variants, compiler, pgo}} = NIF.nif_build_info()
+    {:ok, %{isa: isa, variants: variants, compiler: compiler, pgo: pgo}}
+  rescue
+    _ -> {:error, :not_loaded}
+  end
 end
@@ -0,0 +1,98 @@
+defmodule GorillaStream.Arrow do
+  @moduledoc """
+  Arrow IPC export and import for Gorilla chunks.
+
+  `to_ipc/2` decodes chunks straight into an Arrow IPC stream (or file) holding a
+  `timestamp[ns]` column and a `float64` column, one record batch per chunk, so the
+  result can be handed to pyarrow, Polars, DuckDB or Explorer without a row-wise
+  detour. `from_ipc/2` goes the other way, encoding every record batch of an Arrow
+  IPC payload into a chunk.
+
+  Both directions run in the native encoder/decoder; `{:error, reason}` is returned
+  when the NIF is not loaded.
+
+  ## Examples
+
+      {:ok, ipc} = GorillaStream.Arrow.to_ipc(chunks)
+      {:ok, ipc_file} = GorillaStream.Arrow.to_ipc(chunks, format: :file)
+
+      {:ok, chunks} = GorillaStream.Arrow.from_ipc(ipc, victoria_metrics: true)
+  """
+
+  alias GorillaStream.Compression.Container
+  alias GorillaStream.Compression.Gorilla.{Encoder, NIF}
+
+  @feature "Arrow IPC conversion"
+
+  @doc """
+  Exports one chunk or a list of chunks as Arrow IPC.
+
+  Timestamps are written as-is; `:unit` only sets the unit recorded in the schema.
+
+  ## Options
+
+  - `:format` - `:stream` (default) or `:file`
+  - `:unit` - `:nanosecond` (default), `:microsecond`, `:millisecond` or `:second`
+  - `:timestamp_column` - name of the timestamp column (default `"timestamp"`)
+  - `:value_column` - name of the value column (default `"value"`)
+  - `:compression` - Container compression used (`:none`, `:zlib`, `:zstd`, `:auto`)
+
+  ## Returns
+
+  - `{:ok, ipc_binary}` on success
+  - `{:error, reason}` on failure
+  """
+  def to_ipc(chunks, opts \\ [])
+
+  def to_ipc(chunk, opts) when is_binary(chunk), do: to_ipc([chunk], opts)
+
+  def to_ipc(chunks, opts) when is_list(chunks) do
+    with :ok <- NIF.ensure_loaded(@feature),
+         {:ok, encoded} <- Container.decompress_all(chunks, opts) do
+      nif_opts =
+        opts
+        |> Keyword.take([:format, :unit, :timestamp_column, :value_column])
+        |> Map.new()
+
+      NIF.call(@feature, fn -> NIF.nif_gorilla_to_arrow(encoded, nif_opts) end)
+    end
+  end
+
+  def to_ipc(_, _opts), do: {:error, "Invalid input data"}
+
+  @doc """
+  Encodes every record batch of an Arrow IPC stream or file into a chunk.
+
+  The timestamp column may be a timestamp or int64 column; the value column may
+  be float64, float32 or int64. Columns containing nulls are rejected. Batches
+  whose timestamp gaps overflow the 32-bit delta-of-delta bucket, such as
+  nanosecond timestamps more than about 2 s apart, use adaptive buckets.
+
+  ## Options
+
+  - `:timestamp_column` - column to read timestamps from (default: first timestamp
+    or int64 column)
+  - `:value_column` - column to read values from (default: first floating point column)
+  - `:victoria_metrics`, `:is_counter`, `:scale_decimals` - as for
+    `GorillaStream.Compression.Gorilla.Encoder.encode/2`
+
+  ## Returns
+
+  - `{:ok, [chunk]}` on success
+  - `{:error, reason}` on failure
+  """
+  def from_ipc(ipc, opts \\ [])
+
+  def from_ipc(ipc, opts) when is_binary(ipc) do
+    with :ok <- NIF.ensure_loaded(@feature) do
+      nif_opts =
+        opts
+        |> Encoder.nif_options()
+        |> Map.merge(Map.new(Keyword.take(opts, [:timestamp_column, :value_column])))
+
+      NIF.call(@feature, fn -> NIF.nif_gorilla_from_arrow(ipc, nif_opts) end)
+    end
+  end
+
+  def from_ipc(_, _opts), do: {:error, "Invalid input data"}
+end
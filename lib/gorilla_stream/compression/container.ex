@@ -131,6 +131,29 @@ defmodule GorillaStream.Compression.Container do
     do_decompress(data, compression_type)
   end
 
+  @doc """
+  Decompresses every binary in a list with `decompress/2`, stopping at the first error.
+
+  ## Returns
+
+  - `{:ok, [decompressed_data]}` in input order
+  - `{:error, reason}` on the first failure
+  """
+  @spec decompress_all([binary()], keyword()) :: {:ok, [binary()]} | {:error, String.t()}
+  def decompress_all(chunks, opts \\ []) do
+    chunks
+    |> Enum.reduce_while({:ok, []}, fn chunk, {:ok, acc} ->
+      case decompress(chunk, opts) do
+        {:ok, data} -> {:cont, {:ok, [data | acc]}}
+        {:error, reason} -> {:halt, {:error, reason}}
+      end
+    end)
+    |> case do
+      {:ok, acc} -> {:ok, Enum.reverse(acc)}
+      error -> error
+    end
+  end
+
   @doc """
   Returns the actual compression algorithm that will be used for the given options.
 
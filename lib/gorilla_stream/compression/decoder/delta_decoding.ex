@@ -10,10 +10,15 @@ defmodule GorillaStream.Compression.Decoder.DeltaDecoding do
   2. Read the first delta (variable length)
   3. For subsequent values, read delta-of-delta values and reconstruct timestamps:
      - '0' bit: delta-of-delta is 0 (same interval as previous)
-     - '10' + 7 bits: delta-of-delta in range [-63, 64]
-     - '110' + 9 bits: delta-of-delta in range [-255, 256]
-     - '1110' + 12 bits: delta-of-delta in range [-2047, 2048]
+     - '10' + 7 bits: delta-of-delta in range [-64, 63]
+     - '110' + 9 bits: delta-of-delta in range [-256, 255]
+     - '1110' + 12 bits: delta-of-delta in range [-2048, 2047]
      - '1111' + 32 bits: delta-of-delta as 32-bit signed integer
+
+  Chunks flagged `0x200` (adaptive buckets) keep the prefixes but carry their
+  own field widths: four 6-bit fields (width - 1) follow the first timestamp,
+  and the first delta is coded as a delta-of-delta from 0. Pass
+  `adaptive_buckets: true` in the metadata to decode them.
   """
 
   @doc """
@@ -47,9 +52,10 @@ defmodule GorillaStream.Compression.Decoder.DeltaDecoding do
 
       true ->
         try do
-          case count do
-            1 -> decode_single_timestamp(timestamp_bits)
-            _ -> decode_multiple_timestamps(timestamp_bits, metadata)
+          cond do
+            count == 1 -> decode_single_timestamp(timestamp_bits)
+            Map.get(metadata, :adaptive_buckets, false) -> decode_adaptive(timestamp_bits, count)
+            true -> decode_multiple_timestamps(timestamp_bits, metadata)
           end
         rescue
           error ->
@@ -196,6 +202,75 @@ defmodule GorillaStream.Compression.Decoder.DeltaDecoding do
     end
   end
 
+  # Adaptive buckets: the table follows the first timestamp, and every delta,
+  # the first included, is a delta-of-delta in one of its four buckets.
+  defp decode_adaptive(<<first::signed-64, table::bitstring-24, rest::bitstring>>, count) do
+    <<w1::6, w2::6, w3::6, w4::6>> = table
+    widths = {w1 + 1, w2 + 1, w3 + 1, w4 + 1}
+    decode_adaptive_remaining(rest, count - 1, widths, 0, first, [first])
+  end
+
+  defp decode_adaptive(_, _count), do: {:error, "Insufficient data for initial values"}
+
+  defp decode_adaptive_remaining(_bits, 0, _widths, _prev_delta, _last_timestamp, acc) do
+    {:ok, Enum.reverse(acc)}
+  end
+
+  defp decode_adaptive_remaining(bits, count, widths, prev_delta, last_timestamp, acc) do
+    case decode_adaptive_delta_of_delta(bits, widths) do
+      {:ok, {dod, remaining_bits}} ->
+        # The native encoder takes deltas modulo 2^64
+        current_delta = wrap_int64(prev_delta + dod)
+        next_timestamp = wrap_int64(last_timestamp + current_delta)
+
+        decode_adaptive_remaining(
+          remaining_bits,
+          count - 1,
+          widths,
+          current_delta,
+          next_timestamp,
+          [next_timestamp | acc]
+        )
+
+      {:error, reason} ->
+        {:error, reason}
+    end
+  end
+
+  defp decode_adaptive_delta_of_delta(<<0::1, rest::bitstring>>, _widths), do: {:ok, {0, rest}}
+
+  defp decode_adaptive_delta_of_delta(<<1::1, 0::1, rest::bitstring>>, {w, _, _, _}),
+    do: read_signed_field(rest, w)
+
+  defp decode_adaptive_delta_of_delta(<<1::1, 1::1, 0::1, rest::bitstring>>, {_, w, _, _}),
+    do: read_signed_field(rest, w)
+
+  defp decode_adaptive_delta_of_delta(<<1::1, 1::1, 1::1, 0::1, rest::bitstring>>, {_, _, w, _}),
+    do: read_signed_field(rest, w)
+
+  defp decode_adaptive_delta_of_delta(<<1::1, 1::1, 1::1, 1::1, rest::bitstring>>, {_, _, _, w}),
+    do: read_signed_field(rest, w)
+
+  defp decode_adaptive_delta_of_delta(_bits, _widths),
+    do: {:error, "Insufficient bits for delta-of-delta"}
+
+  defp read_signed_field(bits, width) do
+    case bits do
+      <<value::size(width)-signed, rest::bitstring>> -> {:ok, {value, rest}}
+      _ -> {:error, "Insufficient bits for delta-of-delta"}
+    end
+  end
+
+  @int64_min -0x8000000000000000
+  @int64_max 0x7FFFFFFFFFFFFFFF
+
+  defp wrap_int64(value) when value >= @int64_min and value <= @int64_max, do: value
+
+  defp wrap_int64(value) do
+    <<wrapped::signed-64>> = <<value::64>>
+    wrapped
+  end
+
   @doc """
   Validates that a timestamp bitstream can be properly decoded.
 
@@ -13,9 +13,14 @@ defmodule GorillaStream.Compression.Decoder.Metadata do
   - Checksum for integrity verification
   """
 
+  import Bitwise
+
+  alias GorillaStream.Compression.XXH3
+
   # "GORILLA" in hex
   @magic_number 0x474F52494C4C41
   @version 1
+  @xxh3_version 2
 
   @doc """
   Extracts metadata from encoded data.
@@ -53,7 +58,7 @@ defmodule GorillaStream.Compression.Decoder.Metadata do
   def extract_metadata(_), do: {%{count: 0}, <<>>}
 
   # Parse the metadata header
-  # Parse v1 (80 bytes) or v2 (84 bytes) headers
+  # Parse v1 (80 bytes) or v2 (84 bytes) headers, optionally followed by xxHash3
   defp parse_metadata_header(<<
          @magic_number::64,
          version::16,
@@ -73,58 +78,47 @@ defmodule GorillaStream.Compression.Decoder.Metadata do
          flags::32,
          rest::binary
        >>) do
-    cond do
-      version <= @version and header_length == 80 and byte_size(rest) >= compressed_size ->
-        parse_with_scale(
-          first_timestamp,
-          first_delta,
-          first_value_bits,
-          timestamp_bit_length,
-          value_bit_length,
-          total_bits,
-          compression_ratio,
-          creation_time,
-          flags,
-          0,
-          rest,
-          compressed_size,
-          version,
-          header_length,
-          count,
-          original_size,
-          checksum
-        )
-
-      version <= @version and header_length == 84 and byte_size(rest) >= compressed_size + 4 ->
-        <<scale_decimals::32, remaining_data::binary>> = rest
-
-        parse_with_scale(
-          first_timestamp,
-          first_delta,
-          first_value_bits,
-          timestamp_bit_length,
-          value_bit_length,
-          total_bits,
-          compression_ratio,
-          creation_time,
-          flags,
-          scale_decimals,
-          remaining_data,
-          compressed_size,
-          version,
-          header_length,
-          count,
-          original_size,
-          checksum
-        )
-
-      true ->
-        {:error, "Invalid header format or version"}
+    scale_size = if header_length in [84, 92], do: 4, else: 0
+    xxh3_size = if header_length in [88, 92], do: 8, else: 0
+
+    with true <- valid_layout?(version, header_length),
+         <<scale_decimals::size(scale_size)-unit(8), hash::size(xxh3_size)-unit(8),
+           remaining_data::binary>> <- rest,
+         true <- byte_size(remaining_data) >= compressed_size do
+      parse_with_scale(
+        first_timestamp,
+        first_delta,
+        first_value_bits,
+        timestamp_bit_length,
+        value_bit_length,
+        total_bits,
+        compression_ratio,
+        creation_time,
+        flags,
+        scale_decimals,
+        remaining_data,
+        compressed_size,
+        version,
+        header_length,
+        count,
+        original_size,
+        if(xxh3_size > 0, do: hash, else: checksum)
+      )
+    else
+      _ -> {:error, "Invalid header format or version"}
     end
   end
 
   defp parse_metadata_header(_), do: {:error, "Invalid metadata header"}
 
+  # v1 headers are 80 bytes, or 84 with scale_decimals; version 2 headers add
+  # a 64-bit xxHash3 after them (flag 0x80).
+  defp valid_layout?(version, header_length) when version <= @version,
+    do: header_length in [80, 84]
+
+  defp valid_layout?(@xxh3_version, header_length), do: header_length in [88, 92]
+  defp valid_layout?(_version, _header_length), do: false
+
   defp parse_with_scale(
          first_timestamp,
          first_delta,
@@ -144,44 +138,89 @@ defmodule GorillaStream.Compression.Decoder.Metadata do
          original_size,
          checksum
        ) do
-    first_value = bits_to_float(first_value_bits)
+    metadata =
+      from_header_fields(%{
+        version: version,
+        header_length: header_length,
+        count: count,
+        compressed_size: compressed_size,
+        original_size: original_size,
+        checksum: checksum,
+        checksum_type: if(version == @xxh3_version, do: :xxh3, else: :crc32),
+        first_timestamp: first_timestamp,
+        first_delta: first_delta,
+        first_value: bits_to_float(first_value_bits),
+        timestamp_bit_length: timestamp_bit_length,
+        value_bit_length: value_bit_length,
+        total_bits: total_bits,
+        compression_ratio: compression_ratio,
+        creation_time: creation_time,
+        flags: flags,
+        scale_decimals: scale_decimals
+      })
+
+    <<compressed_data::binary-size(^compressed_size), _rest::binary>> = data
+    {:ok, metadata, compressed_data}
+  end
+
+  @doc """
+  Builds the metadata map of `extract_metadata/1` from raw header fields, as
+  returned by the native header reader. A `checksum_failed: true` field is kept;
+  any other value of it is dropped, as `extract_metadata/1` only flags failures.
+  """
+  def from_header_fields(fields) do
+    %{count: count, flags: flags} = fields
 
     timestamp_metadata = %{
       count: count,
-      first_timestamp: first_timestamp,
-      first_delta: if(count > 1, do: first_delta, else: nil)
+      first_timestamp: fields.first_timestamp,
+      first_delta: if(count > 1, do: fields.first_delta, else: nil)
     }
 
     value_metadata = %{
       count: count,
-      first_value: first_value
+      first_value: fields.first_value
     }
 
-    metadata = %{
-      version: version,
-      header_length: header_length,
-      count: count,
-      compressed_size: compressed_size,
-      original_size: original_size,
-      checksum: checksum,
-      timestamp_bit_length: timestamp_bit_length,
-      value_bit_length: value_bit_length,
-      total_bits: total_bits,
-      compression_ratio: compression_ratio,
-      creation_time: creation_time,
-      flags: flags,
-      scale_decimals: scale_decimals,
-      timestamp_metadata: timestamp_metadata,
-      value_metadata: value_metadata
-    }
-
-    <<compressed_data::binary-size(^compressed_size), _rest::binary>> = data
-    {:ok, metadata, compressed_data}
+    metadata =
+      fields
+      |> Map.take([
+        :version,
+        :header_length,
+        :count,
+        :compressed_size,
+        :original_size,
+        :checksum,
+        :checksum_type,
+        :timestamp_bit_length,
+        :value_bit_length,
+        :total_bits,
+        :compression_ratio,
+        :creation_time,
+        :flags,
+        :scale_decimals
+      ])
+      |> Map.merge(%{
+        mantissa_bits: mantissa_bits(flags),
+        timestamp_codec: timestamp_codec(flags),
+        chimp128_window: chimp128_window(flags),
+        entropy: if((flags &&& 0x1000) != 0, do: :rans, else: :none),
+        timestamp_metadata: timestamp_metadata,
+        value_metadata: value_metadata
+      })
+
+    if Map.get(fields, :checksum_failed) == true,
+      do: Map.put(metadata, :checksum_failed, true),
+      else: metadata
   end
 
   # Verify data integrity using checksum
-  defp verify_data_integrity(%{checksum: expected_checksum}, data) do
-    actual_checksum = :erlang.crc32(data)
+  defp verify_data_integrity(%{checksum: expected_checksum} = metadata, data) do
+    actual_checksum =
+      case metadata.checksum_type do
+        :xxh3 -> XXH3.hash64(data)
+        :crc32 -> :erlang.crc32(data)
+      end
 
     if actual_checksum == expected_checksum do
       :ok
@@ -190,6 +229,20 @@ defmodule GorillaStream.Compression.Decoder.Metadata do
     end
   end
 
+  # Lossy chunks (flag 0x20) keep the rounded mantissa width in bits 16-21
+  defp mantissa_bits(flags) when (flags &&& 0x20) != 0, do: (flags >>> 16) &&& 0x3F
+  defp mantissa_bits(_flags), do: nil
+
+  defp timestamp_codec(flags) when (flags &&& 0x100) != 0, do: :block
+  defp timestamp_codec(flags) when (flags &&& 0x200) != 0, do: :adaptive
+  defp timestamp_codec(_flags), do: :delta_of_delta
+
+  # Chimp128 chunks (flag 0x8) keep their window size in bits 10-11
+  defp chimp128_window(flags) when (flags &&& 0x8) != 0,
+    do: elem({128, 32, 64, 256}, (flags >>> 10) &&& 0x3)
+
+  defp chimp128_window(_flags), do: nil
+
   # Convert 64-bit integer back to float
   defp bits_to_float(bits) do
     <<value::float-64>> = <<bits::64>>
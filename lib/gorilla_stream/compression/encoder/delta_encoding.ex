@@ -7,9 +7,9 @@ defmodule GorillaStream.Compression.Encoder.DeltaEncoding do
   2. Store the delta between the second and first timestamp (variable length)
   3. For subsequent timestamps, compute delta-of-delta and encode with variable length:
      - If delta-of-delta is 0: store single bit '0'
-     - If delta-of-delta fits in [-63, 64]: store '10' + 7 bits
-     - If delta-of-delta fits in [-255, 256]: store '110' + 9 bits
-     - If delta-of-delta fits in [-2047, 2048]: store '1110' + 12 bits
+     - If delta-of-delta fits in [-64, 63]: store '10' + 7 bits
+     - If delta-of-delta fits in [-256, 255]: store '110' + 9 bits
+     - If delta-of-delta fits in [-2048, 2047]: store '1110' + 12 bits
      - Otherwise: store '1111' + 32 bits
 
   This encoding is highly efficient for regularly spaced time series data.
@@ -68,15 +68,15 @@ defmodule GorillaStream.Compression.Encoder.DeltaEncoding do
     <<0::1>>
   end
 
-  defp encode_first_delta(delta) when delta >= -63 and delta <= 64 do
+  defp encode_first_delta(delta) when delta >= -64 and delta <= 63 do
     <<1::1, 0::1, delta::7-signed>>
   end
 
-  defp encode_first_delta(delta) when delta >= -255 and delta <= 256 do
+  defp encode_first_delta(delta) when delta >= -256 and delta <= 255 do
     <<1::1, 1::1, 0::1, delta::9-signed>>
   end
 
-  defp encode_first_delta(delta) when delta >= -2047 and delta <= 2048 do
+  defp encode_first_delta(delta) when delta >= -2048 and delta <= 2047 do
     <<1::1, 1::1, 1::1, 0::1, delta::12-signed>>
   end
 
@@ -90,17 +90,17 @@ defmodule GorillaStream.Compression.Encoder.DeltaEncoding do
     <<0::1>>
   end
 
-  defp encode_delta_of_delta(dod) when dod >= -63 and dod <= 64 do
+  defp encode_delta_of_delta(dod) when dod >= -64 and dod <= 63 do
     # 2 control bits + 7 data bits
     <<1::1, 0::1, dod::7-signed>>
   end
 
-  defp encode_delta_of_delta(dod) when dod >= -255 and dod <= 256 do
+  defp encode_delta_of_delta(dod) when dod >= -256 and dod <= 255 do
     # 3 control bits + 9 data bits
     <<1::1, 1::1, 0::1, dod::9-signed>>
   end
 
-  defp encode_delta_of_delta(dod) when dod >= -2047 and dod <= 2048 do
+  defp encode_delta_of_delta(dod) when dod >= -2048 and dod <= 2047 do
     # 4 control bits + 12 data bits
     <<1::1, 1::1, 1::1, 0::1, dod::12-signed>>
   end
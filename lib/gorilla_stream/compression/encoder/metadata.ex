@@ -17,8 +17,12 @@ defmodule GorillaStream.Compression.Encoder.Metadata do
   # "GORILLA" in hex
   @magic_number 0x474F52494C4C41
   @version 1
+  # Version 2 headers append a 64-bit xxHash3 of the payload (flag 0x80)
+  @xxh3_version 2
   import Bitwise
 
+  alias GorillaStream.Compression.XXH3
+
   @doc """
   Adds metadata to packed data.
 
@@ -58,8 +62,10 @@ defmodule GorillaStream.Compression.Encoder.Metadata do
     timestamp_bit_length = Map.get(metadata, :timestamp_bit_length, 0)
     value_bit_length = Map.get(metadata, :value_bit_length, 0)
 
-    # Calculate checksum for integrity verification
-    checksum = :erlang.crc32(packed_data)
+    # Calculate checksum for integrity verification: CRC32 in the v1 field,
+    # or xxHash3 appended to a version 2 header
+    xxh3? = Map.get(metadata, :checksum) == :xxh3
+    checksum = if xxh3?, do: 0, else: :erlang.crc32(packed_data)
 
     # Get timestamp metadata if available
     timestamp_meta = Map.get(metadata, :timestamp_metadata, %{})
@@ -89,18 +95,21 @@ defmodule GorillaStream.Compression.Encoder.Metadata do
     # Determine header version/length: keep v1 (80 bytes) unless VM features used
     emit_v2? = vm_enabled or (is_counter and scale_decimals >= 0)
 
-    header_size = if emit_v2?, do: 84, else: 80
-    creation_time = :os.system_time(:second)
+    header_size = if(emit_v2?, do: 84, else: 80) + if(xxh3?, do: 8, else: 0)
+    version = if xxh3?, do: @xxh3_version, else: @version
+    creation_time =
+      if Map.get(metadata, :deterministic, false), do: 0, else: :os.system_time(:second)
 
     # Flags bitfield
     flags =
       0
       |> (fn f -> if vm_enabled, do: f ||| 0x1, else: f end).()
       |> (fn f -> if is_counter, do: f ||| 0x2, else: f end).()
+      |> (fn f -> if xxh3?, do: f ||| 0x80, else: f end).()
 
     base = <<
       @magic_number::64,
-      @version::16,
+      version::16,
       header_size::16,
       count::32,
       compressed_size::32,
@@ -117,8 +126,10 @@ defmodule GorillaStream.Compression.Encoder.Metadata do
       flags::32
     >>
 
-    if emit_v2? do
-      <<base::binary, scale_decimals::32>>
+    base = if emit_v2?, do: <<base::binary, scale_decimals::32>>, else: base
+
+    if xxh3? do
+      <<base::binary, XXH3.hash64(packed_data)::64>>
     else
       base
     end
@@ -162,10 +173,13 @@ defmodule GorillaStream.Compression.Encoder.Metadata do
         magic != @magic_number ->
           {:error, "Invalid magic number"}
 
-        version > @version ->
+        version > @xxh3_version ->
           {:error, "Unsupported version: #{version}"}
 
-        header_length not in [80, 84] ->
+        header_length not in [80, 84, 88, 92] ->
+          {:error, "Invalid header length: #{header_length}"}
+
+        (version == @xxh3_version) != (header_length in [88, 92]) ->
           {:error, "Invalid header length: #{header_length}"}
 
         byte_size(binary) < header_length ->
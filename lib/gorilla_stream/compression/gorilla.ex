@@ -36,6 +36,11 @@ defmodule GorillaStream.Compression.Gorilla do
       - `:victoria_metrics` (boolean, default: true)
       - `:is_counter` (boolean, default: false)
       - `:scale_decimals` (:auto | integer, default: :auto)
+      - `:value_type` (`:f64` | `:f32`, default: :f64) - store single-precision values
+      - `:max_relative_error` / `:mantissa_bits` - opt-in lossy mantissa rounding
+      - `:checksum` (`:crc32` | `:xxh3`, default: :crc32) - payload checksum
+      - `:timestamp_codec` (`:delta_of_delta` | `:adaptive` | `:block` | `:auto`)
+      - `:entropy` (`:none` | `:rans`, default: :none) - rANS-coded control streams
       - `:compression` (`:none` | `:zlib` | `:zstd` | `:auto`, default: :none)
       - `:zlib` (boolean, default: false) - legacy option, use `:compression` instead
 
@@ -96,6 +101,14 @@ defmodule GorillaStream.Compression.Gorilla do
   end
 
   def compress(stream, opts) when is_list(opts) do
+    if Keyword.has_key?(opts, :rollups) do
+      {:error, ":rollups needs Encoder.encode/2 or Stream.compress_stream/2"}
+    else
+      compress_with_opts(stream, opts)
+    end
+  end
+
+  defp compress_with_opts(stream, opts) do
     case Enum.to_list(stream) do
       [] ->
         {:ok, <<>>}
@@ -125,6 +138,9 @@ defmodule GorillaStream.Compression.Gorilla do
     - keyword options, supporting:
       - `:compression` (`:none` | `:zlib` | `:zstd` | `:auto`, default: :none)
       - `:zlib` (boolean, default: false) - legacy option, use `:compression` instead
+      - `:missing` (default: nil) - value returned for missing points of sparse series
+      - `:fields` (`:all` | `:timestamps` | `:values`, default: :all) - decode only one
+        column, returned as a plain list
       - Other VM options are read from the header automatically by the decoder.
 
   ## Returns
@@ -158,7 +174,7 @@ defmodule GorillaStream.Compression.Gorilla do
   def decompress(compressed_data, opts) when is_list(opts) do
     case decompress_with_container(compressed_data, opts) do
       {:ok, encoded_data} ->
-        case Decoder.decode(encoded_data) do
+        case Decoder.decode(encoded_data, Keyword.take(opts, [:missing, :fields])) do
           {:ok, original_stream} -> {:ok, original_stream}
           {:error, reason} -> {:error, "Decompression failed: #{inspect(reason)}"}
         end
@@ -168,6 +184,45 @@ defmodule GorillaStream.Compression.Gorilla do
     end
   end
 
+  @doc """
+  Re-compresses previously compressed data with new options, without decoding to tuples.
+
+  Useful for re-tuning stored series, e.g. moving them to `algorithm: :chimp128`.
+
+  ## Parameters
+  - `compressed_data`: A compressed binary, or a list of them
+  - `opts`: Encoder options as for `compress/2` (`:algorithm`, `:victoria_metrics`,
+    `:is_counter`, `:scale_decimals`), plus:
+    - `:compression` - Container compression of both input and output (default: :none)
+    - `:parallel` - For lists, `true` or a thread count to transcode chunks in parallel
+
+  ## Returns
+  - `{:ok, compressed}` (or `{:ok, [compressed]}` for a list) on success
+  - `{:error, reason}` on failure
+
+  ## Examples
+      iex> stream = [{1609459200, 1.23}, {1609459201, 1.24}, {1609459202, 1.25}]
+      iex> {:ok, compressed} = GorillaStream.Compression.Gorilla.compress(stream, victoria_metrics: false)
+      iex> {:ok, retuned} = GorillaStream.Compression.Gorilla.transcode(compressed, algorithm: :chimp128)
+      iex> GorillaStream.Compression.Gorilla.decompress(retuned, [])
+      {:ok, [{1609459200, 1.23}, {1609459201, 1.24}, {1609459202, 1.25}]}
+  """
+  def transcode(compressed_data, opts \\ [])
+
+  def transcode(compressed_data, opts) when is_binary(compressed_data) do
+    with {:ok, encoded_data} <- decompress_with_container(compressed_data, opts),
+         {:ok, transcoded} <- Encoder.transcode(encoded_data, opts) do
+      apply_container_compression(transcoded, opts)
+    end
+  end
+
+  def transcode(chunks, opts) when is_list(chunks) do
+    with {:ok, encoded} <- map_ok(chunks, &decompress_with_container(&1, opts)),
+         {:ok, transcoded} <- Encoder.transcode_batch(encoded, opts) do
+      map_ok(transcoded, &apply_container_compression(&1, opts))
+    end
+  end
+
   @doc """
   Validates that a stream of data is in the correct format for compression.
 
@@ -199,6 +254,9 @@ defmodule GorillaStream.Compression.Gorilla do
     true
   end
 
+  # Missing point of a sparse series
+  defp is_valid_data_tuple?({timestamp, nil}) when is_integer(timestamp), do: true
+
   defp is_valid_data_tuple?(_) do
     false
   end
@@ -239,6 +297,20 @@ defmodule GorillaStream.Compression.Gorilla do
   defp decompress_with_container(data, opts) when is_list(opts) do
     Container.decompress(data, opts)
   end
+
+  defp map_ok(items, fun) do
+    items
+    |> Enum.reduce_while({:ok, []}, fn item, {:ok, acc} ->
+      case fun.(item) do
+        {:ok, result} -> {:cont, {:ok, [result | acc]}}
+        {:error, reason} -> {:halt, {:error, reason}}
+      end
+    end)
+    |> case do
+      {:ok, acc} -> {:ok, Enum.reverse(acc)}
+      error -> error
+    end
+  end
 end
 
 # The implementation includes:
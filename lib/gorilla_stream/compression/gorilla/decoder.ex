@@ -20,7 +20,7 @@ defmodule GorillaStream.Compression.Gorilla.Decoder do
     ValueDecompression
   }
 
-  alias GorillaStream.Compression.Gorilla.NIF
+  alias GorillaStream.Compression.Gorilla.{Encoder, NIF}
 
   @doc """
   Returns true if the native NIF decoder is available.
@@ -34,26 +34,78 @@ defmodule GorillaStream.Compression.Gorilla.Decoder do
 
   ## Parameters
   - `encoded_data`: Binary data to decode
+  - `opts`: Keyword options:
+    - `:missing` - value returned for the missing points of a sparse chunk (encoded
+      with `nil` values); default `nil`. Pass `:nan` for the atom Nx reads as NaN.
+    - `:fields` - `:all` (default) for `{timestamp, value}` tuples, or `:timestamps`
+      / `:values` for a plain list of that column. The native decoder then reads
+      only that column's bitstream; values start at an offset recorded in the
+      chunk, so a values-only decode skips the timestamps entirely.
 
   ## Returns
   - `{:ok, decoded_data}`: When decoding is successful
   - `{:error, reason}`: When decoding fails
   """
-  def decode(<<>>), do: {:ok, []}
+  def decode(encoded_data, opts \\ [])
+  def decode(<<>>, _opts), do: {:ok, []}
 
-  def decode(encoded_data) when is_binary(encoded_data) do
-    if nif_available?() do
-      try do
-        NIF.nif_gorilla_decode(encoded_data)
-      rescue
-        _ -> decode_elixir(encoded_data)
+  def decode(encoded_data, opts) when is_binary(encoded_data) do
+    case Keyword.get(opts, :fields, :all) do
+      fields when fields in [:all, :timestamps, :values] ->
+        decode_fields(encoded_data, fields, opts)
+
+      fields ->
+        {:error, "Invalid :fields option #{inspect(fields)}"}
+    end
+  end
+
+  def decode(_, _opts), do: {:error, "Invalid input data"}
+
+  defp decode_fields(encoded_data, fields, opts) do
+    result =
+      if nif_available?() do
+        try do
+          decode_fields_nif(encoded_data, fields)
+        rescue
+          _ -> decode_fields_elixir(encoded_data, fields)
+        end
+      else
+        decode_fields_elixir(encoded_data, fields)
       end
-    else
-      decode_elixir(encoded_data)
+
+    fill_missing(result, fields, Keyword.get(opts, :missing))
+  end
+
+  defp decode_fields_nif(encoded_data, :all), do: NIF.nif_gorilla_decode(encoded_data)
+
+  defp decode_fields_nif(encoded_data, :timestamps),
+    do: NIF.nif_gorilla_decode_timestamps(encoded_data)
+
+  defp decode_fields_nif(encoded_data, :values), do: NIF.nif_gorilla_decode_values(encoded_data)
+
+  defp decode_fields_elixir(encoded_data, fields) do
+    case decode_elixir(encoded_data) do
+      {:ok, points} when fields == :timestamps -> {:ok, Enum.map(points, &elem(&1, 0))}
+      {:ok, points} when fields == :values -> {:ok, Enum.map(points, &elem(&1, 1))}
+      result -> result
     end
   end
 
-  def decode(_), do: {:error, "Invalid input data"}
+  defp fill_missing(result, _fields, nil), do: result
+
+  defp fill_missing({:ok, points}, :all, missing) do
+    {:ok,
+     Enum.map(points, fn
+       {timestamp, nil} -> {timestamp, missing}
+       point -> point
+     end)}
+  end
+
+  defp fill_missing({:ok, values}, :values, missing) do
+    {:ok, Enum.map(values, fn value -> if is_nil(value), do: missing, else: value end)}
+  end
+
+  defp fill_missing(result, _fields, _missing), do: result
 
   @doc """
   Pure-Elixir decode, used as fallback when NIF is unavailable.
@@ -63,8 +115,11 @@ defmodule GorillaStream.Compression.Gorilla.Decoder do
   def decode_elixir(encoded_data) when is_binary(encoded_data) do
     try do
       with {:ok, extracted_metadata, remaining_data} <- extract_metadata(encoded_data),
+           :ok <- check_elixir_supported(extracted_metadata),
+           :ok <- check_checksum(extracted_metadata),
            {:ok, timestamp_bits, value_bits, unpack_metadata} <- unpack_data(remaining_data),
-           {:ok, timestamps} <- decode_timestamps(timestamp_bits, unpack_metadata),
+           {:ok, timestamps} <-
+             decode_timestamps(timestamp_bits, unpack_metadata, extracted_metadata),
            {:ok, values_raw} <- decode_values(value_bits, unpack_metadata),
            {:ok, values} <- maybe_vm_postprocess(values_raw, extracted_metadata),
            {:ok, combined_stream} <- combine_stream(timestamps, values) do
@@ -76,6 +131,252 @@ defmodule GorillaStream.Compression.Gorilla.Decoder do
     end
   end
 
+  @doc """
+  Decodes compressed binary data into two columnar binaries instead of a list
+  of tuples.
+
+  Timestamps are packed as native-endian signed 64-bit integers and values as
+  native-endian 64-bit floats, which is the layout `Nx.from_binary/2` wraps
+  for `{:s, 64}` and `{:f, 64}` without another copy. Missing points of a
+  sparse chunk keep their timestamp and come out as NaN.
+
+  ## Parameters
+  - `encoded_data`: Binary data to decode
+  - `opts`: Keyword options:
+    - `:value_type` - `:f64` (default) or `:f32` to pack values as native-endian
+      32-bit floats (`{:f, 32}`); chunks written with `value_type: :f32` decode
+      straight into this layout
+
+  ## Returns
+  - `{:ok, {timestamps_binary, values_binary}}`: When decoding is successful
+  - `{:error, reason}`: When decoding fails
+  """
+  def decode_columns(encoded_data, opts \\ [])
+  def decode_columns(<<>>, _opts), do: {:ok, {<<>>, <<>>}}
+
+  def decode_columns(encoded_data, opts) when is_binary(encoded_data) do
+    if nif_available?() do
+      try do
+        NIF.nif_gorilla_decode_columns(encoded_data, column_options(opts))
+      rescue
+        _ -> decode_columns_elixir(encoded_data, opts)
+      end
+    else
+      decode_columns_elixir(encoded_data, opts)
+    end
+  end
+
+  def decode_columns(_, _opts), do: {:error, "Invalid input data"}
+
+  @doc """
+  Decodes a list of compressed chunks into one pair of concatenated columnar
+  binaries, in the same layout as `decode_columns/2`. Accepts the same options.
+
+  ## Returns
+  - `{:ok, {timestamps_binary, values_binary, counts}}` where `counts` lists the
+    number of points contributed by each chunk, in order
+  - `{:error, reason}`: When any chunk fails to decode
+  """
+  def decode_columns_batch(chunks, opts \\ [])
+
+  def decode_columns_batch(chunks, opts) when is_list(chunks) do
+    if Enum.all?(chunks, &is_binary/1) do
+      if nif_available?() do
+        try do
+          NIF.nif_gorilla_decode_columns_batch(chunks, column_options(opts))
+        rescue
+          _ -> decode_columns_batch_elixir(chunks, opts)
+        end
+      else
+        decode_columns_batch_elixir(chunks, opts)
+      end
+    else
+      {:error, "Invalid input data - expected a list of binaries"}
+    end
+  end
+
+  def decode_columns_batch(_, _opts),
+    do: {:error, "Invalid input data - expected a list of binaries"}
+
+  defp column_options(opts), do: Map.new(Keyword.take(opts, [:value_type]))
+
+  @doc """
+  Indexes chunks stored back to back in one binary, reading only their headers.
+
+  Each chunk spans its header plus `compressed_size` bytes, so the native scanner
+  walks the whole binary in one call without decoding any points. The index is
+  columnar, one native-endian entry per chunk:
+
+    - `:offsets`, `:lengths` - byte range of each chunk (`{:s, 64}`)
+    - `:counts` - points per chunk (`{:u, 32}`)
+    - `:first_timestamps` - first timestamp of each chunk (`{:s, 64}`)
+    - `:last_timestamps` - last timestamp of each chunk (`{:s, 64}`), or `nil`
+      unless `last_timestamp: true` is given. Headers do not record it, so chunks
+      of three or more points are decoded to find it.
+    - `:flags` - header flags (`{:u, 32}`)
+    - `:content_hashes` - the `Encoder.content_hash/1` of each chunk, 16 bytes
+      apiece, or `nil` unless `content_hash: true` is given
+
+  ## Returns
+  - `{:ok, index}`: The map above
+  - `{:error, reason}`: When a header is malformed or a chunk is truncated
+  """
+  def scan_chunks(data, opts \\ [])
+
+  def scan_chunks(data, opts) when is_binary(data) do
+    with_last = Keyword.get(opts, :last_timestamp, false)
+    with_hash = Keyword.get(opts, :content_hash, false)
+
+    result =
+      if nif_available?() do
+        try do
+          NIF.nif_gorilla_scan_chunks(data, %{last_timestamp: with_last, content_hash: with_hash})
+        rescue
+          _ -> scan_chunks_elixir(data, with_last, with_hash)
+        end
+      else
+        scan_chunks_elixir(data, with_last, with_hash)
+      end
+
+    case result do
+      {:ok, {offsets, lengths, counts, firsts, lasts, flags, hashes}} ->
+        {:ok,
+         %{
+           offsets: offsets,
+           lengths: lengths,
+           counts: counts,
+           first_timestamps: firsts,
+           last_timestamps: lasts,
+           flags: flags,
+           content_hashes: hashes
+         }}
+
+      error ->
+        error
+    end
+  end
+
+  def scan_chunks(_, _opts), do: {:error, "Invalid input - expected binary data"}
+
+  defp scan_chunks_elixir(data, with_last, with_hash) do
+    with {:ok, entries} <- scan_headers(data, 0, []),
+         {:ok, lasts} <- last_timestamps(data, entries, with_last) do
+      column = fn fun -> for entry <- entries, into: <<>>, do: fun.(entry) end
+
+      hashes =
+        if with_hash do
+          column.(fn {offset, length, _, _, _} ->
+            {:ok, hash} = Encoder.content_hash(binary_part(data, offset, length))
+            hash
+          end)
+        end
+
+      {:ok,
+       {column.(fn {offset, _, _, _, _} -> <<offset::signed-native-64>> end),
+        column.(fn {_, length, _, _, _} -> <<length::signed-native-64>> end),
+        column.(fn {_, _, count, _, _} -> <<count::native-32>> end),
+        column.(fn {_, _, _, first, _} -> <<first::signed-native-64>> end), lasts,
+        column.(fn {_, _, _, _, flags} -> <<flags::native-32>> end), hashes}}
+    end
+  end
+
+  defp last_timestamps(_data, _entries, false), do: {:ok, nil}
+
+  defp last_timestamps(data, entries, true) do
+    Enum.reduce_while(entries, {:ok, <<>>}, fn {offset, length, _, _, _}, {:ok, acc} ->
+      case decode(binary_part(data, offset, length)) do
+        {:ok, points} ->
+          {ts, _} = List.last(points)
+          {:cont, {:ok, <<acc::binary, ts::signed-native-64>>}}
+
+        {:error, reason} ->
+          {:halt, {:error, reason}}
+      end
+    end)
+  end
+
+  # Outer header fields by byte offset; see Encoder.Metadata
+  defp scan_headers(data, offset, acc) when offset == byte_size(data),
+    do: {:ok, Enum.reverse(acc)}
+
+  defp scan_headers(data, offset, acc) do
+    case binary_part(data, offset, min(80, byte_size(data) - offset)) do
+      <<0, "GORILLA", _version::16, header_size::16, count::32, compressed_size::32,
+        _original_size::32, _crc::32, first_ts::signed-64, _::binary-size(40),
+        flags::32>>
+      when offset + header_size + compressed_size <= byte_size(data) ->
+        entry = {offset, header_size + compressed_size, count, first_ts, flags}
+        scan_headers(data, offset + header_size + compressed_size, [entry | acc])
+
+      _ ->
+        {:error, "Invalid chunk header at byte #{offset}"}
+    end
+  end
+
+  defp decode_columns_elixir(encoded_data, opts) do
+    with {:ok, points} <- decode_elixir(encoded_data) do
+      {ts_bin, val_bin} = points_to_columns(points, opts)
+      {:ok, {ts_bin, val_bin}}
+    end
+  end
+
+  defp decode_columns_batch_elixir(chunks, opts) do
+    chunks
+    |> Enum.reduce_while({:ok, [], [], []}, fn chunk, {:ok, ts_acc, val_acc, counts} ->
+      case decode_elixir(chunk) do
+        {:ok, points} ->
+          {ts_bin, val_bin} = points_to_columns(points, opts)
+          {:cont, {:ok, [ts_bin | ts_acc], [val_bin | val_acc], [length(points) | counts]}}
+
+        {:error, reason} ->
+          {:halt, {:error, reason}}
+      end
+    end)
+    |> case do
+      {:ok, ts_acc, val_acc, counts} ->
+        ts_bin = IO.iodata_to_binary(Enum.reverse(ts_acc))
+        val_bin = IO.iodata_to_binary(Enum.reverse(val_acc))
+        {:ok, {ts_bin, val_bin, Enum.reverse(counts)}}
+
+      error ->
+        error
+    end
+  end
+
+  defp points_to_columns(points, opts) do
+    ts_bin = for {ts, _} <- points, into: <<>>, do: <<ts::signed-native-64>>
+
+    val_bin =
+      case Keyword.get(opts, :value_type, :f64) do
+        :f32 -> for {_, val} <- points, into: <<>>, do: <<val::float-native-32>>
+        _ -> for {_, val} <- points, into: <<>>, do: <<val::float-native-64>>
+      end
+
+    {ts_bin, val_bin}
+  end
+
+  # Chimp (0x4), Chimp128 (0x8), float32 (0x10) and FPC (0x2000) value
+  # streams, validity bitmaps (0x40), block timestamps (0x100) and rANS
+  # control streams (0x1000) are only understood by the native decoder.
+  @native_only_flags 0x315C
+
+  defp check_elixir_supported(metadata) do
+    import Bitwise
+
+    if (Map.get(metadata, :flags, 0) &&& @native_only_flags) == 0 do
+      :ok
+    else
+      {:error, "Chunk uses a value encoding that requires the native decoder"}
+    end
+  end
+
+  # An xxHash3 mismatch fails the decode; CRC32 mismatches are only flagged
+  # in the metadata, as they always have been.
+  defp check_checksum(%{checksum_type: :xxh3, checksum_failed: true}),
+    do: {:error, "Checksum mismatch"}
+
+  defp check_checksum(_metadata), do: :ok
+
   # Extract metadata from encoded data
   defp extract_metadata(encoded_data) do
     try do
@@ -98,10 +399,16 @@ defmodule GorillaStream.Compression.Gorilla.Decoder do
     end
   end
 
-  # Decode timestamps using delta-of-delta decompression
-  defp decode_timestamps(timestamp_bits, metadata) do
+  # Decode timestamps using delta-of-delta decompression; chunks flagged 0x200
+  # carry their own bucket widths.
+  defp decode_timestamps(timestamp_bits, metadata, header_metadata) do
+    import Bitwise
+
     try do
-      timestamp_metadata = Map.get(metadata, :timestamp_metadata, %{})
+      timestamp_metadata =
+        metadata
+        |> Map.get(:timestamp_metadata, %{})
+        |> Map.put(:adaptive_buckets, (Map.get(header_metadata, :flags, 0) &&& 0x200) != 0)
 
       case DeltaDecoding.decode(timestamp_bits, timestamp_metadata) do
         {:ok, timestamps} ->
@@ -218,16 +525,89 @@ defmodule GorillaStream.Compression.Gorilla.Decoder do
   @doc """
   Gets information about compressed data without full decompression.
 
+  The native decoder reads the header fields in one call without touching the
+  bitstreams.
+
   ## Parameters
   - `encoded_data`: Binary data to analyze
+  - `opts`: Keyword options:
+    - `:verify_checksum` - hash the payload and set `checksum_failed: true` in the
+      metadata on a mismatch (default: true). Pass `false` when listing many chunks.
 
   ## Returns
   - `{:ok, info}` with compression information, or `{:error, reason}`
   """
-  def get_compression_info(encoded_data) when is_binary(encoded_data) do
+  def get_compression_info(encoded_data, opts \\ [])
+
+  def get_compression_info(encoded_data, opts) when is_binary(encoded_data) do
+    fields =
+      if nif_available?() do
+        try do
+          {:ok, fields} = NIF.nif_gorilla_info(encoded_data, info_options(opts))
+          fields
+        rescue
+          _ -> nil
+        end
+      end
+
+    if fields,
+      do: {:ok, info_from_fields(encoded_data, fields)},
+      else: get_compression_info_elixir(encoded_data, opts)
+  end
+
+  def get_compression_info(_, _opts), do: {:error, "Invalid input - expected binary data"}
+
+  @doc """
+  Gets information about many chunks in one native call, in the same form as
+  `get_compression_info/2` and with the same options.
+
+  ## Returns
+  - A list with one `{:ok, info}` or `{:error, reason}` per chunk, in order
+  """
+  def get_compression_info_batch(chunks, opts \\ []) when is_list(chunks) do
+    native =
+      if nif_available?() and Enum.all?(chunks, &is_binary/1) do
+        try do
+          {:ok, fields} = NIF.nif_gorilla_info_batch(chunks, info_options(opts))
+          fields
+        rescue
+          _ -> nil
+        end
+      end
+
+    case native do
+      nil ->
+        Enum.map(chunks, &get_compression_info(&1, opts))
+
+      fields ->
+        Enum.zip_with(chunks, fields, fn
+          chunk, nil -> get_compression_info_elixir(chunk, opts)
+          chunk, fields -> {:ok, info_from_fields(chunk, fields)}
+        end)
+    end
+  end
+
+  defp info_options(opts), do: %{verify_checksum: Keyword.get(opts, :verify_checksum, true)}
+
+  defp info_from_fields(encoded_data, fields) do
+    %{
+      total_size: byte_size(encoded_data),
+      metadata_size: byte_size(encoded_data) - fields.compressed_size,
+      data_size: fields.compressed_size,
+      count: fields.count,
+      metadata: Metadata.from_header_fields(fields)
+    }
+  end
+
+  defp get_compression_info_elixir(encoded_data, opts) do
     try do
       case extract_metadata(encoded_data) do
         {:ok, metadata, remaining_data} ->
+          metadata =
+            if Keyword.get(opts, :verify_checksum, true),
+              do: metadata,
+              else: Map.delete(metadata, :checksum_failed)
+
           info = %{
             total_size: byte_size(encoded_data),
             metadata_size: byte_size(encoded_data) - byte_size(remaining_data),
@@ -247,8 +627,6 @@ defmodule GorillaStream.Compression.Gorilla.Decoder do
     end
   end
 
-  def get_compression_info(_), do: {:error, "Invalid input - expected binary data"}
-
   @doc """
   Decodes and validates the result matches expected characteristics.
 
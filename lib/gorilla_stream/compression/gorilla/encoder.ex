@@ -21,6 +21,8 @@ defmodule GorillaStream.Compression.Gorilla.Encoder do
   }
 
   alias GorillaStream.Compression.Gorilla.NIF
+  alias GorillaStream.Compression.XXH3
+  alias GorillaStream.Rollup
 
   @doc """
   Returns true if the native NIF encoder is available.
@@ -36,43 +38,308 @@ defmodule GorillaStream.Compression.Gorilla.Encoder do
   Input data is assumed to be valid {timestamp, float} tuples.
 
   ## Parameters
-  - `data`: List of {timestamp, float} tuples
+  - `data`: List of {timestamp, float} tuples. A `nil` value marks a missing point:
+    its timestamp is kept and a run-length coded validity bitmap records the gap,
+    so it costs no value bits and leaves the XOR state alone. Native encoder only.
+  - `opts`: Keyword options:
+    - `:victoria_metrics`, `:is_counter`, `:scale_decimals` - VictoriaMetrics-style
+      preprocessing (default: off)
+    - `:algorithm` - `:gorilla` (default), `:chimp`, `:chimp128` or `:fpc`. FPC XORs
+      each value with the better of two table predictions, which suits trends and
+      counters. Native encoder only; the Elixir fallback writes Gorilla.
+    - `:chimp128_window` - Chimp128 reference window: 32, 64, 128 (default) or 256
+      previous values, recorded in the chunk flags
+    - `:value_type` - `:f64` (default) or `:f32`. Float32 series are rounded to single
+      precision and XOR-encoded as 32-bit words, roughly halving the value stream.
+      Native encoder only; the Elixir fallback always writes 64-bit words.
+    - `:mantissa_bits` - opt-in lossy mode: round values to this many explicit
+      mantissa bits (0-52) before XOR encoding, bounding the relative error by
+      `2^-(mantissa_bits + 1)`. The setting is recorded in the chunk flags.
+    - `:max_relative_error` - lossy mode expressed as an error bound, e.g. `1.0e-6`;
+      picks the fewest mantissa bits that honour it. Native encoder only, like
+      `:mantissa_bits`; the Elixir fallback stays lossless.
+    - `:checksum` - `:crc32` (default) or `:xxh3` to protect the payload with a 64-bit
+      xxHash3 in a version 2 header. A mismatching xxHash3 fails the decode, where a
+      CRC32 mismatch is only flagged.
+    - `:timestamp_codec` - `:delta_of_delta` (default), `:adaptive`, `:block` or `:auto`.
+      `:adaptive` keeps delta-of-delta but picks the bucket widths per chunk and records
+      them in the timestamp stream, for sub-second series; both decoders read it.
+      `:block` bit-packs the timestamp deltas in blocks of 128, which suits event-driven
+      series with jittery intervals, and needs the native decoder. `:auto` keeps
+      whichever of the three is smallest. Native encoder only.
+    - `:entropy` - `:none` (default) or `:rans`. Moves the prefix codes and length
+      fields into side streams coded with interleaved rANS, which pays off on long
+      chunks with skewed control codes; chunks where it does not are written plain.
+      Native encoder and decoder only.
+    - `:deterministic` - write 0 as the header creation time, so encoding the same
+      data with the same options always yields the same bytes (default: false)
+    - `:rollups` - window widths in timestamp units, e.g. `[300, 3600]`. Also builds
+      a `GorillaStream.Rollup` sidecar per width (min, max, sum, count and last
+      value per aligned window) from the input values, in the same native call,
+      and returns them alongside the chunk.
 
   ## Returns
   - `{:ok, encoded_data}`: When encoding is successful
+  - `{:ok, encoded_data, %{window => sidecar}}`: With `:rollups`
   - `{:error, reason}`: When encoding fails
   """
   # Unified encode with default opts; keeps encode/1 calls working via default argument
   def encode(data, opts \\ [])
-  def encode([], _opts), do: {:ok, <<>>}
+
+  def encode([], opts) do
+    case Keyword.get(opts, :rollups) do
+      nil -> {:ok, <<>>}
+      windows -> encode_with_rollups([], windows, opts)
+    end
+  end
 
   def encode(data, opts) when is_list(data) and length(data) > 0 do
-    case validate_input_data_fast(data) do
-      :ok ->
+    with :ok <- validate_input_data_fast(data),
+         :ok <- validate_options(opts) do
+      case Keyword.get(opts, :rollups) do
+        nil ->
+          if nif_available?() do
+            try do
+              NIF.nif_gorilla_encode(data, nif_options(opts))
+            rescue
+              _ -> encode_elixir(data, opts)
+            end
+          else
+            encode_elixir(data, opts)
+          end
+
+        windows ->
+          encode_with_rollups(data, windows, opts)
+      end
+    end
+  end
+
+  # Fallback clause for invalid input types
+  def encode(_, _opts),
+    do: {:error, "Invalid input data - expected list of {timestamp, float} tuples"}
+
+  defp encode_with_rollups(data, windows, opts) do
+    if is_list(windows) and Enum.all?(windows, &(is_integer(&1) and &1 > 0)) do
+      result =
         if nif_available?() do
           try do
-            opts_map =
-              %{}
-              |> maybe_put(:victoria_metrics, Keyword.get(opts, :victoria_metrics))
-              |> maybe_put(:is_counter, Keyword.get(opts, :is_counter))
-              |> maybe_put(:scale_decimals, Keyword.get(opts, :scale_decimals))
-
-            NIF.nif_gorilla_encode(data, opts_map)
+            NIF.nif_gorilla_encode_rollups(data, nif_options(opts), windows)
           rescue
-            _ -> encode_elixir(data, opts)
+            _ -> encode_rollups_elixir(data, windows, opts)
           end
         else
-          encode_elixir(data, opts)
+          encode_rollups_elixir(data, windows, opts)
         end
 
-      {:error, reason} ->
-        {:error, reason}
+      case result do
+        {:ok, {chunk, rollups}} -> {:ok, chunk, Map.new(Enum.zip(windows, rollups))}
+        error -> error
+      end
+    else
+      {:error, "Rollup windows must be positive integers"}
     end
   end
 
-  # Fallback clause for invalid input types
-  def encode(_, _opts),
-    do: {:error, "Invalid input data - expected list of {timestamp, float} tuples"}
+  defp encode_rollups_elixir(data, windows, opts) do
+    encoded = if data == [], do: {:ok, <<>>}, else: encode_elixir(data, opts)
+
+    with {:ok, chunk} <- encoded do
+      {:ok, {chunk, Enum.map(windows, &Rollup.build(data, &1))}}
+    end
+  end
+
+  @doc """
+  Encodes several series that share one list of timestamps, one chunk per series.
+
+  The native encoder writes the timestamp stream once and encodes the Gorilla values
+  of up to 16 series in lockstep, so a batch of series on one clock encodes faster
+  than calling `encode/2` on each. Every chunk decodes exactly like the `encode/2`
+  chunk of that series. Chimp, Chimp128 and `entropy: :rans` batches are encoded
+  one series at a time, as are series containing `nil`.
+
+  ## Parameters
+  - `timestamps`: List of integer timestamps shared by every series
+  - `series`: List of value lists, each with one number (or `nil`) per timestamp
+  - `opts`: The options of `encode/2`
+
+  ## Returns
+  - `{:ok, [encoded_data]}`: In input order
+  - `{:error, reason}`: When a series does not match the timestamps or encoding fails
+  """
+  def encode_batch(timestamps, series, opts \\ [])
+
+  def encode_batch(timestamps, series, opts) when is_list(timestamps) and is_list(series) do
+    n = length(timestamps)
+
+    with :ok <- validate_options(opts) do
+      cond do
+        not Enum.all?(series, &(is_list(&1) and length(&1) == n)) ->
+          {:error, "Invalid input data - every series must have one value per timestamp"}
+
+        nif_available?() ->
+          try do
+            NIF.nif_gorilla_encode_batch(timestamps, series, nif_options(opts))
+          rescue
+            _ -> encode_batch_elixir(timestamps, series, opts)
+          end
+
+        true ->
+          encode_batch_elixir(timestamps, series, opts)
+      end
+    end
+  end
+
+  def encode_batch(_, _, _opts),
+    do: {:error, "Invalid input data - expected a list of timestamps and a list of value lists"}
+
+  defp encode_batch_elixir(timestamps, series, opts) do
+    series
+    |> Enum.reduce_while({:ok, []}, fn values, {:ok, acc} ->
+      case encode(Enum.zip(timestamps, values), opts) do
+        {:ok, encoded} -> {:cont, {:ok, [encoded | acc]}}
+        {:error, reason} -> {:halt, {:error, reason}}
+      end
+    end)
+    |> case do
+      {:ok, acc} -> {:ok, Enum.reverse(acc)}
+      error -> error
+    end
+  end
+
+  @doc """
+  Re-encodes an encoded chunk with new encoder options, e.g. a different `:algorithm`.
+
+  The native encoder decodes into scratch columns and re-encodes in one call, without
+  building `{timestamp, value}` tuples. Options are those of `encode/2`; anything not
+  given takes the `encode/2` default rather than the source chunk's setting.
+
+  ## Returns
+  - `{:ok, encoded_data}`: When transcoding is successful
+  - `{:error, reason}`: When the input cannot be decoded or re-encoded
+  """
+  def transcode(encoded_data, opts \\ [])
+  def transcode(<<>>, _opts), do: {:ok, <<>>}
+
+  def transcode(encoded_data, opts) when is_binary(encoded_data) do
+    if nif_available?() do
+      try do
+        NIF.nif_gorilla_transcode(encoded_data, nif_options(opts))
+      rescue
+        _ -> transcode_elixir(encoded_data, opts)
+      end
+    else
+      transcode_elixir(encoded_data, opts)
+    end
+  end
+
+  def transcode(_, _opts), do: {:error, "Invalid input data"}
+
+  @doc """
+  Transcodes a list of encoded chunks in a single native call.
+
+  Accepts the options of `transcode/2` plus `:parallel` - `true` to spread the chunks
+  over one worker thread per CPU core, or an integer thread count.
+
+  ## Returns
+  - `{:ok, [encoded_data]}`: In input order
+  - `{:error, reason}`: When any chunk fails
+  """
+  def transcode_batch(chunks, opts \\ [])
+
+  def transcode_batch(chunks, opts) when is_list(chunks) do
+    if nif_available?() do
+      nif_opts = maybe_put(nif_options(opts), :parallel, Keyword.get(opts, :parallel))
+
+      try do
+        NIF.nif_gorilla_transcode_batch(chunks, nif_opts)
+      rescue
+        _ -> transcode_batch_elixir(chunks, opts)
+      end
+    else
+      transcode_batch_elixir(chunks, opts)
+    end
+  end
+
+  def transcode_batch(_, _opts), do: {:error, "Invalid input data - expected a list of binaries"}
+
+  defp transcode_elixir(encoded_data, opts) do
+    case GorillaStream.Compression.Gorilla.Decoder.decode(encoded_data) do
+      {:ok, []} -> {:ok, <<>>}
+      {:ok, points} -> encode(points, opts)
+      {:error, reason} -> {:error, reason}
+    end
+  end
+
+  defp transcode_batch_elixir(chunks, opts) do
+    chunks
+    |> Enum.reduce_while({:ok, []}, fn chunk, {:ok, acc} ->
+      case transcode(chunk, opts) do
+        {:ok, encoded} -> {:cont, {:ok, [encoded | acc]}}
+        {:error, reason} -> {:halt, {:error, reason}}
+      end
+    end)
+    |> case do
+      {:ok, acc} -> {:ok, Enum.reverse(acc)}
+      error -> error
+    end
+  end
+
+  @doc """
+  Returns the 128-bit content hash of an encoded chunk, for deduplicating stored
+  chunks.
+
+  The hash is XXH3-128 over everything in the chunk after the header creation time:
+  the flags, scale and checksum fields and the packed payload. Chunks of the same
+  data encoded with the same options therefore hash alike even when they were
+  written at different times. Bytes after the chunk are ignored.
+
+  ## Returns
+  - `{:ok, <<hash::binary-size(16)>>}`
+  - `{:error, reason}`: When the data does not start with a chunk header
+  """
+  def content_hash(encoded_data) when is_binary(encoded_data) do
+    if nif_available?() do
+      try do
+        NIF.nif_gorilla_content_hash(encoded_data)
+      rescue
+        _ -> content_hash_elixir(encoded_data)
+      end
+    else
+      content_hash_elixir(encoded_data)
+    end
+  end
+
+  # The content hash starts at the flags field, right after creation_time
+  @content_hash_offset 76
+
+  defp content_hash_elixir(
+         <<0, "GORILLA", _version::16, header_size::16, _count::32, compressed_size::32,
+           _::binary>> = encoded_data
+       )
+       when header_size >= 80 and byte_size(encoded_data) >= header_size + compressed_size do
+    size = header_size + compressed_size - @content_hash_offset
+    {:ok, <<XXH3.hash128(binary_part(encoded_data, @content_hash_offset, size))::128>>}
+  end
+
+  defp content_hash_elixir(_), do: {:error, "Invalid chunk header"}
+
+  @doc false
+  # Encoder options as the map the native encoder expects.
+  def nif_options(opts) do
+    %{}
+    |> maybe_put(:victoria_metrics, Keyword.get(opts, :victoria_metrics))
+    |> maybe_put(:is_counter, Keyword.get(opts, :is_counter))
+    |> maybe_put(:scale_decimals, Keyword.get(opts, :scale_decimals))
+    |> maybe_put(:algorithm, Keyword.get(opts, :algorithm))
+    |> maybe_put(:chimp128_window, Keyword.get(opts, :chimp128_window))
+    |> maybe_put(:value_type, Keyword.get(opts, :value_type))
+    |> maybe_put(:mantissa_bits, Keyword.get(opts, :mantissa_bits))
+    |> maybe_put(:max_relative_error, Keyword.get(opts, :max_relative_error))
+    |> maybe_put(:checksum, Keyword.get(opts, :checksum))
+    |> maybe_put(:timestamp_codec, Keyword.get(opts, :timestamp_codec))
+    |> maybe_put(:entropy, Keyword.get(opts, :entropy))
+    |> maybe_put(:deterministic, Keyword.get(opts, :deterministic))
+  end
 
   defp maybe_put(map, _key, nil), do: map
   defp maybe_put(map, key, value), do: Map.put(map, key, value)
@@ -107,7 +374,12 @@ defmodule GorillaStream.Compression.Gorilla.Encoder do
       {val_bits, val_meta} = ValueCompression.compress(pre_values)
       {packed_binary, pack_meta} = BitPacking.pack({ts_bits, ts_meta}, {val_bits, val_meta})
 
-      meta_with_vm = Map.put(pack_meta, :vm_meta, vm_meta)
+      meta_with_vm =
+        pack_meta
+        |> Map.put(:vm_meta, vm_meta)
+        |> Map.put(:checksum, Keyword.get(opts, :checksum, :crc32))
+        |> Map.put(:deterministic, Keyword.get(opts, :deterministic, false))
+
       final_data = Metadata.add_metadata(packed_binary, meta_with_vm)
       {:ok, final_data}
     rescue
@@ -123,6 +395,28 @@ defmodule GorillaStream.Compression.Gorilla.Encoder do
     end
   end
 
+  # The native encoder clamps or ignores out-of-range option values and its
+  # errors fall back to the Elixir encoder, so bad options are caught here.
+  defp validate_options(opts) do
+    mantissa_bits = Keyword.get(opts, :mantissa_bits)
+    max_error = Keyword.get(opts, :max_relative_error)
+    window = Keyword.get(opts, :chimp128_window)
+
+    cond do
+      window != nil and window not in [32, 64, 128, 256] ->
+        {:error, "chimp128_window must be 32, 64, 128 or 256"}
+
+      mantissa_bits != nil and mantissa_bits not in 0..52 ->
+        {:error, "mantissa_bits must be an integer from 0 to 52"}
+
+      max_error != nil and not (is_float(max_error) and max_error > 0) ->
+        {:error, "max_relative_error must be a positive float"}
+
+      true ->
+        :ok
+    end
+  end
+
   # Fast validation that checks input format without full enumeration
   defp validate_input_data_fast(data) do
     # Check first item and a sample to catch common errors quickly
@@ -136,7 +430,7 @@ defmodule GorillaStream.Compression.Gorilla.Encoder do
       [{timestamp, _} | _] when not is_integer(timestamp) ->
         {:error, "Invalid data format: all items must be {timestamp, float} tuples"}
 
-      [{_, value} | _] when not is_number(value) ->
+      [{_, value} | _] when not is_number(value) and not is_nil(value) ->
         {:error, "Invalid data format: all items must be {timestamp, float} tuples"}
 
       _ ->
@@ -313,9 +607,9 @@ defmodule GorillaStream.Compression.Gorilla.Encoder do
   defp estimate_first_delta_bits(delta) do
     cond do
       delta == 0 -> 1
-      delta >= -63 and delta <= 64 -> 9
-      delta >= -255 and delta <= 256 -> 12
-      delta >= -2047 and delta <= 2048 -> 16
+      delta >= -64 and delta <= 63 -> 9
+      delta >= -256 and delta <= 255 -> 12
+      delta >= -2048 and delta <= 2047 -> 16
       true -> 36
     end
   end
@@ -330,9 +624,9 @@ defmodule GorillaStream.Compression.Gorilla.Encoder do
         Enum.map(dods, fn dod ->
           cond do
             dod == 0 -> 1
-            dod >= -63 and dod <= 64 -> 9
-            dod >= -255 and dod <= 256 -> 12
-            dod >= -2047 and dod <= 2048 -> 16
+            dod >= -64 and dod <= 63 -> 9
+            dod >= -256 and dod <= 255 -> 12
+            dod >= -2048 and dod <= 2047 -> 16
             true -> 36
           end
         end)
@@ -14,5 +14,43 @@ defmodule GorillaStream.Compression.Gorilla.NIF do
   end
 
   def nif_gorilla_encode(_data, _opts), do: :erlang.nif_error(:not_loaded)
+  def nif_gorilla_encode_batch(_timestamps, _series, _opts), do: :erlang.nif_error(:not_loaded)
   def nif_gorilla_decode(_data), do: :erlang.nif_error(:not_loaded)
+  def nif_gorilla_decode_timestamps(_data), do: :erlang.nif_error(:not_loaded)
+  def nif_gorilla_decode_values(_data), do: :erlang.nif_error(:not_loaded)
+  def nif_gorilla_decode_columns(_data, _opts), do: :erlang.nif_error(:not_loaded)
+  def nif_gorilla_decode_columns_batch(_chunks, _opts), do: :erlang.nif_error(:not_loaded)
+  def nif_gorilla_info(_data, _opts), do: :erlang.nif_error(:not_loaded)
+  def nif_gorilla_info_batch(_chunks, _opts), do: :erlang.nif_error(:not_loaded)
+  def nif_gorilla_encode_rollups(_data, _opts, _windows), do: :erlang.nif_error(:not_loaded)
+  def nif_gorilla_content_hash(_data), do: :erlang.nif_error(:not_loaded)
+  def nif_gorilla_scan_chunks(_data, _opts), do: :erlang.nif_error(:not_loaded)
+  def nif_gorilla_decode_frames(_data), do: :erlang.nif_error(:not_loaded)
+  def nif_gorilla_transcode(_data, _opts), do: :erlang.nif_error(:not_loaded)
+  def nif_gorilla_transcode_batch(_chunks, _opts), do: :erlang.nif_error(:not_loaded)
+  def nif_gorilla_to_arrow(_chunks, _opts), do: :erlang.nif_error(:not_loaded)
+  def nif_gorilla_from_arrow(_data, _opts), do: :erlang.nif_error(:not_loaded)
+  def nif_gorilla_to_prometheus(_data, _opts), do: :erlang.nif_error(:not_loaded)
+  def nif_gorilla_from_prometheus(_chunks, _opts), do: :erlang.nif_error(:not_loaded)
+  def nif_gorilla_ingest_line_protocol(_text, _opts), do: :erlang.nif_error(:not_loaded)
+  def nif_gorilla_ingest_csv(_text, _opts), do: :erlang.nif_error(:not_loaded)
+  def nif_gorilla_ingest_remote_write(_body, _opts), do: :erlang.nif_error(:not_loaded)
+  def nif_build_info, do: :erlang.nif_error(:not_loaded)
+
+  # Helpers for the native-only modules (Arrow, Prometheus, Ingest); `feature`
+  # names the operation in their error messages.
+
+  def ensure_loaded(feature) do
+    if GorillaStream.Compression.Gorilla.Encoder.nif_available?() do
+      :ok
+    else
+      {:error, "#{feature} requires the native NIF, which is not loaded"}
+    end
+  end
+
+  def call(feature, fun) do
+    fun.()
+  rescue
+    e -> {:error, "#{feature} failed: #{Exception.message(e)}"}
+  end
 end
@@ -0,0 +1,326 @@
+defmodule GorillaStream.Compression.XXH3 do
+  @moduledoc """
+  XXH3 64- and 128-bit hashes (default secret, seed 0) in pure Elixir.
+
+  Chunks encoded with `checksum: :xxh3` carry the 64-bit hash of the packed payload
+  in a version 2 header. The native decoder verifies it in C; this module lets the
+  Elixir decoder do the same without the NIF. The 128-bit hash backs chunk content
+  hashes. Output matches the reference `XXH3_64bits/1` and `XXH3_128bits/1`.
+  """
+
+  import Bitwise
+
+  @mask64 0xFFFFFFFFFFFFFFFF
+
+  @prime32_1 0x9E3779B1
+  @prime32_2 0x85EBCA77
+  @prime32_3 0xC2B2AE3D
+  @prime64_1 0x9E3779B185EBCA87
+  @prime64_2 0xC2B2AE3D27D4EB4F
+  @prime64_3 0x165667B19E3779F9
+  @prime64_4 0x85EBCA77C2B2AE63
+  @prime64_5 0x27D4EB2F165667C5
+  @prime_mx1 0x165667919E3779F9
+  @prime_mx2 0x9FB21C651E98DF25
+
+  @secret <<
+    0xB8, 0xFE, 0x6C, 0x39, 0x23, 0xA4, 0x4B, 0xBE, 0x7C, 0x01, 0x81, 0x2C,
+    0xF7, 0x21, 0xAD, 0x1C, 0xDE, 0xD4, 0x6D, 0xE9, 0x83, 0x90, 0x97, 0xDB,
+    0x72, 0x40, 0xA4, 0xA4, 0xB7, 0xB3, 0x67, 0x1F, 0xCB, 0x79, 0xE6, 0x4E,
+    0xCC, 0xC0, 0xE5, 0x78, 0x82, 0x5A, 0xD0, 0x7D, 0xCC, 0xFF, 0x72, 0x21,
+    0xB8, 0x08, 0x46, 0x74, 0xF7, 0x43, 0x24, 0x8E, 0xE0, 0x35, 0x90, 0xE6,
+    0x81, 0x3A, 0x26, 0x4C, 0x3C, 0x28, 0x52, 0xBB, 0x91, 0xC3, 0x00, 0xCB,
+    0x88, 0xD0, 0x65, 0x8B, 0x1B, 0x53, 0x2E, 0xA3, 0x71, 0x64, 0x48, 0x97,
+    0xA2, 0x0D, 0xF9, 0x4E, 0x38, 0x19, 0xEF, 0x46, 0xA9, 0xDE, 0xAC, 0xD8,
+    0xA8, 0xFA, 0x76, 0x3F, 0xE3, 0x9C, 0x34, 0x3F, 0xF9, 0xDC, 0xBB, 0xC7,
+    0xC7, 0x0B, 0x4F, 0x1D, 0x8A, 0x51, 0xE0, 0x4B, 0xCD, 0xB4, 0x59, 0x31,
+    0xC8, 0x9F, 0x7E, 0xC9, 0xD9, 0x78, 0x73, 0x64, 0xEA, 0xC5, 0xAC, 0x83,
+    0x34, 0xD3, 0xEB, 0xC3, 0xC5, 0x81, 0xA0, 0xFF, 0xFA, 0x13, 0x63, 0xEB,
+    0x17, 0x0D, 0xDD, 0x51, 0xB7, 0xF0, 0xDA, 0x49, 0xD3, 0x16, 0x55, 0x26,
+    0x29, 0xD4, 0x68, 0x9E, 0x2B, 0x16, 0xBE, 0x58, 0x7D, 0x47, 0xA1, 0xFC,
+    0x8F, 0xF8, 0xB8, 0xD1, 0x7A, 0xD0, 0x31, 0xCE, 0x45, 0xCB, 0x3A, 0x8F,
+    0x95, 0x16, 0x04, 0x28, 0xAF, 0xD7, 0xFB, 0xCA, 0xBB, 0x4B, 0x40, 0x7E
+  >>
+
+  # 16 stripes of 64 bytes per block, each stripe consuming 8 secret bytes
+  @stripes_per_block div(byte_size(@secret) - 64, 8)
+  @block_len 64 * @stripes_per_block
+
+  @doc """
+  Returns the 64-bit XXH3 hash of `data` as a non-negative integer.
+  """
+  def hash64(data) when is_binary(data), do: hash(data, byte_size(data))
+
+  defp hash(_data, 0), do: xxh64_avalanche(bxor(secret64(56), secret64(64)))
+
+  defp hash(data, len) when len <= 3 do
+    combined =
+      :binary.at(data, 0) <<< 16 ||| :binary.at(data, len >>> 1) <<< 24 |||
+        :binary.at(data, len - 1) ||| len <<< 8
+
+    xxh64_avalanche(bxor(combined, bxor(secret32(0), secret32(4))))
+  end
+
+  defp hash(data, len) when len <= 8 do
+    input64 = read32(data, len - 4) + (read32(data, 0) <<< 32)
+    rrmxmx(bxor(input64, bxor(secret64(8), secret64(16))), len)
+  end
+
+  defp hash(data, len) when len <= 16 do
+    lo = bxor(read64(data, 0), bxor(secret64(24), secret64(32)))
+    hi = bxor(read64(data, len - 8), bxor(secret64(40), secret64(48)))
+    avalanche(len + swap64(lo) + hi + mul128_fold64(lo, hi))
+  end
+
+  defp hash(data, len) when len <= 128 do
+    Enum.reduce(0..div(len - 1, 32), len * @prime64_1, fn i, acc ->
+      acc + mix16(data, 16 * i, 32 * i) + mix16(data, len - 16 * (i + 1), 32 * i + 16)
+    end)
+    |> avalanche()
+  end
+
+  defp hash(data, len) when len <= 240 do
+    acc =
+      Enum.reduce(0..7, len * @prime64_1, fn i, acc -> acc + mix16(data, 16 * i, 16 * i) end)
+      |> avalanche()
+
+    acc_end =
+      Enum.reduce(8..(div(len, 16) - 1)//1, mix16(data, len - 16, 136 - 17), fn i, acc_end ->
+        acc_end + mix16(data, 16 * i, 16 * (i - 8) + 3)
+      end)
+
+    avalanche(acc + acc_end)
+  end
+
+  defp hash(data, len), do: merge_accs(long_accs(data, len), 11, len * @prime64_1)
+
+  @doc """
+  Returns the 128-bit XXH3 hash of `data` as a non-negative integer, high half
+  first, so `<<hash::128>>` is the canonical big-endian form.
+  """
+  def hash128(data) when is_binary(data) do
+    {lo, hi} = hash128(data, byte_size(data))
+    hi <<< 64 ||| lo
+  end
+
+  defp hash128(_data, 0) do
+    {xxh64_avalanche(bxor(secret64(64), secret64(72))),
+     xxh64_avalanche(bxor(secret64(80), secret64(88)))}
+  end
+
+  defp hash128(data, len) when len <= 3 do
+    combined_lo =
+      :binary.at(data, 0) <<< 16 ||| :binary.at(data, len >>> 1) <<< 24 |||
+        :binary.at(data, len - 1) ||| len <<< 8
+
+    <<swapped::little-32>> = <<combined_lo::32>>
+    combined_hi = (swapped <<< 13 ||| swapped >>> 19) &&& 0xFFFFFFFF
+
+    {xxh64_avalanche(bxor(combined_lo, bxor(secret32(0), secret32(4)))),
+     xxh64_avalanche(bxor(combined_hi, bxor(secret32(8), secret32(12))))}
+  end
+
+  defp hash128(data, len) when len <= 8 do
+    input64 = read32(data, 0) + (read32(data, len - 4) <<< 32)
+    keyed = bxor(input64, bxor(secret64(16), secret64(24)))
+    {lo, hi} = mul128(keyed, @prime64_1 + (len <<< 2))
+
+    hi = hi + (lo <<< 1) &&& @mask64
+    lo = bxor(lo, hi >>> 3)
+    lo = bxor(lo, lo >>> 35) * @prime_mx2 &&& @mask64
+    {bxor(lo, lo >>> 28), avalanche(hi)}
+  end
+
+  defp hash128(data, len) when len <= 16 do
+    input_lo = read64(data, 0)
+    input_hi = read64(data, len - 8)
+    bitflip_lo = bxor(secret64(32), secret64(40))
+    {lo, hi} = mul128(bxor(input_lo, bxor(input_hi, bitflip_lo)), @prime64_1)
+
+    lo = lo + ((len - 1) <<< 54) &&& @mask64
+    input_hi = bxor(input_hi, bxor(secret64(48), secret64(56)))
+    hi = hi + input_hi + (input_hi &&& 0xFFFFFFFF) * (@prime32_2 - 1) &&& @mask64
+    lo = bxor(lo, swap64(hi))
+
+    {h_lo, h_hi} = mul128(lo, @prime64_2)
+    {avalanche(h_lo), avalanche(h_hi + hi * @prime64_2)}
+  end
+
+  defp hash128(data, len) when len <= 128 do
+    div(len - 1, 32)..0//-1
+    |> Enum.reduce({len * @prime64_1, 0}, fn i, acc ->
+      mix32(acc, data, 16 * i, len - 16 * (i + 1), 32 * i)
+    end)
+    |> finish128(len)
+  end
+
+  defp hash128(data, len) when len <= 240 do
+    {lo, hi} =
+      Enum.reduce(0..3, {len * @prime64_1, 0}, fn i, acc ->
+        mix32(acc, data, 32 * i, 32 * i + 16, 32 * i)
+      end)
+
+    4..(div(len, 32) - 1)//1
+    |> Enum.reduce({avalanche(lo), avalanche(hi)}, fn i, acc ->
+      mix32(acc, data, 32 * i, 32 * i + 16, 3 + 32 * (i - 4))
+    end)
+    |> mix32(data, len - 16, len - 32, 136 - 17 - 16)
+    |> finish128(len)
+  end
+
+  defp hash128(data, len) do
+    accs = long_accs(data, len)
+
+    {merge_accs(accs, 11, len * @prime64_1),
+     merge_accs(accs, byte_size(@secret) - 64 - 11, bnot(len * @prime64_2) &&& @mask64)}
+  end
+
+  defp mix32({lo, hi}, data, offset1, offset2, secret_offset) do
+    lo = lo + mix16(data, offset1, secret_offset) &&& @mask64
+    lo = bxor(lo, read64(data, offset2) + read64(data, offset2 + 8) &&& @mask64)
+    hi = hi + mix16(data, offset2, secret_offset + 16) &&& @mask64
+    {lo, bxor(hi, read64(data, offset1) + read64(data, offset1 + 8) &&& @mask64)}
+  end
+
+  defp finish128({lo, hi}, len) do
+    {avalanche(lo + hi),
+     0 - avalanche(lo * @prime64_1 + hi * @prime64_4 + len * @prime64_2) &&& @mask64}
+  end
+
+  # Accumulators of the long-input loop, shared by both hash widths
+  defp long_accs(data, len) do
+    blocks = div(len - 1, @block_len)
+
+    acc =
+      Enum.reduce(0..(blocks - 1)//1, init_acc(), fn n, acc ->
+        acc
+        |> accumulate(data, n * @block_len, @stripes_per_block)
+        |> scramble()
+      end)
+
+    # Last partial block, then the final (possibly overlapping) stripe
+    stripes = div(len - 1 - blocks * @block_len, 64)
+
+    acc
+    |> accumulate(data, blocks * @block_len, stripes)
+    |> accumulate_512(data, len - 64, byte_size(@secret) - 64 - 7)
+  end
+
+  defp merge_accs([a0, a1, a2, a3, a4, a5, a6, a7], secret_offset, start) do
+    (start + mix_accs(a0, a1, secret_offset) + mix_accs(a2, a3, secret_offset + 16) +
+       mix_accs(a4, a5, secret_offset + 32) + mix_accs(a6, a7, secret_offset + 48))
+    |> avalanche()
+  end
+
+  defp init_acc do
+    [
+      @prime32_3,
+      @prime64_1,
+      @prime64_2,
+      @prime64_3,
+      @prime64_4,
+      @prime32_2,
+      @prime64_5,
+      @prime32_1
+    ]
+  end
+
+  defp accumulate(acc, data, offset, stripes) do
+    Enum.reduce(0..(stripes - 1)//1, acc, fn s, acc ->
+      accumulate_512(acc, data, offset + 64 * s, 8 * s)
+    end)
+  end
+
+  # Each lane adds its neighbour's input word and the 32x32 product of its keyed word
+  defp accumulate_512([a0, a1, a2, a3, a4, a5, a6, a7], data, offset, secret_offset) do
+    <<_::binary-size(offset), d0::little-64, d1::little-64, d2::little-64, d3::little-64,
+      d4::little-64, d5::little-64, d6::little-64, d7::little-64, _::binary>> = data
+
+    <<_::binary-size(secret_offset), s0::little-64, s1::little-64, s2::little-64,
+      s3::little-64, s4::little-64, s5::little-64, s6::little-64, s7::little-64,
+      _::binary>> = @secret
+
+    [
+      lane(a0, d1, bxor(d0, s0)),
+      lane(a1, d0, bxor(d1, s1)),
+      lane(a2, d3, bxor(d2, s2)),
+      lane(a3, d2, bxor(d3, s3)),
+      lane(a4, d5, bxor(d4, s4)),
+      lane(a5, d4, bxor(d5, s5)),
+      lane(a6, d7, bxor(d6, s6)),
+      lane(a7, d6, bxor(d7, s7))
+    ]
+  end
+
+  defp lane(acc, neighbour, key) do
+    acc + neighbour + (key &&& 0xFFFFFFFF) * (key >>> 32) &&& @mask64
+  end
+
+  defp scramble(acc) do
+    acc
+    |> Enum.with_index()
+    |> Enum.map(fn {a, i} ->
+      a = bxor(a, a >>> 47)
+      bxor(a, secret64(byte_size(@secret) - 64 + 8 * i)) * @prime32_1 &&& @mask64
+    end)
+  end
+
+  defp mix_accs(a, b, secret_offset) do
+    mul128_fold64(bxor(a, secret64(secret_offset)), bxor(b, secret64(secret_offset + 8)))
+  end
+
+  defp mix16(data, offset, secret_offset) do
+    mul128_fold64(
+      bxor(read64(data, offset), secret64(secret_offset)),
+      bxor(read64(data, offset + 8), secret64(secret_offset + 8))
+    )
+  end
+
+  defp mul128(a, b) do
+    product = a * b
+    {product &&& @mask64, product >>> 64}
+  end
+
+  defp mul128_fold64(a, b) do
+    product = a * b
+    bxor(product &&& @mask64, product >>> 64)
+  end
+
+  defp xxh64_avalanche(h) do
+    h = bxor(h, h >>> 33) * @prime64_2 &&& @mask64
+    h = bxor(h, h >>> 29) * @prime64_3 &&& @mask64
+    bxor(h, h >>> 32)
+  end
+
+  defp avalanche(h) do
+    h = h &&& @mask64
+    h = bxor(h, h >>> 37) * @prime_mx1 &&& @mask64
+    bxor(h, h >>> 32)
+  end
+
+  defp rrmxmx(h, len) do
+    h = bxor(h, bxor(rotl64(h, 49), rotl64(h, 24))) * @prime_mx2 &&& @mask64
+    h = bxor(h, (h >>> 35) + len) * @prime_mx2 &&& @mask64
+    bxor(h, h >>> 28)
+  end
+
+  defp rotl64(v, r), do: (v <<< r ||| v >>> (64 - r)) &&& @mask64
+
+  defp swap64(v) do
+    <<swapped::little-64>> = <<v::64>>
+    swapped
+  end
+
+  defp read64(data, offset) do
+    <<_::binary-size(offset), v::little-64, _::binary>> = data
+    v
+  end
+
+  defp read32(data, offset) do
+    <<_::binary-size(offset), v::little-32, _::binary>> = data
+    v
+  end
+
+  defp secret64(offset), do: read64(@secret, offset)
+  defp secret32(offset), do: read32(@secret, offset)
+end
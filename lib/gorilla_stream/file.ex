@@ -14,6 +14,12 @@ defmodule GorillaStream.File do
   ## Options
   - `:metadata` - Additional metadata to store with the compressed data
   - `:validate` - Whether to validate the data after compression (default: false)
+  - `:deterministic` - Fixed header creation time, so equal data gives an identical
+    chunk (default: false)
+
+  The file metadata records the chunk's `:content_hash` (see
+  `GorillaStream.Compression.Gorilla.Encoder.content_hash/1`), which
+  `get_file_info/1` returns, so stored files can be deduplicated without decoding.
 
   ## Examples
 
@@ -25,13 +31,21 @@ defmodule GorillaStream.File do
     metadata = Keyword.get(opts, :metadata, %{})
     validate = Keyword.get(opts, :validate, false)
 
-    case Encoder.encode(data) do
+    case Encoder.encode(data, Keyword.take(opts, [:deterministic])) do
       {:ok, compressed} ->
+        # Empty data encodes to an empty binary, which has no hash
+        content_hash =
+          case Encoder.content_hash(compressed) do
+            {:ok, hash} -> hash
+            {:error, _} -> nil
+          end
+
         # Create file format with metadata
         file_metadata = %{
           version: "1.0",
           compressed_at: DateTime.utc_now(),
           original_points: length(data),
+          content_hash: content_hash,
           user_metadata: metadata
         }
 
@@ -0,0 +1,176 @@
+defmodule GorillaStream.Frame do
+  @moduledoc """
+  Length-prefixed framing for shipping chunks between nodes or over sockets.
+
+  Each frame carries one chunk and, optionally, its metadata (any term, stored in
+  the external term format). All integers are big-endian:
+
+      magic      : 32   "GSF1"
+      flags      : 32   bit 0 = metadata present
+      chunk_len  : 32
+      [meta_len] : 32   (flag bit 0)
+      [metadata] : meta_len bytes
+      chunk      : chunk_len bytes
+
+  Frames are written as iodata, so the chunk itself is never copied. The native
+  reader returns chunks as sub-binaries of the received binary, again without
+  copying, and hands back any trailing partial frame so a socket reader can
+  prepend it to the next packet.
+
+  ## Examples
+
+      data
+      |> GorillaStream.Stream.compress_stream()
+      |> GorillaStream.Frame.encode_stream()
+      |> Enum.each(&:gen_tcp.send(socket, &1))
+
+      packets
+      |> GorillaStream.Frame.decode_stream()
+      |> GorillaStream.Stream.decompress_stream()
+  """
+
+  alias GorillaStream.Compression.Gorilla.{Encoder, NIF}
+
+  @magic "GSF1"
+  @flag_metadata 0x1
+
+  @doc """
+  Frames one chunk, with optional metadata, as iodata.
+  """
+  def encode(chunk, metadata \\ nil)
+
+  def encode(chunk, nil) when is_binary(chunk) do
+    [<<@magic, 0::32, byte_size(chunk)::32>>, chunk]
+  end
+
+  def encode(chunk, metadata) when is_binary(chunk) do
+    meta = :erlang.term_to_binary(metadata)
+    [<<@magic, @flag_metadata::32, byte_size(chunk)::32, byte_size(meta)::32>>, meta, chunk]
+  end
+
+  @doc """
+  Frames the `{:ok, chunk, metadata}` tuples of `GorillaStream.Stream.compress_stream/2`
+  (or `{:ok, chunk}`) as iodata. Errors pass through unchanged.
+  """
+  def encode_stream(stream) do
+    Stream.map(stream, fn
+      {:ok, chunk, metadata} -> encode(chunk, metadata)
+      {:ok, chunk} -> encode(chunk)
+      error -> error
+    end)
+  end
+
+  @doc """
+  Reads every complete frame at the start of a binary.
+
+  ## Returns
+  - `{:ok, [{chunk, metadata}], rest}` - `metadata` is `nil` for frames written
+    without it; `rest` holds the bytes of a trailing partial frame
+  - `{:error, reason}` - When the data is not a frame stream
+  """
+  def decode(data) when is_binary(data) do
+    result =
+      if Encoder.nif_available?() do
+        try do
+          NIF.nif_gorilla_decode_frames(data)
+        rescue
+          _ -> decode_elixir(data, [])
+        end
+      else
+        decode_elixir(data, [])
+      end
+
+    with {:ok, {frames, rest}} <- result,
+         {:ok, frames} <- decode_metadata(frames, []) do
+      {:ok, frames, rest}
+    end
+  end
+
+  def decode(_), do: {:error, "Invalid input - expected binary data"}
+
+  @doc """
+  Turns a stream of received binaries (e.g. socket packets) into
+  `{:ok, chunk, metadata}` tuples that `GorillaStream.Stream.decompress_stream/2`
+  accepts. Frames may span packets. Framing errors are emitted as `{:error, reason}`
+  and end the stream.
+  """
+  def decode_stream(packets) do
+    # Packets of a partial frame are held as a list, with the byte count the
+    # frame needs, and joined once it is complete, so a frame spread over many
+    # packets is copied once rather than on every packet
+    Stream.transform(packets, {[], 0, 0}, fn
+      _packet, :halt ->
+        {:halt, :halt}
+
+      packet, {[], 0, _needed} ->
+        decode_buffered(packet)
+
+      packet, {pending, size, needed} when size + byte_size(packet) < needed ->
+        {[], {[packet | pending], size + byte_size(packet), needed}}
+
+      packet, {pending, _size, _needed} ->
+        decode_buffered(IO.iodata_to_binary(Enum.reverse([packet | pending])))
+    end)
+  end
+
+  defp decode_buffered(data) do
+    case decode(data) do
+      {:ok, frames, rest} ->
+        frames = Enum.map(frames, fn {chunk, meta} -> {:ok, chunk, meta || %{}} end)
+
+        if rest == <<>>,
+          do: {frames, {[], 0, 0}},
+          else: {frames, {[rest], byte_size(rest), frame_size(rest)}}
+
+      error ->
+        {[error], :halt}
+    end
+  end
+
+  # Bytes needed to complete the frame `data` starts, or to read its header
+  defp frame_size(<<@magic, @flag_metadata::32, chunk_len::32, meta_len::32, _::binary>>),
+    do: 16 + meta_len + chunk_len
+
+  defp frame_size(<<@magic, @flag_metadata::32, _::binary>>), do: 16
+  defp frame_size(<<@magic, 0::32, chunk_len::32, _::binary>>), do: 12 + chunk_len
+  defp frame_size(_data), do: 12
+
+  defp decode_metadata([], acc), do: {:ok, Enum.reverse(acc)}
+
+  defp decode_metadata([{chunk, meta} | frames], acc) do
+    case metadata_term(meta) do
+      {:ok, term} -> decode_metadata(frames, [{chunk, term} | acc])
+      error -> error
+    end
+  end
+
+  defp metadata_term(nil), do: {:ok, nil}
+
+  defp metadata_term(meta) do
+    {:ok, :erlang.binary_to_term(meta, [:safe])}
+  rescue
+    ArgumentError -> {:error, "Invalid frame metadata"}
+  end
+
+  defp decode_elixir(
+         <<@magic, @flag_metadata::32, chunk_len::32, meta_len::32,
+           meta::binary-size(meta_len), chunk::binary-size(chunk_len), rest::binary>>,
+         acc
+       ),
+       do: decode_elixir(rest, [{chunk, meta} | acc])
+
+  defp decode_elixir(
+         <<@magic, 0::32, chunk_len::32, chunk::binary-size(chunk_len), rest::binary>>,
+         acc
+       ),
+       do: decode_elixir(rest, [{chunk, nil} | acc])
+
+  defp decode_elixir(<<@magic, flags::32, _::binary>>, _acc)
+       when flags not in [0, @flag_metadata],
+       do: {:error, "Unsupported frame flags"}
+
+  defp decode_elixir(<<magic::binary-size(4), _::binary>>, _acc) when magic != @magic,
+    do: {:error, "Invalid frame magic"}
+
+  defp decode_elixir(rest, acc), do: {:ok, {Enum.reverse(acc), rest}}
+end
@@ -0,0 +1,133 @@
+defmodule GorillaStream.Ingest do
+  @moduledoc """
+  Native ingest of InfluxDB line protocol, CSV and Prometheus remote_write payloads
+  into encoded chunks.
+
+  Input is parsed directly into per-series timestamp/value columns and each series
+  is encoded in the same native call, so no `{timestamp, value}` tuples are built on
+  the way in. For text formats, series keys and field names in the result are
+  sub-binaries of the input.
+
+  Results list series in order of first appearance; every `chunk` is the output of
+  `GorillaStream.Compression.Gorilla.Encoder.encode/2`. All functions require the NIF.
+
+  A series whose timestamp gaps overflow the 32-bit delta-of-delta bucket, such as
+  nanosecond line protocol more than about 2 s apart or remote_write samples more
+  than about 24 days apart, is encoded with `timestamp_codec: :adaptive` instead.
+
+  ## Examples
+
+      text = "cpu,host=a usage=1.5,idle=98i 1700000000\\ncpu,host=a usage=1.75,idle=97i 1700000015\\n"
+
+      {:ok, [{"cpu,host=a", "usage", usage}, {"cpu,host=a", "idle", idle}]} =
+        GorillaStream.Ingest.line_protocol(text)
+  """
+
+  alias GorillaStream.Compression.Gorilla.{Encoder, NIF}
+
+  @feature "Native ingest"
+
+  @doc """
+  Parses InfluxDB line protocol into one chunk per series key and field.
+
+  The series key is the measurement and tag set exactly as written, so tags should
+  appear in a consistent order (InfluxDB clients sort them). Integer (`1i`),
+  unsigned (`1u`) and boolean fields are stored as floats; string fields are
+  skipped. Every line needs a timestamp, which is stored as-is. Comment lines
+  (`#`) and blank lines are ignored.
+
+  ## Options
+
+  Encoder options as for `GorillaStream.Compression.Gorilla.Encoder.encode/2`
+  (`:algorithm`, `:victoria_metrics`, `:is_counter`, `:scale_decimals`), applied to
+  every series.
+
+  ## Returns
+
+  - `{:ok, [{series_key, field, chunk}]}` on success
+  - `{:error, reason}` on failure, naming the offending line
+  """
+  def line_protocol(text, opts \\ [])
+
+  def line_protocol(text, opts) when is_binary(text) do
+    with :ok <- NIF.ensure_loaded(@feature) do
+      nif_opts = Encoder.nif_options(opts)
+      NIF.call(@feature, fn -> NIF.nif_gorilla_ingest_line_protocol(text, nif_opts) end)
+    end
+  end
+
+  def line_protocol(_, _opts), do: {:error, "Invalid input data"}
+
+  @doc """
+  Parses CSV into one chunk per series column value and value column.
+
+  Columns are referred to by header name or by zero-based index. Empty or
+  non-numeric value cells are skipped; timestamps must be integers. Quoted cells
+  may contain the delimiter but not line breaks.
+
+  ## Options
+
+  - `:timestamp_column` - timestamp column (default: the first column)
+  - `:value_columns` - list of value columns (default: every other column)
+  - `:series_column` - column whose value names the series (default: none, series is `""`)
+  - `:delimiter` - single-byte delimiter (default `","`)
+  - `:header` - whether the first line is a header (default `true`); without one the
+    `field` in the result is the column index
+  - Encoder options as for `line_protocol/2`
+
+  ## Returns
+
+  - `{:ok, [{series, field, chunk}]}` on success
+  - `{:error, reason}` on failure, naming the offending line
+  """
+  def csv(text, opts \\ [])
+
+  def csv(text, opts) when is_binary(text) do
+    with :ok <- NIF.ensure_loaded(@feature) do
+      nif_opts =
+        opts
+        |> Keyword.take([:timestamp_column, :value_columns, :series_column, :delimiter, :header])
+        |> Map.new()
+        |> Map.merge(Encoder.nif_options(opts))
+
+      NIF.call(@feature, fn -> NIF.nif_gorilla_ingest_csv(text, nif_opts) end)
+    end
+  end
+
+  def csv(_, _opts), do: {:error, "Invalid input data"}
+
+  @doc """
+  Decodes a Prometheus remote_write body into one chunk per label set.
+
+  The body is a snappy-compressed (block format) `WriteRequest` protobuf, as sent
+  by Prometheus. Timeseries entries with the same labels, in any order, are merged
+  into one chunk; labels come back sorted by name. Exemplars, metadata and native
+  histograms are ignored.
+
+  ## Options
+
+  - `:snappy` - whether the body is snappy-compressed (default `true`)
+  - `:max_size` - largest accepted decompressed size in bytes (default 128 MiB)
+  - Encoder options as for `line_protocol/2`
+
+  ## Returns
+
+  - `{:ok, [{[{name, value}], chunk}]}` on success
+  - `{:error, reason}` on failure
+  """
+  def remote_write(body, opts \\ [])
+
+  def remote_write(body, opts) when is_binary(body) do
+    with :ok <- NIF.ensure_loaded(@feature) do
+      nif_opts =
+        opts
+        |> Keyword.take([:snappy, :max_size])
+        |> Map.new()
+        |> Map.merge(Encoder.nif_options(opts))
+
+      NIF.call(@feature, fn -> NIF.nif_gorilla_ingest_remote_write(body, nif_opts) end)
+    end
+  end
+
+  def remote_write(_, _opts), do: {:error, "Invalid input data"}
+end
@@ -0,0 +1,76 @@
+defmodule GorillaStream.Prometheus do
+  @moduledoc """
+  Lossless transcoding between Gorilla chunks and Prometheus TSDB XOR chunks.
+
+  Prometheus stores samples in a close Gorilla variant with its own framing
+  (16-bit sample count, varint first timestamp and delta) and different
+  delta-of-delta buckets. Both directions run natively over decoded columns, so
+  migrating or federating data never builds per-point terms.
+
+  XOR chunks here are the raw chunk bytes (`chunkenc.XORChunk.Bytes()`), without the
+  encoding byte or length prefix of the chunk segment file. Values, including
+  NaN staleness markers, are preserved bit for bit.
+
+  ## Examples
+
+      {:ok, xor_chunks} = GorillaStream.Prometheus.to_xor_chunks(chunk)
+      {:ok, chunk} = GorillaStream.Prometheus.from_xor_chunks(xor_chunks)
+  """
+
+  alias GorillaStream.Compression.Container
+  alias GorillaStream.Compression.Gorilla.{Encoder, NIF}
+
+  @feature "Prometheus transcoding"
+
+  @doc """
+  Re-encodes a chunk as one or more Prometheus XOR chunks.
+
+  ## Options
+
+  - `:samples_per_chunk` - maximum samples per XOR chunk (default 120, at most 65535)
+  - `:compression` - Container compression used (`:none`, `:zlib`, `:zstd`, `:auto`)
+
+  ## Returns
+
+  - `{:ok, [xor_chunk]}` on success
+  - `{:error, reason}` on failure
+  """
+  def to_xor_chunks(chunk, opts \\ [])
+
+  def to_xor_chunks(chunk, opts) when is_binary(chunk) do
+    with :ok <- NIF.ensure_loaded(@feature),
+         {:ok, encoded} <- Container.decompress(chunk, opts) do
+      nif_opts = opts |> Keyword.take([:samples_per_chunk]) |> Map.new()
+      NIF.call(@feature, fn -> NIF.nif_gorilla_to_prometheus(encoded, nif_opts) end)
+    end
+  end
+
+  def to_xor_chunks(_, _opts), do: {:error, "Invalid input data"}
+
+  @doc """
+  Merges consecutive Prometheus XOR chunks of one series into a single chunk.
+
+  Accepts the same encoder options as
+  `GorillaStream.Compression.Gorilla.Encoder.encode/2`. When a delta-of-delta
+  does not fit the fixed 32-bit bucket, the chunk uses `timestamp_codec: :adaptive`
+  instead.
+
+  ## Returns
+
+  - `{:ok, chunk}` on success
+  - `{:error, reason}` on failure
+  """
+  def from_xor_chunks(xor_chunks, opts \\ [])
+
+  def from_xor_chunks(xor_chunk, opts) when is_binary(xor_chunk),
+    do: from_xor_chunks([xor_chunk], opts)
+
+  def from_xor_chunks(xor_chunks, opts) when is_list(xor_chunks) do
+    with :ok <- NIF.ensure_loaded(@feature) do
+      nif_opts = Encoder.nif_options(opts)
+      NIF.call(@feature, fn -> NIF.nif_gorilla_from_prometheus(xor_chunks, nif_opts) end)
+    end
+  end
+
+  def from_xor_chunks(_, _opts), do: {:error, "Invalid input data"}
+end
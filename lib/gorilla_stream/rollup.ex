@@ -0,0 +1,127 @@
+defmodule GorillaStream.Rollup do
+  @moduledoc """
+  Rollup sidecars: min, max, sum, count and last value per aligned time window.
+
+  `GorillaStream.Compression.Gorilla.Encoder.encode/2` builds them with the
+  `rollups: [300, 3600]` option, in the same native call that encodes the chunk,
+  and returns one sidecar per window width. Stored next to the chunk, they let
+  long-range queries read 5-minute or hourly aggregates without decoding any
+  bitstreams.
+
+  Windows are in timestamp units and start at multiples of the width. Missing
+  (`nil`) points are left out. A sidecar is a binary (all fields big-endian):
+
+      magic   : 32   "GSR1"
+      window  : 64   width in timestamp units
+      buckets : 32
+      then per bucket, 44 bytes:
+        start : 64   signed
+        count : 32
+        min, max, sum, last : float-64 each
+
+  ## Examples
+
+      {:ok, chunk, %{3600 => hourly}} = Encoder.encode(points, rollups: [3600])
+      {:ok, %{window: 3600, buckets: [%{start: start, max: max} | _]}} =
+        GorillaStream.Rollup.decode(hourly)
+  """
+
+  @magic "GSR1"
+
+  @doc """
+  Builds the sidecar of `points` for one window width. This is the Elixir twin of
+  the native builder behind `Encoder.encode/2`, and gives the same bytes.
+
+  Points should be in ascending timestamp order; a new bucket starts whenever a
+  point falls in a different window than the one before.
+  """
+  def build(points, window) when is_list(points) and is_integer(window) and window > 0 do
+    buckets =
+      points
+      |> Enum.reject(&match?({_, nil}, &1))
+      |> Enum.chunk_by(fn {ts, _} -> window_start(ts, window) end)
+      |> Enum.map(&encode_bucket(&1, window))
+
+    IO.iodata_to_binary([<<@magic, window::64, length(buckets)::32>> | buckets])
+  end
+
+  @doc """
+  Reads a sidecar.
+
+  ## Returns
+  - `{:ok, %{window: window, buckets: [bucket]}}` - each bucket a map with
+    `:start`, `:count`, `:min`, `:max`, `:sum` and `:last`
+  - `{:error, reason}` - When the binary is not a sidecar
+  """
+  def decode(<<@magic, window::64, n::32, rest::binary>>) when byte_size(rest) == n * 44 do
+    buckets =
+      for <<start::signed-64, count::32, min::float-64, max::float-64, sum::float-64,
+            last::float-64 <- rest>> do
+        %{start: start, count: count, min: min, max: max, sum: sum, last: last}
+      end
+
+    {:ok, %{window: window, buckets: buckets}}
+  end
+
+  def decode(_), do: {:error, "Invalid rollup sidecar"}
+
+  @doc """
+  Combines the sidecars of consecutive chunks for one window width, merging the
+  buckets that a chunk boundary split. Sidecars must be given in time order.
+
+  ## Returns
+  - `{:ok, %{window: window, buckets: [bucket]}}`
+  - `{:error, reason}` - When a sidecar is invalid or the widths differ
+  """
+  def merge(sidecars) when is_list(sidecars) do
+    # Buckets are gathered newest first, so each sidecar only touches the
+    # accumulator's head, and reversed once at the end
+    Enum.reduce_while(sidecars, {:ok, nil}, fn sidecar, {:ok, acc} ->
+      case {decode(sidecar), acc} do
+        {{:ok, rollup}, nil} ->
+          {:cont, {:ok, %{rollup | buckets: Enum.reverse(rollup.buckets)}}}
+
+        {{:ok, %{window: window, buckets: buckets}}, %{window: window} = acc} ->
+          {:cont, {:ok, %{acc | buckets: prepend_buckets(acc.buckets, buckets)}}}
+
+        {{:ok, _}, _} ->
+          {:halt, {:error, "Rollup window widths differ"}}
+
+        {error, _} ->
+          {:halt, error}
+      end
+    end)
+    |> case do
+      {:ok, nil} -> {:error, "No rollup sidecars"}
+      {:ok, rollup} -> {:ok, %{rollup | buckets: Enum.reverse(rollup.buckets)}}
+      error -> error
+    end
+  end
+
+  # `reversed` is newest first; `next` is in time order
+  defp prepend_buckets([%{start: start} = last | init], [%{start: start} = first | rest]),
+    do: Enum.reverse(rest, [combine(last, first) | init])
+
+  defp prepend_buckets(reversed, next), do: Enum.reverse(next, reversed)
+
+  defp combine(a, b) do
+    %{
+      start: a.start,
+      count: a.count + b.count,
+      min: min(a.min, b.min),
+      max: max(a.max, b.max),
+      sum: a.sum + b.sum,
+      last: b.last
+    }
+  end
+
+  defp encode_bucket([{ts, _} | _] = points, window) do
+    values = Enum.map(points, fn {_, value} -> value * 1.0 end)
+    sum = Enum.reduce(values, 0.0, fn value, acc -> acc + value end)
+
+    <<window_start(ts, window)::signed-64, length(values)::32, Enum.min(values)::float-64,
+      Enum.max(values)::float-64, sum::float-64, List.last(values)::float-64>>
+  end
+
+  defp window_start(ts, window), do: ts - Integer.mod(ts, window)
+end
@@ -51,6 +51,11 @@ defmodule GorillaStream.Stream do
   - `:victoria_metrics` - Enable VictoriaMetrics preprocessing (default: true)
   - `:is_counter` - Treat data as counter (default: false)
   - `:scale_decimals` - Decimal scaling (`:auto` or integer)
+  - `:deterministic` - Fixed header creation time, so equal chunks are byte-identical
+  - `:content_hash` - Add the chunk's `Encoder.content_hash/1` to the metadata as
+    `:content_hash`, for deduplicating stored chunks (default: false)
+  - `:rollups` - Window widths, e.g. `[300, 3600]`; adds the chunk's
+    `GorillaStream.Rollup` sidecars to the metadata as `:rollups`, keyed by width
 
   ## Examples
 
@@ -64,12 +69,21 @@ defmodule GorillaStream.Stream do
     compression = Keyword.get(opts, :compression, :none)
 
     # Extract encoder options
-    encoder_opts = Keyword.take(opts, [:victoria_metrics, :is_counter, :scale_decimals])
+    encoder_opts =
+      Keyword.take(opts, [
+        :victoria_metrics,
+        :is_counter,
+        :scale_decimals,
+        :deterministic,
+        :rollups
+      ])
+
+    with_hash = Keyword.get(opts, :content_hash, false)
 
     data_stream
     |> Stream.chunk_every(chunk_size)
     |> Stream.map(fn chunk ->
-      with {:ok, gorilla_compressed} <- Encoder.encode(chunk, encoder_opts),
+      with {:ok, gorilla_compressed, rollups} <- encode_chunk(chunk, encoder_opts),
            {:ok, final_compressed} <-
              Container.compress(gorilla_compressed, compression: compression) do
         metadata = %{
@@ -80,11 +94,29 @@ defmodule GorillaStream.Stream do
           timestamp_range: get_timestamp_range(chunk)
         }
 
+        metadata = if rollups, do: Map.put(metadata, :rollups, rollups), else: metadata
+
+        metadata =
+          if with_hash do
+            {:ok, hash} = Encoder.content_hash(gorilla_compressed)
+            Map.put(metadata, :content_hash, hash)
+          else
+            metadata
+          end
+
         {:ok, final_compressed, metadata}
       end
     end)
   end
 
+  # Chunk and its rollup sidecars, or nil without the :rollups option
+  defp encode_chunk(chunk, encoder_opts) do
+    case Encoder.encode(chunk, encoder_opts) do
+      {:ok, encoded} -> {:ok, encoded, nil}
+      result -> result
+    end
+  end
+
   @doc """
   Decompresses a stream of compressed chunks.
 
@@ -0,0 +1,118 @@
+defmodule GorillaStream.Tensor do
+  @compile {:no_warn_undefined, Nx}
+
+  @moduledoc """
+  Optional Nx integration: decode Gorilla chunks straight into tensors.
+
+  The decoder writes timestamps and values into two native-endian binaries
+  (see `GorillaStream.Compression.Gorilla.Decoder.decode_columns/2`), which
+  `Nx.from_binary/2` wraps as `{:s, 64}` and `{:f, 64}` tensors. This skips the
+  usual decode-to-tuples, `Enum.unzip/1`, `Nx.tensor/1` round trip.
+
+  Requires the optional `nx` package.
+
+  ## Examples
+
+      {:ok, {timestamps, values}} = GorillaStream.Tensor.decode(compressed)
+
+      # Many chunks of equal length become one {chunks, points} tensor pair
+      {:ok, {timestamps, values}} = GorillaStream.Tensor.decode_batch(chunks)
+
+      # Chunks of different lengths can be concatenated instead
+      {:ok, {timestamps, values}} = GorillaStream.Tensor.decode_batch(chunks, layout: :concat)
+  """
+
+  alias GorillaStream.Compression.Gorilla.Decoder
+  alias GorillaStream.Compression.Container
+
+  @doc """
+  Checks if the Nx library is available at runtime.
+  """
+  @spec nx_available?() :: boolean()
+  def nx_available? do
+    Code.ensure_loaded?(Nx)
+  end
+
+  @doc """
+  Decodes one chunk into a `{timestamps, values}` pair of 1-D tensors.
+
+  ## Options
+
+  - `:compression` - Container compression used (`:none`, `:zlib`, `:zstd`, `:auto`)
+  - `:value_type` - `:f64` (default) or `:f32` for an `{:f, 32}` values tensor
+
+  ## Returns
+
+  - `{:ok, {timestamps_tensor, values_tensor}}` on success
+  - `{:error, reason}` on failure
+  """
+  def decode(compressed, opts \\ []) when is_binary(compressed) do
+    with :ok <- ensure_nx(),
+         {:ok, encoded} <- Container.decompress(compressed, opts),
+         {:ok, {ts_bin, val_bin}} <- Decoder.decode_columns(encoded, column_opts(opts)) do
+      {:ok, {Nx.from_binary(ts_bin, {:s, 64}), Nx.from_binary(val_bin, value_type(opts))}}
+    end
+  end
+
+  @doc """
+  Decodes many chunks into a single pair of tensors in one native call.
+
+  ## Options
+
+  - `:compression` - Container compression used (`:none`, `:zlib`, `:zstd`, `:auto`)
+  - `:value_type` - `:f64` (default) or `:f32` for an `{:f, 32}` values tensor
+  - `:layout` - `:stack` (default) returns `{chunks, points}` tensors and requires
+    every chunk to hold the same number of points; `:concat` returns 1-D tensors
+    with all chunks back to back
+
+  ## Returns
+
+  - `{:ok, {timestamps_tensor, values_tensor}}` on success
+  - `{:error, reason}` on failure
+  """
+  def decode_batch(chunks, opts \\ []) when is_list(chunks) do
+    layout = Keyword.get(opts, :layout, :stack)
+
+    with :ok <- ensure_nx(),
+         {:ok, encoded} <- Container.decompress_all(chunks, opts),
+         {:ok, {ts_bin, val_bin, counts}} <-
+           Decoder.decode_columns_batch(encoded, column_opts(opts)),
+         {:ok, shape} <- batch_shape(layout, counts) do
+      ts = ts_bin |> Nx.from_binary({:s, 64}) |> Nx.reshape(shape)
+      vals = val_bin |> Nx.from_binary(value_type(opts)) |> Nx.reshape(shape)
+      {:ok, {ts, vals}}
+    end
+  end
+
+  defp column_opts(opts), do: Keyword.take(opts, [:value_type])
+
+  defp value_type(opts) do
+    case Keyword.get(opts, :value_type, :f64) do
+      :f32 -> {:f, 32}
+      _ -> {:f, 64}
+    end
+  end
+
+  defp ensure_nx do
+    if nx_available?() do
+      :ok
+    else
+      {:error,
+       "Nx output requested but nx is not installed. Add {:nx, \"~> 0.9\"} to your dependencies."}
+    end
+  end
+
+  defp batch_shape(:concat, counts), do: {:ok, {Enum.sum(counts)}}
+
+  defp batch_shape(:stack, []), do: {:ok, {0, 0}}
+
+  defp batch_shape(:stack, [count | _] = counts) do
+    if Enum.all?(counts, &(&1 == count)) do
+      {:ok, {length(counts), count}}
+    else
+      {:error, "Cannot stack chunks with different point counts: #{inspect(Enum.uniq(counts))}"}
+    end
+  end
+
+  defp batch_shape(layout, _counts), do: {:error, "Unknown layout: #{inspect(layout)}"}
+end
@@ -58,6 +58,8 @@ defmodule GorillaStream.MixProject do
       {:ezstd, "~> 1.2", optional: true},
       # Optional OpenZL compression - format-aware compression extending zstd
       {:ex_openzl, "~> 0.4", optional: true},
+      # Optional Nx integration - decode straight into tensors
+      {:nx, "~> 0.9", optional: true},
       # NIF build support
       {:fine, "~> 0.1.4"},
       {:elixir_make, "~> 0.9", runtime: false},
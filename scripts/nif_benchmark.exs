@@ -39,7 +39,11 @@ datasets =
     {n, data}
   end
 
-IO.puts("=== Gorilla NIF vs Elixir Benchmark ===\n")
+IO.puts("=== Gorilla NIF vs Elixir Benchmark ===")
+
+# Tie the numbers to the build; compare a plain build against `make pgo`
+{:ok, info} = GorillaStream.nif_build_info()
+IO.puts("NIF: #{info.isa}, #{info.compiler}, pgo: #{info.pgo}\n")
 
 # Warm up NIF
 {:ok, _} = NIF.nif_gorilla_encode([{1, 1.0}], %{})
@@ -0,0 +1,55 @@
+#!/usr/bin/env elixir
+
+# Usage: make pgo   (runs this as: PGO=generate mix run --no-start scripts/pgo_training.exs)
+#
+# Training workload for the profile-guided NIF build. Exercises the native
+# encode/decode/transcode paths on every RealisticData profile across all
+# algorithms and VictoriaMetrics modes, so the branch profile matches real
+# series rather than synthetic sine waves.
+
+alias GorillaStream.Compression.Gorilla.{Encoder, Decoder}
+alias GorillaStream.Performance.RealisticData
+
+unless Encoder.nif_available?() do
+  raise "PGO training needs the instrumented NIF; build it with `make pgo`"
+end
+
+profiles = [
+  :temperature,
+  :industrial_sensor,
+  :server_metrics,
+  :stock_prices,
+  :vibration,
+  :mixed_patterns
+]
+
+algorithms = [:gorilla, :chimp, :chimp128]
+
+vm_modes = [
+  [victoria_metrics: false],
+  [victoria_metrics: true],
+  [victoria_metrics: true, is_counter: true]
+]
+
+sizes = [120, 1_000, 10_000]
+
+IO.puts("==> PGO training (#{inspect(GorillaStream.nif_build_info())})")
+
+for profile <- profiles, size <- sizes do
+  data = RealisticData.generate(size, profile, seed: {1, 2, 3})
+
+  chunks =
+    for algorithm <- algorithms, vm <- vm_modes do
+      opts = [algorithm: algorithm] ++ vm
+      {:ok, encoded} = Encoder.encode(data, opts)
+      {:ok, _} = Decoder.decode(encoded)
+      {:ok, _} = Decoder.decode_columns(encoded)
+      {:ok, _} = Encoder.transcode(encoded, algorithm: :chimp128)
+      encoded
+    end
+
+  {:ok, _} = Decoder.decode_columns_batch(chunks)
+  IO.puts("    #{profile} x #{size}")
+end
+
+IO.puts("==> Done")
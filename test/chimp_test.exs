@@ -220,5 +220,248 @@ defmodule GorillaStream.ChimpTest do
         assert decompressed == data, "Failed for algorithm: #{inspect(algo)}"
       end
     end
+
+    test "every window size round trips and is recorded in the header" do
+      # A 40-value cycle fits the larger windows but not the 32-value one
+      data = for i <- 0..599, do: {1_700_000_000 + i * 15, :math.sqrt(rem(i * 7, 40) + 2) * 10}
+
+      sizes =
+        for window <- [32, 64, 128, 256] do
+          {:ok, compressed} =
+            GorillaStream.compress(data, algorithm: :chimp128, chimp128_window: window)
+
+          assert {:ok, ^data} = GorillaStream.decompress(compressed)
+
+          assert {:ok, %{metadata: %{chimp128_window: ^window}}} =
+                   GorillaStream.Compression.Gorilla.Decoder.get_compression_info(compressed)
+
+          byte_size(compressed)
+        end
+
+      assert Enum.at(sizes, 1) < Enum.at(sizes, 0)
+    end
+
+    test "rejects unsupported window sizes" do
+      data = for i <- 0..9, do: {1_700_000_000 + i * 15, i * 1.5}
+
+      for window <- [0, 100, 512, 128.0] do
+        assert {:error, "chimp128_window must be 32, 64, 128 or 256"} =
+                 GorillaStream.Compression.Gorilla.Encoder.encode(data,
+                   algorithm: :chimp128,
+                   chimp128_window: window
+                 )
+      end
+    end
+  end
+
+  describe "value_type: :f32" do
+    alias GorillaStream.Compression.Gorilla.{Encoder, Decoder}
+
+    setup do
+      data = for i <- 0..499, do: {1_700_000_000 + i * 15, f32(45.0 + :math.sin(i / 10) * 15)}
+      {:ok, data: data}
+    end
+
+    test "round trips single-precision values with every algorithm", %{data: data} do
+      for algo <- [:gorilla, :chimp, :chimp128] do
+        {:ok, f64} = GorillaStream.compress(data, algorithm: algo)
+        {:ok, f32} = GorillaStream.compress(data, algorithm: algo, value_type: :f32)
+
+        assert <<_::binary-size(76), flags::32, _::binary>> = f32
+        assert Bitwise.band(flags, 0x10) == 0x10
+        assert byte_size(f32) < byte_size(f64) * 0.75, "no saving for #{algo}"
+        assert {:ok, ^data} = GorillaStream.decompress(f32)
+      end
+    end
+
+    test "rounds double inputs to single precision" do
+      data = for i <- 0..9, do: {1_700_000_000 + i, 0.1 * i}
+      {:ok, compressed} = GorillaStream.compress(data, value_type: :f32)
+
+      expected = for {ts, v} <- data, do: {ts, f32(v)}
+      assert {:ok, ^expected} = GorillaStream.decompress(compressed)
+    end
+
+    test "decodes into float32 columns", %{data: data} do
+      {:ok, encoded} = Encoder.encode(data, algorithm: :chimp, value_type: :f32)
+
+      assert {:ok, {ts_bin, val_bin}} = Decoder.decode_columns(encoded, value_type: :f32)
+      assert byte_size(ts_bin) == 500 * 8
+      assert byte_size(val_bin) == 500 * 4
+
+      values = for <<v::float-native-32 <- val_bin>>, do: v
+      assert values == Enum.map(data, &elem(&1, 1))
+    end
+
+    test "the Elixir decoder refuses float32 chunks", %{data: data} do
+      {:ok, encoded} = Encoder.encode(data, value_type: :f32)
+      assert {:error, reason} = Decoder.decode_elixir(encoded)
+      assert reason =~ "native decoder"
+    end
+  end
+
+  describe "entropy: :rans" do
+    alias GorillaStream.Compression.Gorilla.Decoder
+
+    setup do
+      data =
+        for i <- 0..1999 do
+          {1_700_000_000 + i * 15, Float.round(45.0 + :math.sin(i / 10) * 15, 2)}
+        end
+
+      {:ok, data: data}
+    end
+
+    test "shrinks long chunks with every algorithm and round trips", %{data: data} do
+      for algo <- [:gorilla, :chimp, :chimp128] do
+        {:ok, plain} = GorillaStream.compress(data, algorithm: algo)
+        {:ok, coded} = GorillaStream.compress(data, algorithm: algo, entropy: :rans)
+
+        assert byte_size(coded) < byte_size(plain), "no saving for #{algo}"
+        assert {:ok, ^data} = GorillaStream.decompress(coded)
+        assert {:ok, %{metadata: %{entropy: :rans}}} = Decoder.get_compression_info(coded)
+      end
+    end
+
+    test "short chunks stay plain when the side streams would not pay off", %{data: data} do
+      short = Enum.take(data, 20)
+      {:ok, coded} = GorillaStream.compress(short, entropy: :rans)
+
+      assert {:ok, %{metadata: %{entropy: :none}}} = Decoder.get_compression_info(coded)
+      assert {:ok, ^short} = GorillaStream.decompress(coded)
+    end
+
+    test "the Elixir decoder refuses rANS chunks", %{data: data} do
+      {:ok, coded} = GorillaStream.compress(data, entropy: :rans)
+      assert {:error, reason} = Decoder.decode_elixir(coded)
+      assert reason =~ "native decoder"
+    end
+  end
+
+  describe "algorithm: :fpc" do
+    alias GorillaStream.Compression.Gorilla.Decoder
+
+    test "round trips with every value type and entropy setting" do
+      data = for i <- 0..999, do: {1_700_000_000 + i * 15, f32(45.0 + :math.sin(i / 10) * 15)}
+
+      for opts <- [[], [value_type: :f32], [entropy: :rans], [value_type: :f32, entropy: :rans]] do
+        {:ok, compressed} = GorillaStream.compress(data, [algorithm: :fpc] ++ opts)
+
+        assert <<_::binary-size(76), flags::32, _::binary>> = compressed
+        assert Bitwise.band(flags, 0x2000) == 0x2000
+        assert {:ok, ^data} = GorillaStream.decompress(compressed), "failed for #{inspect(opts)}"
+      end
+    end
+
+    test "round trips short and extreme series" do
+      for data <- [
+            [{1_700_000_000, 42.5}],
+            [{1_700_000_000, 42.5}, {1_700_000_015, 43.1}],
+            [
+              {1_700_000_000, 1.7976931348623157e+308},
+              {1_700_000_015, -1.7976931348623157e+308},
+              {1_700_000_030, 5.0e-324},
+              {1_700_000_045, 0.0},
+              {1_700_000_060, -0.0}
+            ]
+          ] do
+        {:ok, compressed} = GorillaStream.compress(data, algorithm: :fpc)
+        assert {:ok, ^data} = GorillaStream.decompress(compressed)
+      end
+    end
+
+    test "beats Chimp on trending and periodic series" do
+      trend = for i <- 0..1999, do: {1_700_000_000 + i * 15, 100.0 + i * 0.37}
+      periodic = for i <- 0..1999, do: {1_700_000_000 + i * 15, rem(i, 24) * 1.25 + 3.1}
+
+      for data <- [trend, periodic] do
+        {:ok, chimp} = GorillaStream.compress(data, algorithm: :chimp, victoria_metrics: false)
+        {:ok, fpc} = GorillaStream.compress(data, algorithm: :fpc, victoria_metrics: false)
+
+        assert byte_size(fpc) < byte_size(chimp)
+        assert {:ok, ^data} = GorillaStream.decompress(fpc)
+      end
+    end
+
+    test "the Elixir decoder refuses FPC chunks" do
+      data = for i <- 0..99, do: {1_700_000_000 + i * 15, i * 1.5}
+      {:ok, compressed} = GorillaStream.compress(data, algorithm: :fpc)
+
+      assert {:error, reason} = Decoder.decode_elixir(compressed)
+      assert reason =~ "native decoder"
+    end
+  end
+
+  defp f32(x) do
+    <<v::float-32>> = <<x::float-32>>
+    v
+  end
+
+  describe "transcode" do
+    setup do
+      data =
+        for i <- 0..499 do
+          {1_700_000_000 + i * 15, Float.round(45.0 + :math.sin(i / 10) * 15, 2)}
+        end
+
+      {:ok, data: data}
+    end
+
+    test "re-encodes between all algorithms losslessly", %{data: data} do
+      {:ok, gorilla} = GorillaStream.compress(data)
+
+      for algo <- [:chimp, :chimp128, :gorilla] do
+        assert {:ok, transcoded} = GorillaStream.transcode(gorilla, algorithm: algo)
+        assert {:ok, ^data} = GorillaStream.decompress(transcoded)
+      end
+    end
+
+    test "matches compressing from scratch", %{data: data} do
+      {:ok, gorilla} = GorillaStream.compress(data)
+      {:ok, direct} = GorillaStream.compress(data, algorithm: :chimp128)
+
+      assert {:ok, transcoded} = GorillaStream.transcode(gorilla, algorithm: :chimp128)
+      assert byte_size(transcoded) == byte_size(direct)
+    end
+
+    test "values with long trailing-zero runs survive Chimp" do
+      data = for i <- 0..199, do: {1_700_000_000 + i * 15, 1024.0 + rem(i * 37, 64) * 0.5}
+      {:ok, gorilla} = GorillaStream.compress(data)
+
+      for algo <- [:chimp, :chimp128] do
+        {:ok, transcoded} = GorillaStream.transcode(gorilla, algorithm: algo)
+        assert {:ok, ^data} = GorillaStream.decompress(transcoded)
+      end
+    end
+
+    test "transcodes a list of chunks in parallel, keeping order", %{data: data} do
+      chunks =
+        data
+        |> Enum.chunk_every(50)
+        |> Enum.map(fn chunk -> elem(GorillaStream.compress(chunk), 1) end)
+
+      assert {:ok, transcoded} =
+               GorillaStream.transcode(chunks, algorithm: :chimp128, parallel: 4)
+
+      assert length(transcoded) == length(chunks)
+
+      decoded = Enum.flat_map(transcoded, fn c -> elem(GorillaStream.decompress(c), 1) end)
+      assert decoded == data
+    end
+
+    test "honours container compression", %{data: data} do
+      {:ok, zlib} = GorillaStream.compress(data, compression: :zlib)
+
+      assert {:ok, transcoded} =
+               GorillaStream.transcode(zlib, algorithm: :chimp, compression: :zlib)
+
+      assert {:ok, ^data} = GorillaStream.decompress(transcoded, compression: :zlib)
+    end
+
+    test "empty and invalid input" do
+      assert {:ok, <<>>} = GorillaStream.transcode(<<>>, algorithm: :chimp)
+      assert {:ok, []} = GorillaStream.transcode([], algorithm: :chimp)
+      assert {:error, _} = GorillaStream.transcode(<<1, 2, 3>>, algorithm: :chimp)
+    end
   end
 end
@@ -0,0 +1,91 @@
+defmodule GorillaStream.ArrowTest do
+  use ExUnit.Case, async: true
+
+  alias GorillaStream.Arrow
+  alias GorillaStream.Compression.Gorilla.{Encoder, Decoder}
+
+  @moduletag :nif
+
+  defp series(range) do
+    for i <- range, do: {1_700_000_000_000_000_000 + i * 1_000_000_000, 20.0 + :math.sin(i / 10)}
+  end
+
+  describe "to_ipc/2" do
+    test "writes a stream that starts with a continuation marker" do
+      {:ok, chunk} = Encoder.encode(series(0..99))
+
+      assert {:ok, <<0xFFFFFFFF::32, _::binary>> = ipc} = Arrow.to_ipc(chunk)
+      assert binary_part(ipc, byte_size(ipc) - 8, 8) == <<0xFFFFFFFF::32, 0::32>>
+    end
+
+    test "writes the file format with leading and trailing magic" do
+      {:ok, chunk} = Encoder.encode(series(0..99))
+
+      assert {:ok, <<"ARROW1", 0, 0, _::binary>> = ipc} = Arrow.to_ipc([chunk], format: :file)
+      assert binary_part(ipc, byte_size(ipc) - 6, 6) == "ARROW1"
+    end
+
+    test "returns an error for malformed chunks" do
+      assert {:error, _} = Arrow.to_ipc(["not a gorilla chunk"])
+    end
+  end
+
+  describe "round trip" do
+    test "one record batch per chunk, in order" do
+      data = [series(0..99), series(100..149), series(150..399)]
+      chunks = Enum.map(data, fn d -> elem(Encoder.encode(d), 1) end)
+
+      {:ok, ipc} = Arrow.to_ipc(chunks)
+      assert {:ok, imported} = Arrow.from_ipc(ipc)
+      assert length(imported) == 3
+
+      for {chunk, expected} <- Enum.zip(imported, data) do
+        assert {:ok, ^expected} = Decoder.decode(chunk)
+      end
+    end
+
+    test "file format and custom column names" do
+      data = series(0..63)
+      {:ok, chunk} = Encoder.encode(data)
+
+      {:ok, ipc} = Arrow.to_ipc(chunk, format: :file, timestamp_column: "ts", value_column: "cpu")
+
+      assert {:ok, [imported]} = Arrow.from_ipc(ipc, timestamp_column: "ts", value_column: "cpu")
+      assert {:ok, ^data} = Decoder.decode(imported)
+    end
+
+    test "VictoriaMetrics encoder options apply on import" do
+      data = for i <- 0..99, do: {1_700_000_000 + i * 15, 100.0 + i * 0.25}
+      {:ok, chunk} = Encoder.encode(data)
+      {:ok, ipc} = Arrow.to_ipc(chunk)
+
+      assert {:ok, [imported]} = Arrow.from_ipc(ipc, victoria_metrics: true)
+      assert {:ok, ^data} = Decoder.decode(imported)
+    end
+
+    test "nanosecond timestamps with gaps wider than 32 bits" do
+      # 15 s in ns overflows the fixed 32-bit delta bucket
+      data = for i <- 0..199, do: {1_700_000_000_000_000_000 + i * 15_000_000_000, i * 0.5}
+      {:ok, chunk} = Encoder.encode(data, timestamp_codec: :adaptive)
+      {:ok, ipc} = Arrow.to_ipc(chunk)
+
+      assert {:ok, [imported]} = Arrow.from_ipc(ipc)
+      assert {:ok, ^data} = Decoder.decode(imported)
+    end
+  end
+
+  describe "from_ipc/2" do
+    test "rejects unknown column names" do
+      {:ok, chunk} = Encoder.encode(series(0..9))
+      {:ok, ipc} = Arrow.to_ipc(chunk)
+
+      assert {:error, reason} = Arrow.from_ipc(ipc, value_column: "missing")
+      assert reason =~ "value column"
+    end
+
+    test "rejects data that is not Arrow IPC" do
+      assert {:error, _} = Arrow.from_ipc(<<1, 2, 3, 4, 5, 6, 7, 8>>)
+      assert {:error, "Invalid input data"} = Arrow.from_ipc(:not_binary)
+    end
+  end
+end
@@ -130,6 +130,25 @@ defmodule GorillaStream.Compression.ContainerTest do
     end
   end
 
+  describe "decompress_all/2" do
+    test "decompresses every binary in order" do
+      {:ok, a} = Container.compress(@test_data, compression: :zlib)
+      {:ok, b} = Container.compress(@small_data, compression: :zlib)
+
+      assert {:ok, [@test_data, @small_data]} =
+               Container.decompress_all([a, b], compression: :zlib)
+    end
+
+    test "stops at the first error" do
+      {:ok, a} = Container.compress(@test_data, compression: :zlib)
+
+      assert {:error, reason} =
+               Container.decompress_all([a, "not zlib data"], compression: :zlib)
+
+      assert reason =~ "Zlib decompression failed"
+    end
+  end
+
   describe "round-trip compression" do
     test "zlib round-trip preserves data" do
       {:ok, compressed} = Container.compress(@test_data, compression: :zlib)
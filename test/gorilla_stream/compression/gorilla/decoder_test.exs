@@ -1,6 +1,7 @@
 defmodule GorillaStream.Compression.Gorilla.DecoderTest do
   use ExUnit.Case, async: true
   alias GorillaStream.Compression.Gorilla.{Encoder, Decoder}
+  alias GorillaStream.Compression.Decoder.Metadata
 
   describe "decode/1" do
     test "handles empty data" do
@@ -1016,6 +1017,245 @@ defmodule GorillaStream.Compression.Gorilla.DecoderTest do
     end
   end
 
+  describe "decode/2 with :fields" do
+    setup do
+      data = for i <- 0..199, do: {1_609_459_200 + i * 15 + rem(i, 3), 20.0 + :math.sin(i / 8)}
+      {:ok, encoded} = Encoder.encode(data)
+      {:ok, data: data, encoded: encoded}
+    end
+
+    test "decodes only the timestamps", %{data: data, encoded: encoded} do
+      assert {:ok, timestamps} = Decoder.decode(encoded, fields: :timestamps)
+      assert timestamps == Enum.map(data, &elem(&1, 0))
+    end
+
+    test "decodes only the values", %{data: data, encoded: encoded} do
+      assert {:ok, values} = Decoder.decode(encoded, fields: :values)
+      assert values == Enum.map(data, &elem(&1, 1))
+    end
+
+    test ":all matches the default", %{encoded: encoded} do
+      assert Decoder.decode(encoded, fields: :all) == Decoder.decode(encoded)
+    end
+
+    test "single columns of entropy-coded and VM-scaled chunks" do
+      data = for i <- 0..999, do: {1_700_000_000 + i * 15, Float.round(45.0 + i / 7, 2)}
+
+      for opts <- [[entropy: :rans], [victoria_metrics: true], [algorithm: :chimp128]] do
+        {:ok, encoded} = Encoder.encode(data, opts)
+
+        assert {:ok, timestamps} = Decoder.decode(encoded, fields: :timestamps)
+        assert {:ok, values} = Decoder.decode(encoded, fields: :values)
+        assert Enum.zip(timestamps, values) == data, "failed for #{inspect(opts)}"
+      end
+    end
+
+    test "missing points of sparse chunks honour :missing" do
+      data = [{1_609_459_200, 1.0}, {1_609_459_260, nil}, {1_609_459_320, 3.0}]
+      {:ok, encoded} = Encoder.encode(data)
+
+      assert {:ok, [1.0, nil, 3.0]} = Decoder.decode(encoded, fields: :values)
+      assert {:ok, [1.0, :nan, 3.0]} = Decoder.decode(encoded, fields: :values, missing: :nan)
+
+      assert {:ok, [1_609_459_200, 1_609_459_260, 1_609_459_320]} =
+               Decoder.decode(encoded, fields: :timestamps, missing: :nan)
+    end
+
+    test "handles empty data" do
+      assert {:ok, []} = Decoder.decode(<<>>, fields: :values)
+    end
+
+    test "rejects unknown fields", %{encoded: encoded} do
+      assert {:error, reason} = Decoder.decode(encoded, fields: :value)
+      assert reason =~ ":fields"
+    end
+
+    test "is accepted by GorillaStream.decompress/2", %{data: data} do
+      {:ok, compressed} = GorillaStream.compress(data, compression: :zlib)
+
+      assert {:ok, timestamps} =
+               GorillaStream.decompress(compressed, compression: :zlib, fields: :timestamps)
+
+      assert timestamps == Enum.map(data, &elem(&1, 0))
+    end
+  end
+
+  describe "decode_columns/2" do
+    test "returns native-endian int64 and float64 columns" do
+      original_data = for i <- 0..99, do: {1_609_459_200 + i * 60, 20.0 + i / 4}
+
+      assert {:ok, encoded_data} = Encoder.encode(original_data)
+      assert {:ok, {ts_bin, val_bin}} = Decoder.decode_columns(encoded_data)
+
+      assert byte_size(ts_bin) == 100 * 8
+      assert byte_size(val_bin) == 100 * 8
+
+      timestamps = for <<ts::signed-native-64 <- ts_bin>>, do: ts
+      values = for <<val::float-native-64 <- val_bin>>, do: val
+
+      assert Enum.zip(timestamps, values) == original_data
+    end
+
+    test "narrows values to float32 on request" do
+      original_data = for i <- 0..9, do: {1_609_459_200 + i, i * 0.5}
+      {:ok, encoded_data} = Encoder.encode(original_data)
+
+      assert {:ok, {_ts_bin, val_bin}} = Decoder.decode_columns(encoded_data, value_type: :f32)
+
+      values = for <<val::float-native-32 <- val_bin>>, do: val
+      assert values == Enum.map(original_data, &elem(&1, 1))
+    end
+
+    test "handles empty data" do
+      assert {:ok, {<<>>, <<>>}} = Decoder.decode_columns(<<>>)
+    end
+
+    test "rejects non-binary input" do
+      assert {:error, _} = Decoder.decode_columns(:invalid)
+    end
+  end
+
+  describe "decode_columns_batch/2" do
+    test "concatenates chunks and reports per-chunk counts" do
+      chunk_a = for i <- 0..9, do: {1_609_459_200 + i, i * 1.5}
+      chunk_b = for i <- 10..14, do: {1_609_459_200 + i, i * 1.5}
+
+      {:ok, enc_a} = Encoder.encode(chunk_a)
+      {:ok, enc_b} = Encoder.encode(chunk_b)
+
+      assert {:ok, {ts_bin, val_bin, [10, 0, 5]}} =
+               Decoder.decode_columns_batch([enc_a, <<>>, enc_b])
+
+      timestamps = for <<ts::signed-native-64 <- ts_bin>>, do: ts
+      values = for <<val::float-native-64 <- val_bin>>, do: val
+
+      assert Enum.zip(timestamps, values) == chunk_a ++ chunk_b
+    end
+
+    test "rejects lists containing non-binaries" do
+      assert {:error, _} = Decoder.decode_columns_batch([<<>>, :invalid])
+    end
+  end
+
+  describe "scan_chunks/2" do
+    setup do
+      chunks =
+        for {start, n} <- [{0, 50}, {50, 1}, {51, 2}, {53, 120}] do
+          points = for i <- start..(start + n - 1), do: {1_700_000_000 + i * 15, i / 3}
+          {:ok, encoded} = Encoder.encode(points, checksum: if(n == 2, do: :xxh3, else: :crc32))
+          {encoded, points}
+        end
+
+      {:ok, chunks: chunks, blob: IO.iodata_to_binary(Enum.map(chunks, &elem(&1, 0)))}
+    end
+
+    test "indexes concatenated chunks from their headers", %{chunks: chunks, blob: blob} do
+      assert {:ok, index} = Decoder.scan_chunks(blob)
+
+      offsets = for <<v::signed-native-64 <- index.offsets>>, do: v
+      lengths = for <<v::signed-native-64 <- index.lengths>>, do: v
+      counts = for <<v::native-32 <- index.counts>>, do: v
+      firsts = for <<v::signed-native-64 <- index.first_timestamps>>, do: v
+
+      assert counts == Enum.map(chunks, fn {_, points} -> length(points) end)
+      assert firsts == Enum.map(chunks, fn {_, [{ts, _} | _]} -> ts end)
+      assert index.last_timestamps == nil
+      assert byte_size(index.flags) == 4 * length(chunks)
+
+      for {{encoded, _}, offset, length} <- Enum.zip([chunks, offsets, lengths]) do
+        assert binary_part(blob, offset, length) == encoded
+      end
+    end
+
+    test "fills in last timestamps on request", %{chunks: chunks, blob: blob} do
+      assert {:ok, %{last_timestamps: lasts}} = Decoder.scan_chunks(blob, last_timestamp: true)
+
+      assert (for <<v::signed-native-64 <- lasts>>, do: v) ==
+               Enum.map(chunks, fn {_, points} -> points |> List.last() |> elem(0) end)
+    end
+
+    test "last timestamps of two-point chunks with wide deltas" do
+      points = [{0, 1.0}, {5_000_000_000, 2.0}]
+
+      for codec <- [:block, :adaptive] do
+        {:ok, encoded} = Encoder.encode(points, timestamp_codec: codec)
+        assert {:ok, %{last_timestamps: lasts}} =
+                 Decoder.scan_chunks(encoded, last_timestamp: true)
+
+        assert <<5_000_000_000::signed-native-64>> == lasts
+      end
+    end
+
+    test "hashes chunk contents on request", %{chunks: chunks, blob: blob} do
+      assert {:ok, %{content_hashes: nil}} = Decoder.scan_chunks(blob)
+      assert {:ok, %{content_hashes: hashes}} = Decoder.scan_chunks(blob, content_hash: true)
+
+      assert hashes ==
+               IO.iodata_to_binary(
+                 for {encoded, _} <- chunks, do: elem(Encoder.content_hash(encoded), 1)
+               )
+    end
+
+    test "rejects truncated blobs", %{blob: blob} do
+      assert {:error, _} = Decoder.scan_chunks(binary_part(blob, 0, byte_size(blob) - 1))
+    end
+
+    test "an empty binary has an empty index" do
+      assert {:ok, %{counts: <<>>, offsets: <<>>}} = Decoder.scan_chunks(<<>>)
+    end
+  end
+
+  describe "get_compression_info/2" do
+    setup do
+      points = for i <- 0..99, do: {1_700_000_000 + i * 10, 20.0 + rem(i, 7) * 0.25}
+      {:ok, points: points}
+    end
+
+    test "matches the metadata parsed from the full header", %{points: points} do
+      for opts <- [
+             [],
+             [checksum: :xxh3],
+             [victoria_metrics: true, scale_decimals: 2],
+             [algorithm: :chimp128, chimp128_window: 64]
+           ] do
+        {:ok, encoded} = Encoder.encode(points, opts)
+        {metadata, payload} = Metadata.extract_metadata(encoded)
+
+        assert {:ok, info} = Decoder.get_compression_info(encoded)
+        assert info.metadata == metadata
+        assert info.count == 100
+        assert info.data_size == byte_size(payload)
+        assert info.metadata_size + info.data_size == info.total_size
+      end
+    end
+
+    test "flags corrupted payloads unless verification is off", %{points: points} do
+      {:ok, encoded} = Encoder.encode(points)
+      last = byte_size(encoded) - 1
+      <<head::binary-size(last), byte>> = encoded
+      corrupted = head <> <<Bitwise.bxor(byte, 0xFF)>>
+
+      assert {:ok, %{metadata: %{checksum_failed: true}}} =
+               Decoder.get_compression_info(corrupted)
+
+      assert {:ok, %{metadata: metadata}} =
+               Decoder.get_compression_info(corrupted, verify_checksum: false)
+
+      refute Map.has_key?(metadata, :checksum_failed)
+    end
+
+    test "reads a batch of chunks in order", %{points: points} do
+      {:ok, a} = Encoder.encode(points)
+      {:ok, b} = Encoder.encode(Enum.take(points, 3), checksum: :xxh3)
+
+      assert [{:ok, %{count: 100}}, {:ok, %{count: 3}}, {:ok, %{count: 0}}] =
+               Decoder.get_compression_info_batch([a, b, "not a chunk"])
+
+      assert Decoder.get_compression_info_batch([a, b]) ==
+               [Decoder.get_compression_info(a), Decoder.get_compression_info(b)]
+    end
+  end
+
   # Helper function to corrupt bytes in binary data
   defp corrupt_bytes(data, start_pos, length) do
     data_size = byte_size(data)
@@ -719,6 +719,286 @@ defmodule GorillaStream.Compression.Gorilla.EncoderTest do
     end
   end
 
+  describe "lossy mode" do
+    alias GorillaStream.Compression.Gorilla.Decoder
+
+    setup do
+      :rand.seed(:exsss, {8, 3, 1})
+
+      data =
+        for i <- 0..1999 do
+          {1_700_000_000 + i, 10.0 + :math.sin(i / 25) * 3 + :rand.normal() * 0.01}
+        end
+
+      {:ok, data: data}
+    end
+
+    @tag :nif
+    test "max_relative_error bounds every value and shrinks the output", %{data: data} do
+      {:ok, lossless} = Encoder.encode(data)
+      {:ok, lossy} = Encoder.encode(data, max_relative_error: 1.0e-6)
+
+      assert byte_size(lossy) * 2 < byte_size(lossless)
+      assert {:ok, decoded} = Decoder.decode(lossy)
+
+      for {{ts, v}, {ts2, v2}} <- Enum.zip(data, decoded) do
+        assert ts == ts2
+        assert abs(v - v2) <= abs(v) * 1.0e-6
+      end
+
+      assert {:ok, ^decoded} = Decoder.decode_elixir(lossy)
+    end
+
+    @tag :nif
+    test "records the kept mantissa width in the header", %{data: data} do
+      {:ok, lossy} = Encoder.encode(data, algorithm: :chimp, mantissa_bits: 16)
+
+      assert {:ok, %{metadata: %{mantissa_bits: 16}}} = Decoder.get_compression_info(lossy)
+      assert {:ok, decoded} = Decoder.decode(lossy)
+      assert length(decoded) == length(data)
+    end
+
+    test "lossless chunks report no mantissa rounding", %{data: data} do
+      {:ok, encoded} = Encoder.encode(data)
+      assert {:ok, %{metadata: %{mantissa_bits: nil}}} = Decoder.get_compression_info(encoded)
+    end
+
+    test "rejects out-of-range lossy settings instead of clamping them", %{data: data} do
+      for bits <- [-1, 53, 60, 16.0, :half] do
+        assert {:error, "mantissa_bits must be an integer from 0 to 52"} =
+                 Encoder.encode(data, mantissa_bits: bits)
+      end
+
+      for error <- [0, 1, 0.0, -1.0e-6, "1e-6"] do
+        assert {:error, "max_relative_error must be a positive float"} =
+                 Encoder.encode(data, max_relative_error: error)
+      end
+
+      assert {:error, _} = Encoder.encode_batch([1, 2], [[1.0, 2.0]], mantissa_bits: 60)
+    end
+  end
+
+  describe "sparse series" do
+    alias GorillaStream.Compression.Gorilla.Decoder
+
+    setup do
+      data =
+        for i <- 0..999 do
+          value = if rem(div(i, 40), 3) == 1 or rem(i, 17) == 0, do: nil, else: 20.0 + i / 100
+          {1_700_000_000 + i * 60, value}
+        end
+
+      {:ok, data: data}
+    end
+
+    @tag :nif
+    test "nil values round trip as missing points", %{data: data} do
+      for algorithm <- [:gorilla, :chimp, :chimp128] do
+        {:ok, encoded} = Encoder.encode(data, algorithm: algorithm, victoria_metrics: true)
+        assert {:ok, ^data} = Decoder.decode(encoded)
+      end
+    end
+
+    @tag :nif
+    test "missing points come back as the :missing value and as NaN columns", %{data: data} do
+      {:ok, encoded} = Encoder.encode(data)
+
+      {:ok, filled} = Decoder.decode(encoded, missing: :nan)
+      assert Enum.count(filled, &match?({_, :nan}, &1)) == Enum.count(data, &match?({_, nil}, &1))
+
+      {:ok, {ts_bin, val_bin}} = Decoder.decode_columns(encoded)
+      assert byte_size(ts_bin) == length(data) * 8
+
+      # NaN is not a BEAM float, so look for its all-ones exponent instead
+      words = for <<bits::64-native <- val_bin>>, do: bits
+
+      for {{_, value}, bits} <- Enum.zip(data, words) do
+        nan? = Bitwise.band(bits, 0x7FF0000000000000) == 0x7FF0000000000000
+        assert nan? == is_nil(value)
+      end
+    end
+
+    @tag :nif
+    test "gaps cost less than the values they replace", %{data: data} do
+      {:ok, sparse} = Encoder.encode(data, victoria_metrics: false)
+      dense = for {ts, v} <- data, do: {ts, v || 0.0}
+      {:ok, filled} = Encoder.encode(dense, victoria_metrics: false)
+
+      assert byte_size(sparse) < byte_size(filled)
+    end
+  end
+
+  describe "timestamp codec" do
+    alias GorillaStream.Compression.Gorilla.Decoder
+
+    setup do
+      :rand.seed(:exsss, {5, 9, 2})
+
+      {events, _} =
+        Enum.map_reduce(0..1999, 1_700_000_000_000, fn i, ts ->
+          ts = ts + 1_000 + :rand.uniform(400) - 200
+          {{ts, 20.0 + rem(i, 13) / 10}, ts}
+        end)
+
+      {:ok, events: events}
+    end
+
+    @tag :nif
+    test "block timestamps round trip and beat delta-of-delta on jittery series",
+         %{events: events} do
+      {:ok, dod} = Encoder.encode(events)
+      {:ok, block} = Encoder.encode(events, timestamp_codec: :block)
+
+      assert byte_size(block) < byte_size(dod)
+      assert {:ok, ^events} = Decoder.decode(block)
+
+      assert {:ok, %{metadata: %{timestamp_codec: :block}}} =
+               Decoder.get_compression_info(block)
+    end
+
+    @tag :nif
+    test "adaptive buckets shrink millisecond timestamps and decode in Elixir too" do
+      :rand.seed(:exsss, {7, 1, 3})
+
+      {points, _} =
+        Enum.map_reduce(0..1999, 1_700_000_000_000, fn i, ts ->
+          ts = ts + 1_000 + :rand.uniform(61) - 31
+          {{ts, i / 8}, ts}
+        end)
+
+      {:ok, fixed} = Encoder.encode(points)
+      {:ok, adaptive} = Encoder.encode(points, timestamp_codec: :adaptive)
+
+      assert byte_size(adaptive) < byte_size(fixed)
+
+      assert {:ok, %{metadata: %{timestamp_codec: :adaptive}}} =
+               Decoder.get_compression_info(adaptive)
+
+      assert {:ok, ^points} = Decoder.decode(adaptive)
+      assert {:ok, ^points} = Decoder.decode_elixir(adaptive)
+    end
+
+    test "delta-of-delta bucket edges round trip" do
+      edges = [63, 64, -64, -65, 255, 256, -256, -257, 2047, 2048, -2048, -2049]
+
+      for edge <- edges do
+        points = [{1000, 1.0}, {1000 + edge, 2.0}, {2000 + 2 * edge, 3.0}, {3000 + 2 * edge, 4.0}]
+
+        {:ok, encoded} = Encoder.encode_elixir(points, [])
+        assert {:ok, ^points} = Decoder.decode_elixir(encoded)
+      end
+    end
+
+    @tag :nif
+    test ":auto keeps bucketed delta-of-delta for regular series with occasional gaps" do
+      # One hour-long outage every 100 scrapes would widen every block
+      regular = for i <- 0..999, do: {1_700_000_000 + i * 15 + div(i, 100) * 3600, i / 4}
+
+      {:ok, encoded} = Encoder.encode(regular, timestamp_codec: :auto)
+
+      assert {:ok, %{metadata: %{timestamp_codec: :adaptive}}} =
+               Decoder.get_compression_info(encoded)
+
+      assert {:ok, ^regular} = Decoder.decode(encoded)
+      assert {:ok, ^regular} = Decoder.decode_elixir(encoded)
+    end
+
+    @tag :nif
+    test ":auto picks blocks for jittery series", %{events: events} do
+      {:ok, encoded} = Encoder.encode(events, timestamp_codec: :auto, algorithm: :chimp)
+
+      assert {:ok, %{metadata: %{timestamp_codec: :block}}} =
+               Decoder.get_compression_info(encoded)
+
+      assert {:ok, ^events} = Decoder.decode(encoded)
+    end
+  end
+
+  describe "encode_batch/3" do
+    alias GorillaStream.Compression.Gorilla.Decoder
+
+    setup do
+      timestamps = for i <- 0..599, do: 1_700_000_000 + i * 10
+
+      series =
+        for s <- 0..18 do
+          for i <- 0..599, do: Float.round(20.0 + s + :math.sin((i + s) / 25) * 5, rem(s, 4))
+        end
+
+      {:ok, timestamps: timestamps, series: series}
+    end
+
+    @tag :nif
+    test "each chunk decodes like the encode/2 chunk of its series",
+         %{timestamps: timestamps, series: series} do
+      for opts <- [[], [victoria_metrics: true], [value_type: :f32], [algorithm: :chimp]] do
+        {:ok, chunks} = Encoder.encode_batch(timestamps, series, opts)
+        assert length(chunks) == length(series)
+
+        for {chunk, values} <- Enum.zip(chunks, series) do
+          {:ok, single} = Encoder.encode(Enum.zip(timestamps, values), opts)
+          assert byte_size(chunk) == byte_size(single)
+          assert Decoder.decode(chunk) == Decoder.decode(single)
+        end
+      end
+    end
+
+    @tag :nif
+    test "series with missing points keep their gaps", %{timestamps: timestamps, series: series} do
+      sparse = series |> hd() |> List.replace_at(3, nil) |> List.replace_at(4, nil)
+      {:ok, [chunk, _]} = Encoder.encode_batch(timestamps, [sparse, hd(series)])
+
+      assert {:ok, decoded} = Decoder.decode(chunk)
+      assert Enum.map(decoded, &elem(&1, 1)) == sparse
+    end
+
+    test "rejects series that do not match the timestamps", %{timestamps: timestamps} do
+      assert {:error, _} = Encoder.encode_batch(timestamps, [[1.0, 2.0]])
+    end
+  end
+
+  describe "content_hash/1" do
+    setup do
+      {:ok, points: for(i <- 0..299, do: {1_700_000_000 + i * 15, 40.0 + rem(i, 11) * 0.5})}
+    end
+
+    test "deterministic chunks are byte-identical", %{points: points} do
+      {:ok, a} = Encoder.encode(points, deterministic: true)
+      {:ok, elixir} = Encoder.encode_elixir(points, deterministic: true)
+
+      assert <<_::binary-size(68), 0::64, _::binary>> = a
+      assert <<_::binary-size(68), 0::64, _::binary>> = elixir
+      assert {:ok, ^a} = Encoder.encode(points, deterministic: true)
+      assert {:ok, ^elixir} = Encoder.encode_elixir(points, deterministic: true)
+    end
+
+    test "ignores the creation time but not the data", %{points: points} do
+      {:ok, encoded} = Encoder.encode(points)
+      <<head::binary-size(68), _creation_time::64, tail::binary>> = encoded
+      rewritten = <<head::binary, 1_234::64, tail::binary>>
+
+      assert {:ok, <<_::128>> = hash} = Encoder.content_hash(encoded)
+      assert {:ok, ^hash} = Encoder.content_hash(rewritten)
+      assert {:ok, ^hash} = Encoder.content_hash(encoded <> "trailing")
+
+      {:ok, other} = Encoder.encode(List.replace_at(points, 150, {1_700_002_250, 41.25}))
+      refute Encoder.content_hash(other) == {:ok, hash}
+    end
+
+    test "hashes the bytes after the creation time with XXH3-128", %{points: points} do
+      {:ok, encoded} = Encoder.encode(points, checksum: :xxh3)
+      <<_::binary-size(76), hashed::binary>> = encoded
+
+      assert Encoder.content_hash(encoded) ==
+               {:ok, <<GorillaStream.Compression.XXH3.hash128(hashed)::128>>}
+    end
+
+    test "rejects data without a chunk header" do
+      assert {:error, _} = Encoder.content_hash(<<>>)
+      assert {:error, _} = Encoder.content_hash(:binary.copy(<<0>>, 100))
+    end
+  end
+
   describe "pipeline error handling" do
     test "returns error when timestamp encoding fails" do
       # This test is designed to cover the `rescue` block in `encode_timestamps/1`.
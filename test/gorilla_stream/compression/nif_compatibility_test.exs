@@ -11,6 +11,16 @@ defmodule GorillaStream.Compression.NifCompatibilityTest do
       assert Encoder.nif_available?()
       assert Decoder.nif_available?()
     end
+
+    test "build info reports the selected kernel variant" do
+      assert {:ok, %{isa: isa, variants: variants, compiler: compiler, pgo: pgo}} =
+               GorillaStream.nif_build_info()
+
+      assert "baseline" in variants
+      assert isa in variants
+      assert is_binary(compiler)
+      assert is_boolean(pgo)
+    end
   end
 
   describe "NIF encode round-trip" do
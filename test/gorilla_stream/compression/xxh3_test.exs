@@ -0,0 +1,84 @@
+defmodule GorillaStream.Compression.XXH3Test do
+  use ExUnit.Case, async: true
+
+  alias GorillaStream.Compression.XXH3
+  alias GorillaStream.Compression.Gorilla.{Decoder, Encoder}
+
+  # Reference XXH3_64bits values, one per length class of the algorithm
+  test "matches the reference hash across input lengths" do
+    assert XXH3.hash64("") == 3_244_421_341_483_603_138
+    assert XXH3.hash64("a") == 16_629_034_431_890_738_719
+    assert XXH3.hash64("abc") == 8_696_274_497_037_089_104
+    assert XXH3.hash64("12345678") == 7_125_428_314_086_190_838
+    assert XXH3.hash64("hello world") == 15_296_390_279_056_496_779
+
+    assert XXH3.hash64("GorillaStream xxh3 test vector, longer than sixteen bytes") ==
+             11_528_518_424_591_891_176
+
+    bytes = :binary.list_to_bin(Enum.to_list(0..255))
+    assert XXH3.hash64(binary_part(bytes, 0, 200)) == 17_594_024_861_627_254_531
+    assert XXH3.hash64(:binary.copy(bytes, 5)) == 5_207_480_625_629_771_054
+    assert XXH3.hash64(:binary.copy("gorilla", 300)) == 3_688_511_992_084_306_075
+  end
+
+  # Reference XXH3_128bits values over the same length classes
+  test "matches the reference 128-bit hash across input lengths" do
+    assert XXH3.hash128("") == 204_254_712_233_039_002_205_064_565_430_793_619_839
+    assert XXH3.hash128("a") == 225_219_434_562_328_483_135_862_406_050_043_285_023
+    assert XXH3.hash128("abc") == 8_891_052_093_862_885_505_146_213_044_715_469_136
+    assert XXH3.hash128("12345678") == 28_392_534_922_875_121_860_216_515_664_071_660_028
+    assert XXH3.hash128("hello world") == 297_150_157_938_599_054_391_163_723_952_090_887_879
+
+    assert XXH3.hash128("GorillaStream xxh3 test vector, longer than sixteen bytes") ==
+             279_075_643_846_402_431_685_153_084_129_578_325_394
+
+    bytes = :binary.list_to_bin(Enum.to_list(0..255))
+
+    assert XXH3.hash128(binary_part(bytes, 0, 100)) ==
+             290_550_204_630_428_521_271_595_155_003_564_539_934
+
+    assert XXH3.hash128(binary_part(bytes, 0, 200)) ==
+             269_851_885_998_063_220_703_434_104_245_590_809_077
+
+    assert XXH3.hash128(:binary.copy(bytes, 5)) ==
+             288_664_194_923_270_242_010_921_384_473_931_298_094
+
+    assert XXH3.hash128(:binary.copy("gorilla", 300)) ==
+             66_657_749_981_948_766_310_719_731_497_935_575_195
+  end
+
+  describe "checksum: :xxh3" do
+    setup do
+      data = for i <- 0..499, do: {1_700_000_000 + i * 10, 20.0 + rem(i, 13) * 0.25}
+      {:ok, data: data}
+    end
+
+    test "writes a version 2 header that both decoders verify", %{data: data} do
+      {:ok, encoded} = Encoder.encode_elixir(data, checksum: :xxh3)
+
+      assert <<_magic::64, 2::16, 88::16, _::binary>> = encoded
+      assert {:ok, %{metadata: %{checksum_type: :xxh3}}} = Decoder.get_compression_info(encoded)
+      assert {:ok, ^data} = Decoder.decode_elixir(encoded)
+      assert {:ok, ^data} = Decoder.decode(encoded)
+    end
+
+    test "a corrupted payload fails the decode", %{data: data} do
+      {:ok, encoded} = Encoder.encode_elixir(data, checksum: :xxh3)
+      <<header::binary-size(88), first, rest::binary>> = encoded
+      corrupted = <<header::binary, Bitwise.bxor(first, 1), rest::binary>>
+
+      assert {:error, "Checksum mismatch"} = Decoder.decode_elixir(corrupted)
+      assert {:error, _} = Decoder.decode(corrupted)
+    end
+
+    @tag :nif
+    test "native and Elixir encoders agree on the hash", %{data: data} do
+      {:ok, native} = Encoder.encode(data, checksum: :xxh3, victoria_metrics: true)
+      {:ok, elixir} = Encoder.encode_elixir(data, checksum: :xxh3, victoria_metrics: true)
+
+      assert <<_::binary-size(84), hash::64, _::binary>> = native
+      assert <<_::binary-size(84), ^hash::64, _::binary>> = elixir
+      assert {:ok, ^data} = Decoder.decode_elixir(native)
+    end
+  end
+end
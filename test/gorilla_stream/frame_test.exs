@@ -0,0 +1,79 @@
+defmodule GorillaStream.FrameTest do
+  use ExUnit.Case, async: true
+
+  alias GorillaStream.Frame
+
+  defp points(range), do: for(i <- range, do: {1_700_000_000 + i * 10, i / 4})
+
+  describe "encode/2 and decode/1" do
+    test "round trip chunks with and without metadata" do
+      {:ok, a} = GorillaStream.compress(points(0..99))
+      {:ok, b} = GorillaStream.compress(points(100..149))
+
+      wire = IO.iodata_to_binary([Frame.encode(a, %{series: "cpu"}), Frame.encode(b)])
+
+      assert {:ok, [{^a, %{series: "cpu"}}, {^b, nil}], <<>>} = Frame.decode(wire)
+    end
+
+    test "frames start with the magic, flags and chunk length" do
+      assert <<"GSF1", 0::32, 3::32, "abc">> = IO.iodata_to_binary(Frame.encode("abc"))
+      assert <<"GSF1", 1::32, 3::32, _meta_len::32, _::binary>> =
+               IO.iodata_to_binary(Frame.encode("abc", :meta))
+    end
+
+    test "returns a trailing partial frame as rest" do
+      wire = IO.iodata_to_binary([Frame.encode("first"), Frame.encode("second", [1, 2])])
+      partial = binary_part(wire, 0, byte_size(wire) - 3)
+      tail = binary_part(wire, 17, byte_size(partial) - 17)
+
+      assert {:ok, [{"first", nil}], ^tail} = Frame.decode(partial)
+    end
+
+    test "rejects data that is not a frame stream" do
+      assert {:error, _} = Frame.decode("not a frame stream")
+      assert {:error, _} = Frame.decode(<<"GSF1", 0x80::32, 0::32>>)
+    end
+
+    test "rejects corrupt metadata" do
+      assert {:error, "Invalid frame metadata"} =
+               Frame.decode(<<"GSF1", 1::32, 3::32, 2::32, 0xFF, 0xFF, "abc">>)
+    end
+  end
+
+  describe "streams" do
+    test "compress_stream output survives framing split across packets" do
+      data = points(0..999)
+
+      wire =
+        data
+        |> GorillaStream.Stream.compress_stream(chunk_size: 300)
+        |> Frame.encode_stream()
+        |> Enum.to_list()
+        |> IO.iodata_to_binary()
+
+      packets = for <<packet::binary-size(97) <- wire>>, do: packet
+      packets = packets ++ [binary_part(wire, 97 * length(packets), rem(byte_size(wire), 97))]
+
+      decoded =
+        packets
+        |> Frame.decode_stream()
+        |> GorillaStream.Stream.decompress_stream()
+        |> Enum.flat_map(fn {:ok, pts} -> pts end)
+
+      assert decoded == data
+    end
+
+    test "frames spread over single-byte packets" do
+      {:ok, a} = GorillaStream.compress(points(0..99))
+      {:ok, b} = GorillaStream.compress(points(100..149))
+      wire = IO.iodata_to_binary([Frame.encode(a, %{series: "cpu"}), Frame.encode(b)])
+
+      decoded =
+        for(<<byte::binary-size(1) <- wire>>, do: byte)
+        |> Frame.decode_stream()
+        |> Enum.to_list()
+
+      assert decoded == [{:ok, a, %{series: "cpu"}}, {:ok, b, %{}}]
+    end
+  end
+end
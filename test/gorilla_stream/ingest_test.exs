@@ -0,0 +1,209 @@
+defmodule GorillaStream.IngestTest do
+  use ExUnit.Case, async: true
+
+  alias GorillaStream.Ingest
+  alias GorillaStream.Compression.Gorilla.Decoder
+
+  import Bitwise
+
+  @moduletag :nif
+
+  defp decoded(chunk) do
+    {:ok, points} = Decoder.decode(chunk)
+    points
+  end
+
+  # Protobuf and snappy encoders just big enough to build remote_write bodies
+  defp varint(n) when n < 0x80, do: <<n>>
+  defp varint(n), do: <<0x80 ||| (n &&& 0x7F)>> <> varint(n >>> 7)
+
+  defp field(num, bytes), do: varint(num <<< 3 ||| 2) <> varint(byte_size(bytes)) <> bytes
+
+  defp label({name, value}), do: field(1, field(1, name) <> field(2, value))
+
+  defp sample({ts, value}) do
+    <<unsigned_ts::unsigned-64>> = <<ts::signed-64>>
+    field(2, <<0x09, value::float-little-64, 0x10>> <> varint(unsigned_ts))
+  end
+
+  defp timeseries(labels, samples) do
+    field(1, Enum.map_join(labels, &label/1) <> Enum.map_join(samples, &sample/1))
+  end
+
+  # Snappy block made only of literals, which is a valid encoding of any input
+  defp snappy(data) do
+    literals =
+      data
+      |> :binary.bin_to_list()
+      |> Enum.chunk_every(60)
+      |> Enum.map_join(fn bytes ->
+        <<(length(bytes) - 1) <<< 2>> <> :binary.list_to_bin(bytes)
+      end)
+
+    varint(byte_size(data)) <> literals
+  end
+
+  describe "line_protocol/2" do
+    test "splits series by key and field" do
+      text = """
+      # agent output
+      cpu,host=a,region=us\\ west usage=1.5,idle=98i,up=t,msg="a, \\"b\\"" 1000
+      cpu,host=b usage=2.5 1000
+
+      cpu,host=a,region=us\\ west usage=1.75,idle=97i,up=false 2000
+      """
+
+      assert {:ok, series} = Ingest.line_protocol(text)
+
+      assert Enum.map(series, fn {key, field, _} -> {key, field} end) == [
+               {"cpu,host=a,region=us\\ west", "usage"},
+               {"cpu,host=a,region=us\\ west", "idle"},
+               {"cpu,host=a,region=us\\ west", "up"},
+               {"cpu,host=b", "usage"}
+             ]
+
+      [{_, _, usage}, {_, _, idle}, {_, _, up}, {_, _, usage_b}] = series
+      assert decoded(usage) == [{1000, 1.5}, {2000, 1.75}]
+      assert decoded(idle) == [{1000, 98.0}, {2000, 97.0}]
+      assert decoded(up) == [{1000, 1.0}, {2000, 0.0}]
+      assert decoded(usage_b) == [{1000, 2.5}]
+    end
+
+    test "accepts CRLF line endings and a missing final newline" do
+      text = "m v=1 10\r\nm v=2 20"
+
+      assert {:ok, [{"m", "v", chunk}]} = Ingest.line_protocol(text)
+      assert decoded(chunk) == [{10, 1.0}, {20, 2.0}]
+    end
+
+    test "applies encoder options to every series" do
+      text = Enum.map_join(0..99, fn i -> "m a=#{i * 0.5},b=#{i}i #{1000 + i * 15}\n" end)
+
+      assert {:ok, [{_, "a", a}, {_, "b", _}]} =
+               Ingest.line_protocol(text, algorithm: :chimp128)
+
+      assert length(decoded(a)) == 100
+    end
+
+    test "keeps nanosecond timestamps with gaps wider than 32 bits" do
+      # Line protocol defaults to ns; 10 s gaps overflow the fixed delta bucket
+      points = for i <- 0..99, do: {1_700_000_000_000_000_000 + i * 10_000_000_000, i * 0.25}
+      text = Enum.map_join(points, fn {ts, v} -> "cpu,host=a usage=#{v} #{ts}\n" end)
+
+      assert {:ok, [{"cpu,host=a", "usage", chunk}]} = Ingest.line_protocol(text)
+      assert decoded(chunk) == points
+    end
+
+    test "reports the offending line" do
+      assert {:error, reason} = Ingest.line_protocol("m v=1 10\nm v=oops 20\n")
+      assert reason =~ "line 2"
+
+      assert {:error, reason} = Ingest.line_protocol("m v=1\n")
+      assert reason =~ "timestamp"
+    end
+  end
+
+  describe "csv/2" do
+    test "groups by series column and names fields by header" do
+      text = """
+      time,host,cpu,mem,note
+      1000,a,1.5,20,x
+      1000,b,2.5,,"y, z"
+      2000,a,1.75,21,"q""r"
+      """
+
+      assert {:ok, series} = Ingest.csv(text, series_column: "host")
+
+      assert [{"a", "cpu", cpu_a}, {"a", "mem", mem_a}, {"b", "cpu", cpu_b}] = series
+      assert decoded(cpu_a) == [{1000, 1.5}, {2000, 1.75}]
+      assert decoded(mem_a) == [{1000, 20.0}, {2000, 21.0}]
+      assert decoded(cpu_b) == [{1000, 2.5}]
+    end
+
+    test "selects columns by name or index" do
+      text = "v,ts,w\n1.0,10,5\n2.0,20,6\n"
+
+      assert {:ok, [{"", "v", chunk}]} =
+               Ingest.csv(text, timestamp_column: 1, value_columns: ["v"])
+      assert decoded(chunk) == [{10, 1.0}, {20, 2.0}]
+    end
+
+    test "headerless input with a custom delimiter uses column indexes" do
+      text = "1;2.5;3\n2;2.5;4\n"
+
+      assert {:ok, [{"", 1, one}, {"", 2, two}]} = Ingest.csv(text, header: false, delimiter: ";")
+      assert decoded(one) == [{1, 2.5}, {2, 2.5}]
+      assert decoded(two) == [{1, 3.0}, {2, 4.0}]
+    end
+
+    test "keeps nanosecond timestamps with gaps wider than 32 bits" do
+      points = for i <- 0..49, do: {1_700_000_000_000_000_000 + i * 60_000_000_000, 1.5 + i}
+      text = "time,v\n" <> Enum.map_join(points, fn {ts, v} -> "#{ts},#{v}\n" end)
+
+      assert {:ok, [{"", "v", chunk}]} = Ingest.csv(text)
+      assert decoded(chunk) == points
+    end
+
+    test "unknown columns and bad timestamps are errors" do
+      assert {:error, reason} = Ingest.csv("t,v\n1,2\n", value_columns: ["nope"])
+      assert reason =~ "nope"
+
+      assert {:error, reason} = Ingest.csv("t,v\n1,2\nx,3\n")
+      assert reason =~ "line 3"
+    end
+  end
+
+  describe "remote_write/2" do
+    test "groups samples by label set" do
+      body =
+        timeseries([{"__name__", "up"}, {"job", "a"}], [{1000, 1.0}, {2000, 1.0}]) <>
+          timeseries([{"job", "b"}, {"__name__", "up"}], [{1000, 0.0}]) <>
+          timeseries([{"job", "a"}, {"__name__", "up"}], [{3000, 0.5}])
+
+      assert {:ok, [{labels_a, chunk_a}, {labels_b, chunk_b}]} =
+               Ingest.remote_write(snappy(body))
+
+      assert labels_a == [{"__name__", "up"}, {"job", "a"}]
+      assert labels_b == [{"__name__", "up"}, {"job", "b"}]
+      assert decoded(chunk_a) == [{1000, 1.0}, {2000, 1.0}, {3000, 0.5}]
+      assert decoded(chunk_b) == [{1000, 0.0}]
+    end
+
+    test "accepts an uncompressed body and negative timestamps" do
+      body = timeseries([{"__name__", "t"}], [{-5, 2.5}])
+
+      assert {:ok, [{[{"__name__", "t"}], chunk}]} = Ingest.remote_write(body, snappy: false)
+      assert decoded(chunk) == [{-5, 2.5}]
+    end
+
+    test "keeps millisecond gaps wider than 32 bits" do
+      # 30 days in ms overflows the fixed delta bucket
+      samples = for i <- 0..3, do: {1_700_000_000_000 + i * 2_592_000_000 + i, i * 1.0}
+      body = timeseries([{"__name__", "backup_age"}], samples)
+
+      assert {:ok, [{_, chunk}]} = Ingest.remote_write(snappy(body))
+      assert decoded(chunk) == samples
+    end
+
+    test "decodes snappy back-references" do
+      ts = timeseries([{"__name__", "up"}], [{1000, 1.0}])
+      n = byte_size(ts)
+
+      # Literal timeseries followed by a 2-byte-offset copy of itself
+      body = varint(2 * n) <> <<(n - 1) <<< 2>> <> ts <> <<2 ||| (n - 1) <<< 2, n, 0>>
+
+      assert {:ok, [{_, chunk}]} = Ingest.remote_write(body)
+      assert decoded(chunk) == [{1000, 1.0}, {1000, 1.0}]
+    end
+
+    test "rejects corrupt or oversized bodies" do
+      body = snappy(timeseries([{"__name__", "up"}], [{1, 1.0}]))
+
+      assert {:error, reason} = Ingest.remote_write(binary_part(body, 0, byte_size(body) - 3))
+      assert reason =~ "snappy"
+
+      assert {:error, reason} = Ingest.remote_write(body, max_size: 4)
+      assert reason =~ "limit"
+    end
+  end
+end
@@ -0,0 +1,83 @@
+defmodule GorillaStream.PrometheusTest do
+  use ExUnit.Case, async: true
+
+  alias GorillaStream.Prometheus
+  alias GorillaStream.Compression.Gorilla.{Encoder, Decoder}
+
+  @moduletag :nif
+
+  defp series(range) do
+    for i <- range, do: {1_700_000_000_000 + i * 15_000 + rem(i * i, 7), 20.0 + :math.sin(i / 10)}
+  end
+
+  describe "to_xor_chunks/2" do
+    test "writes Prometheus framing for a single sample" do
+      {:ok, chunk} = Encoder.encode([{1000, 1.0}])
+
+      # count, varint(1000), float64 bits of 1.0
+      assert {:ok, [<<0, 1, 0xD0, 0x0F, 0x3F, 0xF0, 0, 0, 0, 0, 0, 0>>]} =
+               Prometheus.to_xor_chunks(chunk)
+    end
+
+    test "second sample uses an unsigned varint delta" do
+      {:ok, chunk} = Encoder.encode([{1000, 1.0}, {1015, 1.0}])
+
+      assert {:ok, [<<0, 2, 0xD0, 0x0F, _::binary-size(8), 0x0F, 0x00>>]} =
+               Prometheus.to_xor_chunks(chunk)
+    end
+
+    test "splits into chunks of samples_per_chunk" do
+      {:ok, chunk} = Encoder.encode(series(0..299))
+
+      assert {:ok, xor_chunks} = Prometheus.to_xor_chunks(chunk)
+      assert Enum.map(xor_chunks, fn <<count::16, _::binary>> -> count end) == [120, 120, 60]
+
+      assert {:ok, [<<300::16, _::binary>>]} =
+               Prometheus.to_xor_chunks(chunk, samples_per_chunk: 1000)
+    end
+
+    test "empty input gives no chunks" do
+      assert {:ok, []} = Prometheus.to_xor_chunks(<<>>)
+    end
+  end
+
+  describe "round trip" do
+    test "is lossless across chunk boundaries" do
+      data = series(0..499)
+      {:ok, chunk} = Encoder.encode(data)
+
+      {:ok, xor_chunks} = Prometheus.to_xor_chunks(chunk)
+      assert {:ok, merged} = Prometheus.from_xor_chunks(xor_chunks)
+      assert {:ok, ^data} = Decoder.decode(merged)
+    end
+
+    test "preserves staleness markers bit for bit" do
+      # {1000, 1.5}, {1015, stale NaN} as Prometheus writes it
+      xor_chunk =
+        <<0, 2, 0xD0, 0x0F, 1.5::float-64, 0x0F, 0xC3, 0xF4, 0x00, 0x80, 0, 0, 0, 0, 0, 0x20>>
+
+      {:ok, chunk} = Prometheus.from_xor_chunks(xor_chunk)
+      assert {:ok, [^xor_chunk]} = Prometheus.to_xor_chunks(chunk)
+    end
+  end
+
+  describe "from_xor_chunks/2" do
+    test "rejects truncated chunks" do
+      assert {:error, _} = Prometheus.from_xor_chunks([<<0, 5, 1>>])
+      assert {:error, "Invalid input data"} = Prometheus.from_xor_chunks(:not_binary)
+    end
+
+    test "keeps gaps wider than the fixed delta-of-delta buckets" do
+      # 30-day gaps in ms overflow a 32-bit delta
+      data = for i <- 0..3, do: {1_700_000_000_000 + i * 2_592_000_000 + i, i * 1.0}
+      {:ok, chunk} = Encoder.encode(data, timestamp_codec: :adaptive)
+      {:ok, xor_chunks} = Prometheus.to_xor_chunks(chunk)
+
+      assert {:ok, merged} = Prometheus.from_xor_chunks(xor_chunks)
+      assert {:ok, ^data} = Decoder.decode(merged)
+
+      assert {:ok, blocks} = Prometheus.from_xor_chunks(xor_chunks, timestamp_codec: :block)
+      assert {:ok, ^data} = Decoder.decode(blocks)
+    end
+  end
+end
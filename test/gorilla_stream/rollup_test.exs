@@ -0,0 +1,99 @@
+defmodule GorillaStream.RollupTest do
+  use ExUnit.Case, async: true
+
+  alias GorillaStream.Rollup
+  alias GorillaStream.Compression.Gorilla.{Decoder, Encoder}
+
+  # One point a minute, starting mid-window
+  defp points(range), do: for(i <- range, do: {1_700_000_040 + i * 60, 10.0 + rem(i, 7)})
+
+  describe "encode/2 with :rollups" do
+    test "returns the chunk and one sidecar per window width" do
+      data = points(0..199)
+
+      assert {:ok, chunk, %{300 => five_min, 3600 => hourly}} =
+               Encoder.encode(data, rollups: [300, 3600])
+
+      assert {:ok, ^data} = Decoder.decode(chunk)
+      assert five_min == Rollup.build(data, 300)
+      assert hourly == Rollup.build(data, 3600)
+    end
+
+    test "aggregates each aligned window" do
+      {:ok, _chunk, %{300 => sidecar}} = Encoder.encode(points(0..9), rollups: [300])
+
+      assert {:ok, %{window: 300, buckets: [first, second, third]}} = Rollup.decode(sidecar)
+
+      # 1_700_000_040 lies 240 s into a window starting at 1_699_999_800
+      assert %{start: 1_699_999_800, count: 1, min: 10.0, max: 10.0, sum: 10.0, last: 10.0} =
+               first
+
+      assert %{start: 1_700_000_100, count: 5, min: 11.0, max: 15.0, sum: 65.0, last: 15.0} =
+               second
+
+      assert %{start: 1_700_000_400, count: 4, min: 10.0, max: 16.0, sum: 49.0, last: 12.0} =
+               third
+    end
+
+    @tag :nif
+    test "leaves missing points out" do
+      data = [{0, 1.0}, {10, nil}, {20, 3.0}, {400, nil}]
+
+      assert {:ok, _chunk, %{300 => sidecar}} = Encoder.encode(data, rollups: [300])
+      assert sidecar == Rollup.build(data, 300)
+
+      assert {:ok, %{buckets: [%{start: 0, count: 2, sum: 4.0, last: 3.0}]}} =
+               Rollup.decode(sidecar)
+    end
+
+    test "handles empty input and rejects bad widths" do
+      assert {:ok, <<>>, %{60 => sidecar}} = Encoder.encode([], rollups: [60])
+      assert {:ok, %{window: 60, buckets: []}} = Rollup.decode(sidecar)
+
+      assert {:error, _} = Encoder.encode(points(0..9), rollups: [0])
+      assert {:error, _} = Encoder.encode(points(0..9), rollups: :hourly)
+    end
+  end
+
+  describe "merge/1" do
+    test "joins buckets split across chunks" do
+      data = points(0..199)
+      {left, right} = Enum.split(data, 90)
+
+      sidecars =
+        for part <- [left, right] do
+          {:ok, _chunk, %{3600 => sidecar}} = Encoder.encode(part, rollups: [3600])
+          sidecar
+        end
+
+      assert Rollup.merge(sidecars) == Rollup.decode(Rollup.build(data, 3600))
+    end
+
+    test "joins many sidecars in order" do
+      data = points(0..499)
+      sidecars = for part <- Enum.chunk_every(data, 17), do: Rollup.build(part, 600)
+
+      assert Rollup.merge(sidecars) == Rollup.decode(Rollup.build(data, 600))
+    end
+
+    test "rejects mixed widths" do
+      assert {:error, _} = Rollup.merge([Rollup.build(points(0..9), 300), Rollup.build([], 60)])
+      assert {:error, _} = Rollup.merge(["not a sidecar"])
+    end
+  end
+
+  test "compress_stream/2 adds the sidecars to the chunk metadata" do
+    chunks =
+      points(0..249)
+      |> GorillaStream.Stream.compress_stream(chunk_size: 100, rollups: [600])
+      |> Enum.to_list()
+
+    assert length(chunks) == 3
+    assert Enum.all?(chunks, &match?({:ok, _, %{rollups: %{600 => <<"GSR1", _::binary>>}}}, &1))
+  end
+
+  test "compress/2 rejects :rollups instead of dropping it" do
+    assert {:error, reason} = GorillaStream.compress(points(0..9), rollups: [600])
+    assert reason =~ "Encoder.encode/2"
+  end
+end
@@ -0,0 +1,60 @@
+defmodule GorillaStream.TensorTest do
+  use ExUnit.Case, async: true
+
+  alias GorillaStream.Compression.Gorilla.Encoder
+  alias GorillaStream.Tensor
+
+  @moduletag :nx
+
+  defp series(range) do
+    for i <- range, do: {1_700_000_000 + i * 15, 20.0 + :math.sin(i / 10)}
+  end
+
+  describe "decode/2" do
+    test "returns s64 timestamps and f64 values" do
+      data = series(0..99)
+      {:ok, encoded} = Encoder.encode(data)
+
+      assert {:ok, {ts, vals}} = Tensor.decode(encoded)
+      assert Nx.type(ts) == {:s, 64}
+      assert Nx.type(vals) == {:f, 64}
+      assert Nx.shape(ts) == {100}
+
+      {expected_ts, expected_vals} = Enum.unzip(data)
+      assert Nx.to_flat_list(ts) == expected_ts
+      assert Nx.to_flat_list(vals) == expected_vals
+    end
+
+    test "honours container compression" do
+      data = series(0..49)
+      {:ok, compressed} = GorillaStream.compress(data, compression: :zlib)
+
+      assert {:ok, {ts, _vals}} = Tensor.decode(compressed, compression: :zlib)
+      assert Nx.shape(ts) == {50}
+    end
+  end
+
+  describe "decode_batch/2" do
+    test "stacks equal-length chunks" do
+      chunks =
+        for start <- [0, 100, 200] do
+          {:ok, encoded} = Encoder.encode(series(start..(start + 99)))
+          encoded
+        end
+
+      assert {:ok, {ts, vals}} = Tensor.decode_batch(chunks)
+      assert Nx.shape(ts) == {3, 100}
+      assert Nx.shape(vals) == {3, 100}
+      assert Nx.to_number(ts[[1, 0]]) == 1_700_000_000 + 100 * 15
+    end
+
+    test "refuses to stack chunks of different lengths" do
+      {:ok, a} = Encoder.encode(series(0..9))
+      {:ok, b} = Encoder.encode(series(10..14))
+
+      assert {:error, _} = Tensor.decode_batch([a, b])
+      assert {:ok, {ts, _vals}} = Tensor.decode_batch([a, b], layout: :concat)
+      assert Nx.shape(ts) == {15}
+    end
+  end
+end
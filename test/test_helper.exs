@@ -1,5 +1,6 @@
 exclude =
   unless(Code.ensure_loaded?(ExOpenzl), do: [:openzl], else: []) ++
+    unless(Code.ensure_loaded?(Nx), do: [:nx], else: []) ++
     if(System.get_env("CI"), do: [:skip_ci], else: [])
 
 ExUnit.start(